@@ -257,6 +257,8 @@ component Replica1_CORE is
         ext_ram_data    : in     std_logic_vector(7  downto 0);
         ext_tram_cs_n   : out    std_logic;		 
         ext_tram_data   : in     std_logic_vector(7  downto 0);
+        ext_io_cs_n     : out    std_logic;                              -- C240-C2FF board peripherals (bist...)
+        ext_io_data     : in     std_logic_vector(7  downto 0) := (others => '1');
         uart_rx         : in     std_logic;
         uart_tx         : out    std_logic;
         spi_cs          : out    std_logic;
@@ -277,9 +279,14 @@ component sdram_controller is
         TRP_NS             : integer := 20;   -- Precharge time (for PRECHARGE wait)
         TRCD_NS            : integer := 20;   -- RAS to CAS delay (for ACTIVE→READ/WRITE)
         TRFC_NS            : integer := 70;   -- Refresh cycle time (for AUTO REFRESH wait)
+        TRAS_NS            : integer := 42;   -- Row active time (ACTIVE→PRECHARGE, same bank)
+        TRRD_NS            : integer := 14;   -- ACTIVE to ACTIVE, different banks
+        MAX_REFRESH_DEBT   : integer := 8;    -- refreshes that may be postponed (JEDEC: 8)
+        ADDR_MAPPING       : string  := "BANK_ROW_COL"; -- "BANK_ROW_COL", "ROW_BANK_COL" or "ROW_BANK_XOR"
         CAS_LATENCY        : integer := 2;    -- CAS Latency: 2 or 3 cycles
         USE_AUTO_PRECHARGE : boolean := true; -- true = READA/WRITEA false = READ/WRITE
-        USE_AUTO_REFRESH   : boolean := true  -- true = autorefresh, false = triggered refresh
+        USE_AUTO_REFRESH   : boolean := true; -- true = autorefresh, false = triggered refresh
+        BURST_LENGTH       : integer := 1     -- Read burst length: 1, 4 or 8
     );
     port(
         clk            : in    std_logic;  
@@ -292,10 +299,20 @@ component sdram_controller is
         din            : in    std_logic_vector(15 downto 0);
         dout           : out   std_logic_vector(15 downto 0);
         byte_en        : in    std_logic_vector(1 downto 0); 
+        burst          : in    std_logic := '0';
+        rd_delay       : in    unsigned(1 downto 0) := "00";
+        next_req       : in    std_logic := '0';
+        next_addr      : in    std_logic_vector(ROW_BITS+COL_BITS+1 downto 0) := (others => '0');
         ready          : out   std_logic;
         ack            : out   std_logic;
+        dvalid         : out   std_logic;
         refresh_req    : in    std_logic;
+        refresh_ok     : in    std_logic := '1';
+        quiet_cycles   : in    unsigned(7 downto 0) := (others => '1');
         refresh_active : out   std_logic;
+        ev_activate    : out   std_logic;
+        ev_row_hit     : out   std_logic;
+        ev_refresh     : out   std_logic;
         
         -- SDRAM pins
         sdram_clk      : out   std_logic;
@@ -305,38 +322,149 @@ component sdram_controller is
         sdram_cas_n    : out   std_logic;
         sdram_we_n     : out   std_logic;
         sdram_ba       : out   std_logic_vector(1 downto 0);
-        sdram_addr     : out   std_logic_vector(ROW_BITS-1 downto 0);  		
+        sdram_addr     : out   std_logic_vector(ROW_BITS-1 downto 0);
         sdram_dq       : inout std_logic_vector(15 downto 0);
         sdram_dqm      : out   std_logic_vector(1 downto 0)
     );
 end component;
 
+component cache_ctrl is
+    generic (
+        ADDR_BITS      : integer := 16      -- bridge sram_addr width
+    );
+    port (
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+        clk            : in  std_logic;
+        cache_en       : out std_logic;
+        flush          : out std_logic;
+        flush_busy     : in  std_logic := '0';
+        maint_req      : out std_logic;
+        maint_op       : out std_logic_vector(2 downto 0);
+        maint_lo       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_hi       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_busy     : in  std_logic := '0';
+        maint_full     : in  std_logic := '0';
+        ev_hit         : in  std_logic := '0';
+        ev_miss        : in  std_logic := '0'
+    );
+end component;
+
+component sdram_bist is
+    generic (
+        ADDR_WIDTH     : integer := 25      -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+    );
+    port (
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0'
+    );
+end component;
+
+component sdram_trainer is
+    generic (
+        ADDR_WIDTH     : integer := 25;     -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+        TRAIN_WORDS    : integer := 4;      -- words written/read per candidate (1 to 16)
+        ENABLE         : boolean := true    -- false = rd_delay "00", no training
+    );
+    port (
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0';
+        rd_delay       : out unsigned(1 downto 0);
+        train_done     : out std_logic;
+        train_ok       : out std_logic
+    );
+end component;
+
 component sram_sdram_bridge is
     generic (
         ADDR_BITS        : integer := 24;
         SDRAM_MHZ        : integer := 100;
-        GENERATE_REFRESH : boolean := true;  -- generate refresh_req  false = don't refresh
-        USE_CACHE        : boolean := true;    
+        GENERATE_REFRESH : boolean := true;   -- generate refresh_req  false = don't refresh
+        PHASE_PREDICT    : boolean := false;  -- use cpu_phase to place refreshes
+        USE_CACHE        : boolean := true;
+        WRITE_BACK       : boolean := false;  -- false = write-through, true = write-back
+        USE_WRITE_BUFFER : boolean := false;  -- post write-through stores
+        WRITE_BUFFER_DEPTH : integer := 4;    -- posted writes: 2, 4 or 8 entries
         -- Cache parameters
-        CACHE_SIZE_BYTES : integer := 1024;  -- 1KB cache
-        LINE_SIZE_BYTES  : integer := 16;    -- 16-byte cache lines
-        RAM_BLOCK_TYPE   : string  := "M9K" 
+        CACHE_SIZE_BYTES : integer := 1024;   -- 1KB cache
+        LINE_SIZE_BYTES  : integer := 16;     -- 16-byte cache lines
+        ASSOCIATIVITY    : integer := 1;      -- ways per set: 1, 2 or 4
+        SPLIT_ID         : boolean := false;  -- opcode fetches / data in separate ways
+        PREFETCH         : boolean := false;  -- next-line prefetch
+        PREFETCH_BYTES   : integer := 4;
+        BURST_LENGTH     : integer := 1;      -- must match sdram_controller BURST_LENGTH
+        FAST_BYTES       : integer := 0;      -- always-hit on-chip page
+        RAM_BLOCK_TYPE   : string  := "M9K, no_rw_check"   -- "M9K", "M4K", "M10K", "AUTO"
     );
     port (
-        sdram_clk    : in   std_logic;
-        E            : in   std_logic;
-        reset_n      : in   std_logic;
+        sdram_clk     : in  std_logic;
+        E             : in  std_logic;
+        reset_n       : in  std_logic;
         
         -- SRAM-like interface (CPU side)
         sram_ce_n     : in  std_logic;
         sram_we_n     : in  std_logic;
         sram_oe_n     : in  std_logic;
+        sram_sync     : in  std_logic := '0';  -- opcode fetch (CPU SYNC)
         sram_addr     : in  std_logic_vector(ADDR_BITS-1 downto 0);
         sram_din      : in  std_logic_vector(7 downto 0);
         sram_dout     : out std_logic_vector(7 downto 0);
         
         -- Memory ready output (for clock stretching)
         mrdy          : out std_logic;
+        cpu_phase     : in  std_logic_vector(1 downto 0) := "00";  -- cpu_clock_gen phase (gray)
         
         -- SDRAM controller interface
         sdram_req     : out std_logic;
@@ -347,10 +475,35 @@ component sram_sdram_bridge is
         sdram_byte_en : out std_logic_vector(1 downto 0);
         sdram_ready   : in  std_logic;
         sdram_ack     : in  std_logic;
+        sdram_burst   : out std_logic;
+        sdram_dvalid  : in  std_logic := '0';
+        sdram_next_req  : out std_logic;
+        sdram_next_addr : out std_logic_vector(ADDR_BITS-2 downto 0);
         refresh_req   : out std_logic;
+        refresh_ok    : out std_logic;
+        quiet_cycles  : out unsigned(7 downto 0);
+        
+        -- Cache control
+        flush         : in  std_logic := '0';
+        flush_busy    : out std_logic;
+        cache_en      : in  std_logic := '1';
+        maint_req     : in  std_logic := '0';
+        maint_op      : in  std_logic_vector(2 downto 0) := "000";
+        maint_lo      : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_hi      : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_busy    : out std_logic;
+        maint_full    : out std_logic;
 
         -- Cache statistics
-        cache_hitp    : out unsigned(6 downto 0)  -- 0 to 100%
+        cache_hitp    : out unsigned(6 downto 0);  -- 0 to 100%
+        ev_hit        : out std_logic;  -- event pulses for the pmu
+        ev_miss       : out std_logic;
+        ev_write      : out std_logic;
+        ev_ihit       : out std_logic;
+        ev_imiss      : out std_logic;
+        ev_prefetch   : out std_logic;
+        ev_pf_hit     : out std_logic;
+        debug         : out std_logic_vector(2 downto 0)
     );
 end component;
 
@@ -376,16 +529,17 @@ constant CAS_LATENCY      : integer  := 2;                        -- CAS Latency
 constant ADDR_BITS        : integer  := 12; 
 constant AUTO_PRECHARGE   : boolean  := false;
 constant AUTO_REFRESH     : boolean  := false;
-constant CACHE_DATA       : boolean  := false;
-constant CACHE_SIZE_BYTES : integer  := 1024;                     -- 1KB cache
+constant CACHE_DATA       : boolean  := true;                     -- cached bridge, cache in M10K
+constant BURST_LENGTH     : integer  := 8;                        -- bridge and controller: one burst per 16-byte line
+constant CACHE_SIZE_BYTES : integer  := 2048;                     -- 2KB cache in M10K (must stay < 2**ADDR_BITS)
 constant LINE_SIZE_BYTES  : integer  := 16;                       -- 16-byte cache lines
 constant SDRAM_ADDR_WIDTH : integer  := ROW_BITS + COL_BITS + 2;  -- +2 pour BA(1:0)
-constant RAM_BLOCK_TYPE   : string   := "AUTO";                   -- "M9K", "M4K", "M10K", "AUTO"
+constant RAM_BLOCK_TYPE   : string   := "M10K, no_rw_check";      -- "M9K", "M4K", "M10K", "AUTO"
 constant SERIAL_PORT      : string   := "BUILTIN";                -- "GPIO" or "BUILTIN"
 
 -- Notes: ---------------------------------------------------------------------
--- Beware Enabling the CACHE_DATA paramter works fine on DE10-Lite
---        but not on DE1 and DE1-SOC where the cache ram is implemented in LUT
+-- The cache RAM is placed in M10K by RAM_BLOCK_TYPE (it was in LUTs before,
+-- CACHE_DATA had to stay false on the Cyclone V boards)
 -------------------------------------------------------------------------------
 
 
@@ -418,6 +572,60 @@ signal sdram_dout      : std_logic_vector(15 downto 0);
 signal sdram_byte_en   : std_logic_vector(1 downto 0);
 signal sdram_ready     : std_logic;
 signal sdram_ack       : std_logic;
+signal sdram_burst     : std_logic;
+signal sdram_dvalid    : std_logic;
+signal sdram_next_req  : std_logic;
+signal sdram_next_addr : std_logic_vector(10 downto 0);
+signal refresh_ok      : std_logic;
+signal quiet_cycles    : unsigned(7 downto 0);
+
+-- Core ext_io window $C240-$C2FF
+signal io_cs_n         : std_logic;
+signal io_data         : std_logic_vector(7 downto 0);
+signal bist_cs_n       : std_logic;                     -- sdram_bist registers $C240
+signal bist_data       : std_logic_vector(7 downto 0);
+signal cc_cs_n         : std_logic;                     -- cache_ctrl registers $C250
+signal cc_data         : std_logic_vector(7 downto 0);
+
+-- cache_ctrl <-> bridge
+signal cache_en        : std_logic;
+signal flush           : std_logic;
+signal flush_busy      : std_logic;
+signal maint_req       : std_logic;
+signal maint_op        : std_logic_vector(2 downto 0);
+signal maint_lo        : std_logic_vector(ADDR_BITS-1 downto 0);
+signal maint_hi        : std_logic_vector(ADDR_BITS-1 downto 0);
+signal maint_busy      : std_logic;
+signal maint_full      : std_logic;
+signal ev_hit          : std_logic;                     -- cache hit / miss pulses (cache_ctrl counters)
+signal ev_miss         : std_logic;
+
+-- SDRAM BIST <-> read capture trainer
+signal bt_req          : std_logic;
+signal bt_wr_n         : std_logic;
+signal bt_addr         : std_logic_vector(SDRAM_ADDR_WIDTH-1 downto 0);
+signal bt_din          : std_logic_vector(15 downto 0);
+signal bt_dout         : std_logic_vector(15 downto 0);
+signal bt_byte_en      : std_logic_vector(1 downto 0);
+signal bt_burst        : std_logic;
+signal bt_ready        : std_logic;
+signal bt_ack          : std_logic;
+signal bt_dvalid       : std_logic;
+
+-- Read capture trainer <-> SDRAM controller
+signal ctl_req         : std_logic;
+signal ctl_wr_n        : std_logic;
+signal ctl_addr        : std_logic_vector(SDRAM_ADDR_WIDTH-1 downto 0);
+signal ctl_din         : std_logic_vector(15 downto 0);
+signal ctl_dout        : std_logic_vector(15 downto 0);
+signal ctl_byte_en     : std_logic_vector(1 downto 0);
+signal ctl_burst       : std_logic;
+signal ctl_ready       : std_logic;
+signal ctl_ack         : std_logic;
+signal ctl_dvalid      : std_logic;
+signal rd_delay        : unsigned(1 downto 0);          -- extra read capture clocks (trainer)
+signal train_done      : std_logic;
+signal train_ok        : std_logic;
 signal refresh_busy    : std_logic;
 signal refresh_req     : std_logic;
 signal mrdy            : std_logic;
@@ -482,6 +690,8 @@ begin
                                                     ext_ram_data   =>  ram_data,
                                                     ext_tram_cs_n  =>  tram_cs_n,
                                                     ext_tram_data  =>  tram_data,
+                                                    ext_io_cs_n    =>  io_cs_n,
+                                                    ext_io_data    =>  io_data,
                                                     uart_rx        =>  serial_rx,
                                                     uart_tx        =>  serial_tx,
                                                     spi_cs         =>  open, 
@@ -509,6 +719,7 @@ end generate gen_ebr_ram;
                                                     -- Cache parameters
                                                     CACHE_SIZE_BYTES => CACHE_SIZE_BYTES,  
                                                     LINE_SIZE_BYTES  => LINE_SIZE_BYTES,   
+                                                    BURST_LENGTH     => BURST_LENGTH,
                                                     RAM_BLOCK_TYPE   => RAM_BLOCK_TYPE)
                                            port map(sdram_clk        => sdram_clk,
                                                     E                => phi2,
@@ -531,8 +742,123 @@ end generate gen_ebr_ram;
                                                     sdram_byte_en    => sdram_byte_en,
                                                     sdram_ready      => sdram_ready,
                                                     sdram_ack        => sdram_ack,
+                                                    sdram_burst      => sdram_burst,
+                                                    sdram_dvalid     => sdram_dvalid,
+                                                    sdram_next_req   => sdram_next_req,
+                                                    sdram_next_addr  => sdram_next_addr,
                                                     refresh_req      => refresh_req,
-                                                    cache_hitp       => cache_hit);
+                                                    refresh_ok       => refresh_ok,
+                                                    quiet_cycles     => quiet_cycles,
+                                                    flush            => flush,
+                                                    flush_busy       => flush_busy,
+                                                    cache_en         => cache_en,
+                                                    maint_req        => maint_req,
+                                                    maint_op         => maint_op,
+                                                    maint_lo         => maint_lo,
+                                                    maint_hi         => maint_hi,
+                                                    maint_busy       => maint_busy,
+                                                    maint_full       => maint_full,
+                                                    cache_hitp       => cache_hit,
+                                                    ev_hit           => ev_hit,
+                                                    ev_miss          => ev_miss,
+                                                    ev_write         => open,
+                                                    ev_ihit          => open,
+                                                    ev_imiss         => open,
+                                                    ev_prefetch      => open,
+                                                    ev_pf_hit        => open,
+                                                    debug            => open);
+
+    -- Cache control registers at $C250: enable, invalidate, flush,
+    -- lock / preload and the hit / miss counters of the bridge
+    cc_cs_n <= '0' when io_cs_n = '0' and address_bus(7 downto 4) = x"5" else '1';
+
+    cc_inst : cache_ctrl                generic map(ADDR_BITS          => ADDR_BITS)
+                                          port map (phi2               => phi2,
+                                                    cpu_reset_n        => cpu_reset_n,
+                                                    cs_n               => cc_cs_n,
+                                                    rw                 => rw,
+                                                    address            => address_bus(3 downto 0),
+                                                    data_in            => data_bus,
+                                                    data_out           => cc_data,
+                                                    clk                => sdram_clk,
+                                                    cache_en           => cache_en,
+                                                    flush              => flush,
+                                                    flush_busy         => flush_busy,
+                                                    maint_req          => maint_req,
+                                                    maint_op           => maint_op,
+                                                    maint_lo           => maint_lo,
+                                                    maint_hi           => maint_hi,
+                                                    maint_busy         => maint_busy,
+                                                    maint_full         => maint_full,
+                                                    ev_hit             => ev_hit,
+                                                    ev_miss            => ev_miss);
+
+    -- SDRAM BIST registers at $C240 (core ext_io window $C240-$C2FF),
+    -- transparent between the bridge and the trainer when idle
+    bist_cs_n <= '0' when io_cs_n = '0' and address_bus(7 downto 4) = x"4" else '1';
+    io_data   <= bist_data when bist_cs_n = '0' else
+                 cc_data   when cc_cs_n   = '0' else
+                 (others => '1');
+
+    bist_inst : sdram_bist              generic map(ADDR_WIDTH         => SDRAM_ADDR_WIDTH)
+                                          port map (phi2               => phi2,
+                                                    cpu_reset_n        => cpu_reset_n,
+                                                    cs_n               => bist_cs_n,
+                                                    rw                 => rw,
+                                                    address            => address_bus(3 downto 0),
+                                                    data_in            => data_bus,
+                                                    data_out           => bist_data,
+                                                    clk                => sdram_clk,
+                                                    reset_n            => reset_n,
+                                                    c_req              => sdram_req,
+                                                    c_wr_n             => sdram_wr_n,
+                                                    c_addr             => std_logic_vector(resize(unsigned(sdram_addr), SDRAM_ADDR_WIDTH)),
+                                                    c_din              => sdram_din,
+                                                    c_byte_en          => sdram_byte_en,
+                                                    c_burst            => sdram_burst,
+                                                    c_dout             => sdram_dout,
+                                                    c_ready            => sdram_ready,
+                                                    c_ack              => sdram_ack,
+                                                    c_dvalid           => sdram_dvalid,
+                                                    req                => bt_req,
+                                                    wr_n               => bt_wr_n,
+                                                    addr               => bt_addr,
+                                                    din                => bt_din,
+                                                    dout               => bt_dout,
+                                                    byte_en            => bt_byte_en,
+                                                    burst              => bt_burst,
+                                                    ready              => bt_ready,
+                                                    ack                => bt_ack,
+                                                    dvalid             => bt_dvalid);
+
+    -- Read capture trainer in front of the controller: after the SDRAM
+    -- init it finds rd_delay on the first words, then passes through
+    train_inst : sdram_trainer          generic map(ADDR_WIDTH         => SDRAM_ADDR_WIDTH)
+                                          port map (clk                => sdram_clk,
+                                                    reset_n            => reset_n,
+                                                    c_req              => bt_req,
+                                                    c_wr_n             => bt_wr_n,
+                                                    c_addr             => bt_addr,
+                                                    c_din              => bt_din,
+                                                    c_byte_en          => bt_byte_en,
+                                                    c_burst            => bt_burst,
+                                                    c_dout             => bt_dout,
+                                                    c_ready            => bt_ready,
+                                                    c_ack              => bt_ack,
+                                                    c_dvalid           => bt_dvalid,
+                                                    req                => ctl_req,
+                                                    wr_n               => ctl_wr_n,
+                                                    addr               => ctl_addr,
+                                                    din                => ctl_din,
+                                                    dout               => ctl_dout,
+                                                    byte_en            => ctl_byte_en,
+                                                    burst              => ctl_burst,
+                                                    ready              => ctl_ready,
+                                                    ack                => ctl_ack,
+                                                    dvalid             => ctl_dvalid,
+                                                    rd_delay           => rd_delay,
+                                                    train_done         => train_done,
+                                                    train_ok           => train_ok);
 
     sdram : sdram_controller            generic map(FREQ_MHZ           => SDRAM_MHZ,
                                                     ROW_BITS           => ROW_BITS, 
@@ -542,19 +868,30 @@ end generate gen_ebr_ram;
                                                     TRFC_NS            => TRFC_NS,
                                                     CAS_LATENCY        => CAS_LATENCY,
                                                     USE_AUTO_PRECHARGE => AUTO_PRECHARGE,
-                                                    USE_AUTO_REFRESH   => AUTO_REFRESH)
+                                                    USE_AUTO_REFRESH   => AUTO_REFRESH,
+                                                    BURST_LENGTH       => BURST_LENGTH)
                                           port map (clk                => sdram_clk,
                                                     reset_n            => reset_n,
-                                                    req                => sdram_req,
-                                                    wr_n               => sdram_wr_n,
-                                                    addr               => std_logic_vector(resize(unsigned(sdram_addr), SDRAM_ADDR_WIDTH)), --(24 downto 11 => '0') & sdram_addr,
-                                                    din                => sdram_din,
-                                                    dout               => sdram_dout,
-                                                    byte_en            => sdram_byte_en,
-                                                    ready              => sdram_ready,
-                                                    ack                => sdram_ack,
+                                                    req                => ctl_req,
+                                                    wr_n               => ctl_wr_n,
+                                                    addr               => ctl_addr,
+                                                    din                => ctl_din,
+                                                    dout               => ctl_dout,
+                                                    byte_en            => ctl_byte_en,
+                                                    burst              => ctl_burst,
+                                                    rd_delay           => rd_delay,
+                                                    next_req           => sdram_next_req,
+                                                    next_addr          => std_logic_vector(resize(unsigned(sdram_next_addr), SDRAM_ADDR_WIDTH)),
+                                                    ready              => ctl_ready,
+                                                    ack                => ctl_ack,
+                                                    dvalid             => ctl_dvalid,
                                                     refresh_req        => refresh_req,
+                                                    refresh_ok         => refresh_ok,
+                                                    quiet_cycles       => quiet_cycles,
                                                     refresh_active     => refresh_busy,
+                                                    ev_activate        => open,
+                                                    ev_row_hit         => open,
+                                                    ev_refresh         => open,
                                                     sdram_clk          => DRAM_CLK,
                                                     sdram_cke          => DRAM_CKE,
                                                     sdram_cs_n         => DRAM_CS_N,
@@ -574,6 +911,8 @@ end generate gen_ebr_ram;
     VGA_VS	    <= 'Z';
 
     LEDR(0)     <= refresh_busy;    
+    LEDR(1)     <= train_done;      -- read capture training finished
+    LEDR(2)     <= train_ok;        -- and found a working rd_delay
   
 gen_builtin_serial: if SERIAL_PORT = "BUILTIN" generate
     UART_TX   <= serial_tx;
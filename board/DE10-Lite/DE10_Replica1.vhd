@@ -113,7 +113,10 @@ component Replica1_CORE is
   	   BAUD_RATE       : integer  := 9600;          -- uart speed 1200 to 115200
 		HAS_ACI         : boolean  := false;         -- add the aci (incomplete)
 		HAS_MSPI        : boolean  := false;         -- add master spi  C200
-		HAS_TIMER       : boolean  := false          -- add basic timer
+		HAS_TIMER       : boolean  := false;         -- add basic timer
+		HAS_PMU         : boolean  := false;         -- add performance counters C220
+		HAS_TRACE       : boolean  := false;         -- add bus trace buffer C230
+		RAM_IN_SDRAM    : boolean  := false          -- phase 2: RAM on the ext_tram (sdram bridge) port too
 	);
   port (
    	main_clk       : in     std_logic;
@@ -124,11 +127,19 @@ component Replica1_CORE is
 		bus_address    : out    std_logic_vector(15 downto 0);
 		bus_data       : out    std_logic_vector(7  downto 0);
 		bus_rw         : out    std_logic;
+		bus_sync       : out    std_logic;
 		bus_mrdy       : in     std_logic;
+		bus_phase      : out    std_logic_vector(1  downto 0);
+		bus_stretch    : out    std_logic;
 		ext_ram_cs_n   : out    std_logic;		
 		ext_ram_data   : in     std_logic_vector(7  downto 0);
 		ext_tram_cs_n  : out    std_logic;		 
 		ext_tram_data  : in     std_logic_vector(7  downto 0);
+		ext_io_cs_n    : out    std_logic;
+		ext_io_data    : in     std_logic_vector(7  downto 0) := (others => '1');
+		pmu_ev_clk     : in     std_logic := '0';
+		pmu_events     : in     std_logic_vector(9  downto 0) := (others => '0');
+		trace_ext      : in     std_logic_vector(7  downto 0) := (others => '0');
 		uart_rx        : in     std_logic;
 		uart_tx        : out    std_logic;
 		spi_cs         : out    std_logic;
@@ -148,9 +159,14 @@ component sdram_controller is
         TRP_NS             : integer := 20;    -- Precharge time (for PRECHARGE wait)
         TRCD_NS            : integer := 20;    -- RAS to CAS delay (for ACTIVE→READ/WRITE)
         TRFC_NS            : integer := 70;    -- Refresh cycle time (for AUTO REFRESH wait)
+        TRAS_NS            : integer := 42;    -- Row active time (ACTIVE→PRECHARGE, same bank)
+        TRRD_NS            : integer := 14;    -- ACTIVE to ACTIVE, different banks
+        MAX_REFRESH_DEBT   : integer := 8;     -- refreshes that may be postponed (JEDEC: 8)
+        ADDR_MAPPING       : string  := "BANK_ROW_COL"; -- "BANK_ROW_COL", "ROW_BANK_COL" or "ROW_BANK_XOR"
         CAS_LATENCY        : integer := 2;     -- CAS Latency: 2 or 3 cycles
         USE_AUTO_PRECHARGE : boolean := true;  -- true = READA/WRITEA false = READ/WRITE
-        USE_AUTO_REFRESH   : boolean := true   -- true = autorefresh, false = triggered refresh
+        USE_AUTO_REFRESH   : boolean := true;  -- true = autorefresh, false = triggered refresh
+        BURST_LENGTH       : integer := 1      -- Read burst length: 1, 4 or 8
     );
     port(
         clk                : in    std_logic;  
@@ -163,11 +179,21 @@ component sdram_controller is
         din                : in    std_logic_vector(15 downto 0);
         dout               : out   std_logic_vector(15 downto 0);
         byte_en            : in    std_logic_vector(1 downto 0);  
+        burst              : in    std_logic := '0';
+        rd_delay           : in    unsigned(1 downto 0) := "00";
+        next_req           : in    std_logic := '0';
+        next_addr          : in    std_logic_vector(ROW_BITS+COL_BITS+1 downto 0) := (others => '0');
         ready              : out   std_logic;
         ack                : out   std_logic;
+        dvalid             : out   std_logic;
         
         refresh_req        : in   std_logic;
+        refresh_ok         : in    std_logic := '1';
+        quiet_cycles       : in    unsigned(7 downto 0) := (others => '1');
         refresh_active     : out   std_logic;  
+        ev_activate        : out   std_logic;
+        ev_row_hit         : out   std_logic;
+        ev_refresh         : out   std_logic;
         
         -- SDRAM pins
         sdram_clk          : out   std_logic;
@@ -183,15 +209,124 @@ component sdram_controller is
     );
 end component;
 
+component cache_ctrl is
+    generic (
+        ADDR_BITS      : integer := 16      -- bridge sram_addr width
+    );
+    port (
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+        clk            : in  std_logic;
+        cache_en       : out std_logic;
+        flush          : out std_logic;
+        flush_busy     : in  std_logic := '0';
+        maint_req      : out std_logic;
+        maint_op       : out std_logic_vector(2 downto 0);
+        maint_lo       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_hi       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_busy     : in  std_logic := '0';
+        maint_full     : in  std_logic := '0';
+        ev_hit         : in  std_logic := '0';
+        ev_miss        : in  std_logic := '0'
+    );
+end component;
+
+component sdram_bist is
+    generic (
+        ADDR_WIDTH     : integer := 25      -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+    );
+    port (
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0'
+    );
+end component;
+
+component sdram_trainer is
+    generic (
+        ADDR_WIDTH     : integer := 25;     -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+        TRAIN_WORDS    : integer := 4;      -- words written/read per candidate (1 to 16)
+        ENABLE         : boolean := true    -- false = rd_delay "00", no training
+    );
+    port (
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0';
+        rd_delay       : out unsigned(1 downto 0);
+        train_done     : out std_logic;
+        train_ok       : out std_logic
+    );
+end component;
+
 component sram_sdram_bridge is
     generic (
         ADDR_BITS        : integer := 24;
 		  SDRAM_MHZ        : integer := 75;
         GENERATE_REFRESH : boolean := true;               -- generate refresh_req  false = don't refresh
+        PHASE_PREDICT    : boolean := false;              -- use cpu_phase to place refreshes
         USE_CACHE        : boolean := true;               -- enable/disable cache
+        WRITE_BACK       : boolean := false;              -- false = write-through, true = write-back
+        USE_WRITE_BUFFER : boolean := false;              -- post write-through stores
+        WRITE_BUFFER_DEPTH : integer := 4;                -- posted writes: 2, 4 or 8 entries
         -- Cache parameters
-        CACHE_SIZE_BYTES : integer := 4096;               -- 4KB cache
+        CACHE_SIZE_BYTES : integer := 1024;               -- 1KB cache
         LINE_SIZE_BYTES  : integer := 16;                 -- 16-byte cache lines
+        ASSOCIATIVITY    : integer := 1;                  -- ways per set: 1, 2 or 4
+        SPLIT_ID         : boolean := false;              -- opcode fetches / data in separate ways
+        PREFETCH         : boolean := false;              -- next-line prefetch
+        PREFETCH_BYTES   : integer := 4;
+        BURST_LENGTH     : integer := 1;                  -- must match sdram_controller BURST_LENGTH
+        FAST_BYTES       : integer := 0;                  -- always-hit on-chip page
         RAM_BLOCK_TYPE   : string  := "M9K, no_rw_check"  -- "M9K", "M4K", "M10K", "AUTO"
     );
     port (
@@ -203,12 +338,14 @@ component sram_sdram_bridge is
         sram_ce_n        : in  std_logic;  -- Chip enable (active low)
         sram_we_n        : in  std_logic;  -- Write enable (active low)
         sram_oe_n        : in  std_logic;  -- Output enable (active low)
+        sram_sync        : in  std_logic := '0';  -- opcode fetch (CPU SYNC)
         sram_addr        : in  std_logic_vector(ADDR_BITS-1 downto 0);
         sram_din         : in  std_logic_vector(7 downto 0);
         sram_dout        : out std_logic_vector(7 downto 0);
         
         -- Memory ready output (for clock stretching)
         mrdy             : out std_logic;  -- HIGH=ready, LOW=stretch clock
+        cpu_phase        : in  std_logic_vector(1 downto 0) := "00";  -- cpu_clock_gen phase (gray)
         
         -- SDRAM controller interface
         sdram_req        : out std_logic;
@@ -219,11 +356,47 @@ component sram_sdram_bridge is
         sdram_byte_en    : out std_logic_vector(1 downto 0);
         sdram_ready      : in  std_logic;
         sdram_ack        : in  std_logic;
+        sdram_burst      : out std_logic;
+        sdram_dvalid     : in  std_logic := '0';
+        sdram_next_req   : out std_logic;
+        sdram_next_addr  : out std_logic_vector(ADDR_BITS-2 downto 0);
         refresh_req      : out std_logic;
-        cache_hitp       : out unsigned(6 downto 0)  -- 0 to 100%
+        refresh_ok       : out std_logic;
+        quiet_cycles     : out unsigned(7 downto 0);
+        
+        -- Cache control
+        flush            : in  std_logic := '0';
+        flush_busy       : out std_logic;
+        cache_en         : in  std_logic := '1';
+        maint_req        : in  std_logic := '0';
+        maint_op         : in  std_logic_vector(2 downto 0) := "000";
+        maint_lo         : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_hi         : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_busy       : out std_logic;
+        maint_full       : out std_logic;
+        
+        -- Cache statistics
+        cache_hitp       : out unsigned(6 downto 0);  -- 0 to 100%
+        ev_hit           : out std_logic;  -- event pulses for the pmu
+        ev_miss          : out std_logic;
+        ev_write         : out std_logic;
+        ev_ihit          : out std_logic;
+        ev_imiss         : out std_logic;
+        ev_prefetch      : out std_logic;
+        ev_pf_hit        : out std_logic;
+        debug            : out std_logic_vector(2 downto 0)
     );
 end component;
 
+-- phase 1 / phase 2 value of a constant (RAM_IN_SDRAM)
+function by_phase(ram_in_sdram : boolean; phase1, phase2 : integer) return integer is
+begin
+	if ram_in_sdram then
+		return phase2;
+	end if;
+	return phase1;
+end function;
+
 
 --------------------------------------------------------------------------
 -- Board Configuration Parameters 
@@ -237,7 +410,10 @@ constant BAUD_RATE        : integer  := 115200;
 constant HAS_ACI          : boolean  := false;
 constant HAS_MSPI         : boolean  := false;
 constant HAS_TIMER        : boolean  := false;
-constant USE_EBR_RAM      : boolean  := true;                     -- true for DE10-Lite/DE1-SOC, false for DE1
+constant HAS_PMU          : boolean  := true;                     -- performance counters C220 (cache / SDRAM events)
+constant HAS_TRACE        : boolean  := true;                     -- bus trace buffer C230 (bridge state, mrdy, stretch)
+constant RAM_IN_SDRAM     : boolean  := false;                    -- true = phase 2: $0000-$BFFF in SDRAM through the cache
+constant USE_EBR_RAM      : boolean  := not RAM_IN_SDRAM;         -- true for DE10-Lite/DE1-SOC, false for DE1
 constant SDRAM_MHZ        : integer  := 120;
 constant ROW_BITS         : integer  := 13;
 constant COL_BITS         : integer  := 10;
@@ -245,12 +421,17 @@ constant TRP_NS           : integer := 20;                        -- Precharge t
 constant TRCD_NS          : integer := 20;                        -- RAS to CAS delay (for ACTIVE→READ/WRITE)
 constant TRFC_NS          : integer := 70;                        -- Refresh cycle time (for AUTO REFRESH wait)
 constant CAS_LATENCY      : integer := 2;                         -- CAS Latency: 2 or 3 cycles
-constant ADDR_BITS        : integer  := 12; 
+constant ADDR_BITS        : integer  := by_phase(RAM_IN_SDRAM, 12, 16);  -- bridge window: $E000-$EFFF or the whole CPU space
 constant AUTO_PRECHARGE   : boolean  := false;
 constant AUTO_REFRESH     : boolean  := false;
 constant CACHE_DATA       : boolean  := true;                     -- actually only works fine on DE10-Lite
-constant CACHE_SIZE_BYTES : integer  := 1024;                     -- 1KB cache
+constant PHASE_PREDICT    : boolean  := true;                     -- refreshes placed with the CPU clock phase
+constant WRITE_BACK       : boolean  := false;                    -- write-through
+constant USE_WRITE_BUFFER : boolean  := true;                     -- posted write-through stores
+constant BURST_LENGTH     : integer  := 8;                        -- bridge and controller: one burst per 16-byte line
+constant CACHE_SIZE_BYTES : integer  := by_phase(RAM_IN_SDRAM, 1024, 8192);  -- 1KB, 8KB in phase 2 (the 48KB EBR RAM is gone)
 constant LINE_SIZE_BYTES  : integer  := 16;                       -- 16-byte cache lines
+constant FAST_BYTES       : integer  := by_phase(RAM_IN_SDRAM, 0, 512);   -- phase 2: zero page + stack always hit
 constant SDRAM_ADDR_WIDTH : integer  := ROW_BITS + COL_BITS + 2;  -- +2 pour BA(1:0)
 constant RAM_BLOCK_TYPE   : string   := "M9K, no_rw_check";       -- "M9K", "M4K", "M10K", "AUTO"
 
@@ -269,19 +450,77 @@ signal  serial_clk     : std_logic;
 signal  pll_locked     : std_logic;
 signal  phi2           : std_logic;
 signal  rw             : std_logic;
+signal  sync           : std_logic;
+signal  cpu_phase      : std_logic_vector(1 downto 0);
+signal  cpu_stretch    : std_logic;
 signal  ram_cs         : std_logic;
 signal  rom_cs         : std_logic;
 
 -- SDRAM Controller Interface (bridge side)
 signal sdram_req       : std_logic;
 signal sdram_wr_n      : std_logic;
-signal sdram_addr      : std_logic_vector(10 downto 0);
+signal sdram_addr      : std_logic_vector(ADDR_BITS-2 downto 0);
 signal sdram_din       : std_logic_vector(15 downto 0);
 signal sdram_dout      : std_logic_vector(15 downto 0);
 signal sdram_byte_en   : std_logic_vector(1 downto 0);
 signal sdram_ready     : std_logic;
 signal sdram_ack       : std_logic;
+signal sdram_burst     : std_logic;
+signal sdram_dvalid    : std_logic;
+signal sdram_next_req  : std_logic;
+signal sdram_next_addr : std_logic_vector(ADDR_BITS-2 downto 0);
+signal refresh_ok      : std_logic;
+signal quiet_cycles    : unsigned(7 downto 0);
+
+-- Core ext_io window $C240-$C2FF
+signal io_cs_n         : std_logic;
+signal io_data         : std_logic_vector(7 downto 0);
+signal bist_cs_n       : std_logic;                     -- sdram_bist registers $C240
+signal bist_data       : std_logic_vector(7 downto 0);
+signal cc_cs_n         : std_logic;                     -- cache_ctrl registers $C250
+signal cc_data         : std_logic_vector(7 downto 0);
+
+-- cache_ctrl <-> bridge
+signal cache_en        : std_logic;
+signal flush           : std_logic;
+signal flush_busy      : std_logic;
+signal maint_req       : std_logic;
+signal maint_op        : std_logic_vector(2 downto 0);
+signal maint_lo        : std_logic_vector(ADDR_BITS-1 downto 0);
+signal maint_hi        : std_logic_vector(ADDR_BITS-1 downto 0);
+signal maint_busy      : std_logic;
+signal maint_full      : std_logic;
+
+-- SDRAM BIST <-> read capture trainer
+signal bt_req          : std_logic;
+signal bt_wr_n         : std_logic;
+signal bt_addr         : std_logic_vector(SDRAM_ADDR_WIDTH-1 downto 0);
+signal bt_din          : std_logic_vector(15 downto 0);
+signal bt_dout         : std_logic_vector(15 downto 0);
+signal bt_byte_en      : std_logic_vector(1 downto 0);
+signal bt_burst        : std_logic;
+signal bt_ready        : std_logic;
+signal bt_ack          : std_logic;
+signal bt_dvalid       : std_logic;
+
+-- Read capture trainer <-> SDRAM controller
+signal ctl_req         : std_logic;
+signal ctl_wr_n        : std_logic;
+signal ctl_addr        : std_logic_vector(SDRAM_ADDR_WIDTH-1 downto 0);
+signal ctl_din         : std_logic_vector(15 downto 0);
+signal ctl_dout        : std_logic_vector(15 downto 0);
+signal ctl_byte_en     : std_logic_vector(1 downto 0);
+signal ctl_burst       : std_logic;
+signal ctl_ready       : std_logic;
+signal ctl_ack         : std_logic;
+signal ctl_dvalid      : std_logic;
+signal rd_delay        : unsigned(1 downto 0);          -- extra read capture clocks (trainer)
+signal train_done      : std_logic;
+signal train_ok        : std_logic;
 signal refresh_busy    : std_logic;
+signal pmu_events      : std_logic_vector(9 downto 0);          -- pf hit .. hit, Replica1_CORE order
+signal bridge_state    : std_logic_vector(2 downto 0);          -- bridge debug
+signal trace_ext       : std_logic_vector(7 downto 0);          -- bus trace ext byte
 
 signal mrdy            : std_logic;
 signal refresh_req     : std_logic;
@@ -365,7 +604,10 @@ begin
 																 BAUD_RATE      =>  BAUD_RATE,   -- uart speed 1200 to 115200
 																 HAS_ACI        =>  HAS_ACI,     -- add the aci (incomplete)
                                                  HAS_MSPI       =>  HAS_MSPI,    -- add master spi  C200
-	                                              HAS_TIMER      =>  HAS_TIMER)   -- add basic timer C210
+	                                              HAS_TIMER      =>  HAS_TIMER,   -- add basic timer C210
+																 HAS_PMU        =>  HAS_PMU,     -- add performance counters C220
+																 HAS_TRACE      =>  HAS_TRACE,   -- add bus trace buffer C230
+																 RAM_IN_SDRAM   =>  RAM_IN_SDRAM) -- RAM through the sdram bridge
 													 port map(main_clk       =>  main_clk,
 																 serial_clk     =>  serial_clk,
 																 reset_n        =>  reset_n,
@@ -374,11 +616,19 @@ begin
 																 bus_address    =>  address_bus,
 																 bus_data       =>  data_bus,
 																 bus_rw         =>  rw,
+																 bus_sync       =>  sync,
 																 bus_mrdy       =>  mrdy,
+																 bus_phase      =>  cpu_phase,
+																 bus_stretch    =>  cpu_stretch,
 																 ext_ram_cs_n   =>  ram_cs_n,
 																 ext_ram_data   =>  ram_data,
 																 ext_tram_cs_n  =>  tram_cs_n,
 																 ext_tram_data  =>  tram_data,
+																 ext_io_cs_n    =>  io_cs_n,
+																 ext_io_data    =>  io_data,
+																 pmu_ev_clk     =>  sdram_clk,
+																 pmu_events     =>  pmu_events,
+																 trace_ext      =>  trace_ext,
 																 uart_rx        =>  ARDUINO_IO(0),
 																 uart_tx        =>  ARDUINO_IO(1),
 																 spi_cs         =>  ARDUINO_IO(4),   -- SD Card Data 3          CS
@@ -403,22 +653,29 @@ end generate gen_ebr_ram;
     bridge_inst : sram_sdram_bridge  generic map(ADDR_BITS        => ADDR_BITS,
 	                                              SDRAM_MHZ        => SDRAM_MHZ,
                                                  GENERATE_REFRESH => not AUTO_REFRESH,
+                                                 PHASE_PREDICT    => PHASE_PREDICT,
                                                  USE_CACHE        => CACHE_DATA,
+                                                 WRITE_BACK       => WRITE_BACK,
+                                                 USE_WRITE_BUFFER => USE_WRITE_BUFFER,
                                                  -- Cache parameters
                                                  CACHE_SIZE_BYTES => CACHE_SIZE_BYTES, 
                                                  LINE_SIZE_BYTES  => LINE_SIZE_BYTES,  
+                                                 BURST_LENGTH     => BURST_LENGTH,
+                                                 FAST_BYTES       => FAST_BYTES,
 																 RAM_BLOCK_TYPE   => RAM_BLOCK_TYPE)  
 													 port map(sdram_clk        => sdram_clk,
-													          E                => phi2,
+																 E                => phi2,
 																 reset_n          => reset_n,
 																 -- SRAM interface 
 																 sram_ce_n        => tram_cs_n,
 																 sram_we_n        => rw,
 																 sram_oe_n        => not rw,
+																 sram_sync        => sync,
 																 sram_addr        => address_bus(ADDR_BITS - 1 downto 0),
 																 sram_din         => data_bus,
 																 sram_dout        => tram_data,
 																 mrdy             => mrdy,
+																 cpu_phase        => cpu_phase,
                                                  -- SDRAM controller interface
 																 sdram_req        => sdram_req,
 																 sdram_wr_n       => sdram_wr_n,
@@ -428,8 +685,126 @@ end generate gen_ebr_ram;
 																 sdram_byte_en    => sdram_byte_en,
 																 sdram_ready      => sdram_ready,
 																 sdram_ack        => sdram_ack,
+																 sdram_burst      => sdram_burst,
+																 sdram_dvalid     => sdram_dvalid,
+																 sdram_next_req   => sdram_next_req,
+																 sdram_next_addr  => sdram_next_addr,
 																 refresh_req      => refresh_req,
-                                                 cache_hitp       => cache_hit);
+																 refresh_ok       => refresh_ok,
+																 quiet_cycles     => quiet_cycles,
+																 flush            => flush,
+																 flush_busy       => flush_busy,
+																 cache_en         => cache_en,
+																 maint_req        => maint_req,
+																 maint_op         => maint_op,
+																 maint_lo         => maint_lo,
+																 maint_hi         => maint_hi,
+																 maint_busy       => maint_busy,
+																 maint_full       => maint_full,
+                                                 cache_hitp       => cache_hit,
+																 ev_hit           => pmu_events(0),
+																 ev_miss          => pmu_events(1),
+																 ev_write         => pmu_events(2),
+																 ev_ihit          => pmu_events(6),
+																 ev_imiss         => pmu_events(7),
+																 ev_prefetch      => pmu_events(8),
+																 ev_pf_hit        => pmu_events(9),
+																 debug            => bridge_state);
+
+	-- bus trace ext byte: stretch, mrdy, bridge state
+	trace_ext <= "000" & cpu_stretch & mrdy & bridge_state;
+
+	-- Cache control registers at $C250: enable, invalidate, flush,
+	-- lock / preload and the hit / miss counters of the bridge
+	cc_cs_n <= '0' when io_cs_n = '0' and address_bus(7 downto 4) = x"5" else '1';
+
+    cc_inst : cache_ctrl            generic map (ADDR_BITS          => ADDR_BITS)
+													port map (phi2               => phi2,
+																 cpu_reset_n        => cpu_reset_n,
+																 cs_n               => cc_cs_n,
+																 rw                 => rw,
+																 address            => address_bus(3 downto 0),
+																 data_in            => data_bus,
+																 data_out           => cc_data,
+																 clk                => sdram_clk,
+																 cache_en           => cache_en,
+																 flush              => flush,
+																 flush_busy         => flush_busy,
+																 maint_req          => maint_req,
+																 maint_op           => maint_op,
+																 maint_lo           => maint_lo,
+																 maint_hi           => maint_hi,
+																 maint_busy         => maint_busy,
+																 maint_full         => maint_full,
+																 ev_hit             => pmu_events(0),
+																 ev_miss            => pmu_events(1));
+
+	-- SDRAM BIST registers at $C240 (core ext_io window $C240-$C2FF),
+	-- transparent between the bridge and the trainer when idle
+	bist_cs_n <= '0' when io_cs_n = '0' and address_bus(7 downto 4) = x"4" else '1';
+	io_data   <= bist_data when bist_cs_n = '0' else
+	             cc_data   when cc_cs_n   = '0' else
+	             (others => '1');
+
+    bist_inst : sdram_bist          generic map (ADDR_WIDTH         => SDRAM_ADDR_WIDTH)
+													port map (phi2               => phi2,
+																 cpu_reset_n        => cpu_reset_n,
+																 cs_n               => bist_cs_n,
+																 rw                 => rw,
+																 address            => address_bus(3 downto 0),
+																 data_in            => data_bus,
+																 data_out           => bist_data,
+																 clk                => sdram_clk,
+																 reset_n            => reset_n,
+																 c_req              => sdram_req,
+																 c_wr_n             => sdram_wr_n,
+																 c_addr             => std_logic_vector(resize(unsigned(sdram_addr), SDRAM_ADDR_WIDTH)),
+																 c_din              => sdram_din,
+																 c_byte_en          => sdram_byte_en,
+																 c_burst            => sdram_burst,
+																 c_dout             => sdram_dout,
+																 c_ready            => sdram_ready,
+																 c_ack              => sdram_ack,
+																 c_dvalid           => sdram_dvalid,
+																 req                => bt_req,
+																 wr_n               => bt_wr_n,
+																 addr               => bt_addr,
+																 din                => bt_din,
+																 dout               => bt_dout,
+																 byte_en            => bt_byte_en,
+																 burst              => bt_burst,
+																 ready              => bt_ready,
+																 ack                => bt_ack,
+																 dvalid             => bt_dvalid);
+
+    -- Read capture trainer in front of the controller: after the SDRAM
+    -- init it finds rd_delay on the first words, then passes through
+    train_inst : sdram_trainer      generic map (ADDR_WIDTH         => SDRAM_ADDR_WIDTH)
+													port map (clk                => sdram_clk,
+																 reset_n            => reset_n,
+																 c_req              => bt_req,
+																 c_wr_n             => bt_wr_n,
+																 c_addr             => bt_addr,
+																 c_din              => bt_din,
+																 c_byte_en          => bt_byte_en,
+																 c_burst            => bt_burst,
+																 c_dout             => bt_dout,
+																 c_ready            => bt_ready,
+																 c_ack              => bt_ack,
+																 c_dvalid           => bt_dvalid,
+																 req                => ctl_req,
+																 wr_n               => ctl_wr_n,
+																 addr               => ctl_addr,
+																 din                => ctl_din,
+																 dout               => ctl_dout,
+																 byte_en            => ctl_byte_en,
+																 burst              => ctl_burst,
+																 ready              => ctl_ready,
+																 ack                => ctl_ack,
+																 dvalid             => ctl_dvalid,
+																 rd_delay           => rd_delay,
+																 train_done         => train_done,
+																 train_ok           => train_ok);
 
     -- SDRAM Controller Instance
     sdram_inst : sdram_controller   generic map (FREQ_MHZ           => SDRAM_MHZ,
@@ -440,19 +815,30 @@ end generate gen_ebr_ram;
                                                  TRFC_NS            => TRFC_NS,
                                                  CAS_LATENCY        => CAS_LATENCY,
                                                  USE_AUTO_PRECHARGE => AUTO_PRECHARGE,
-                                                 USE_AUTO_REFRESH   => AUTO_REFRESH)
+                                                 USE_AUTO_REFRESH   => AUTO_REFRESH,
+                                                 BURST_LENGTH       => BURST_LENGTH)
 													port map (clk                => sdram_clk,
 																 reset_n            => reset_n,
-																 req                => sdram_req,
-																 wr_n               => sdram_wr_n,
-																 addr               => std_logic_vector(resize(unsigned(sdram_addr), SDRAM_ADDR_WIDTH)),
-																 din                => sdram_din,
-																 dout               => sdram_dout,
-																 byte_en            => sdram_byte_en,
-																 ready              => sdram_ready,
-																 ack                => sdram_ack,
+																 req                => ctl_req,
+																 wr_n               => ctl_wr_n,
+																 addr               => ctl_addr,
+																 din                => ctl_din,
+																 dout               => ctl_dout,
+																 byte_en            => ctl_byte_en,
+																 burst              => ctl_burst,
+																 rd_delay           => rd_delay,
+																 next_req           => sdram_next_req,
+																 next_addr          => std_logic_vector(resize(unsigned(sdram_next_addr), SDRAM_ADDR_WIDTH)),
+																 ready              => ctl_ready,
+																 ack                => ctl_ack,
+																 dvalid             => ctl_dvalid,
 																 refresh_req        => refresh_req,
+																 refresh_ok         => refresh_ok,
+																 quiet_cycles       => quiet_cycles,
 																 refresh_active     => refresh_busy,
+																 ev_activate        => pmu_events(3),
+																 ev_row_hit         => pmu_events(4),
+																 ev_refresh         => pmu_events(5),
 																 sdram_clk          => DRAM_CLK,
 																 sdram_cke          => DRAM_CKE,
 																 sdram_cs_n         => DRAM_CS_N,
@@ -478,6 +864,11 @@ end generate gen_ebr_ram;
 	GSENSOR_SDI		<= 'Z';
 	GSENSOR_SDO	 	<= 'Z';
 
+	-- LEDR0 read capture trained, LEDR1 training finished
+	LEDR(0)         <= train_ok;
+	LEDR(1)         <= train_done;
+	LEDR(9 downto 2) <= (others => '0');
+
 
 	
 end top;
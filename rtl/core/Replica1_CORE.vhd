@@ -11,7 +11,10 @@ entity Replica1_CORE is
 	    BAUD_RATE       : integer :=  115200;        -- uart speed 1200 to 115200
 		HAS_ACI         : boolean :=  false;         -- add the aci (incomplete)
 		HAS_MSPI        : boolean :=  false;         -- add master spi  C200
-		HAS_TIMER       : boolean :=  false          -- add basic timer
+		HAS_TIMER       : boolean :=  false;         -- add basic timer
+		HAS_PMU         : boolean :=  false;         -- add performance counters C220
+		HAS_TRACE       : boolean :=  false;         -- add bus trace buffer C230
+		RAM_IN_SDRAM    : boolean :=  false          -- phase 2: RAM on the ext_tram (sdram bridge) port too
   );
   port (
 		main_clk        : in     std_logic;
@@ -22,11 +25,19 @@ entity Replica1_CORE is
 		bus_address     : out    std_logic_vector(15 downto 0);
 		bus_data        : out    std_logic_vector(7  downto 0);
 		bus_rw          : out    std_logic;
+		bus_sync        : out    std_logic;                              -- opcode fetch (bridge I/D split)
 		bus_mrdy        : in     std_logic;
+		bus_phase       : out    std_logic_vector(1  downto 0);          -- cpu_clock_gen phase, gray (bridge PHASE_PREDICT)
+		bus_stretch     : out    std_logic;                              -- '1' while mrdy stretches phi2
 		ext_ram_cs_n    : out    std_logic;		
 		ext_ram_data    : in     std_logic_vector(7  downto 0);
 		ext_tram_cs_n   : out    std_logic;		 
 		ext_tram_data   : in     std_logic_vector(7  downto 0);
+		ext_io_cs_n     : out    std_logic;                              -- C240-C2FF board peripherals (bist...)
+		ext_io_data     : in     std_logic_vector(7  downto 0) := (others => '1');
+		pmu_ev_clk      : in     std_logic := '0';                       -- sdram_clk
+		pmu_events      : in     std_logic_vector(9  downto 0) := (others => '0');  -- pf hit, prefetch, imiss, ihit, refresh, row hit, activate, write, miss, hit
+		trace_ext       : in     std_logic_vector(7  downto 0) := (others => '0');  -- board state recorded by the trace
 		uart_rx         : in     std_logic;
 		uart_tx         : out    std_logic;
 		spi_cs          : out    std_logic;
@@ -66,7 +77,9 @@ component CPU_65XX is
 		irq_n        : in  std_logic;        -- Interrupt request (active low)
 		so_n         : in  std_logic := '1';  -- Set overflow (active low)
 		
-		mrdy         : in  std_logic
+		mrdy         : in  std_logic;
+		phase        : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase (gray)
+		stretch      : out std_logic
 	);
 end component;
 
@@ -93,7 +106,9 @@ component CPU_R65C02 is
 		irq_n        : in  std_logic;        -- Interrupt request (active low)
 		so_n         : in  std_logic := '1';  -- Set overflow (active low)
 		
-		mrdy         : in  std_logic
+		mrdy         : in  std_logic;
+		phase        : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase (gray)
+		stretch      : out std_logic
 	);
 end component;
 
@@ -120,7 +135,9 @@ component CPU_T65 is
 		irq_n        : in  std_logic;        -- Interrupt request (active low)
 		so_n         : in  std_logic := '1';  -- Set overflow (active low)
 		
-		mrdy         : in  std_logic
+		mrdy         : in  std_logic;
+		phase        : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase (gray)
+		stretch      : out std_logic
 	);
 end component;
 
@@ -147,7 +164,9 @@ component CPU_MX65 is
 		irq_n        : in  std_logic;        -- Interrupt request (active low)
 		so_n         : in  std_logic := '1';  -- Set overflow (active low)
 		
-		mrdy         : in  std_logic
+		mrdy         : in  std_logic;
+		phase        : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase (gray)
+		stretch      : out std_logic
 	);
 end component;
 
@@ -176,7 +195,9 @@ component CPU_6800 is
 		so_n        : in  std_logic := '1'; -- Set overflow (not used by 6800)
 
 		-- wait states
-		mrdy        : in  std_logic
+		mrdy        : in  std_logic;
+		phase       : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase (gray)
+		stretch     : out std_logic
 	);
 end component;
 
@@ -205,7 +226,9 @@ component CPU_6809 is
 		so_n        : in  std_logic := '1'; -- Set overflow (not used by 6800)
 
 		-- wait states
-		mrdy        : in  std_logic
+		mrdy        : in  std_logic;
+		phase       : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase (gray)
+		stretch     : out std_logic
 	);
 end component;
 
@@ -340,7 +363,8 @@ component mspi_iface is
         spi_sck     : out std_logic;
         spi_cs_n    : out std_logic;
         spi_mosi    : out std_logic;
-        spi_miso    : in  std_logic
+        spi_miso    : in  std_logic;
+        spi_byte    : out std_logic                      -- one phi2 pulse per byte transferred
     );
 end component;
 
@@ -357,6 +381,49 @@ component simple_timer is
     );
 end component;
 
+component pmu is
+    port (
+        phi2        : in  std_logic;                     -- CPU clock
+        reset_n     : in  std_logic;                     -- reset active low
+        cs_n        : in  std_logic;                     -- Chip select (active low)
+        rw          : in  std_logic;                     -- Read/Write (low = write)
+        address     : in  std_logic_vector(3 downto 0);  -- Address bits A3..A0
+        data_in     : in  std_logic_vector(7 downto 0);  -- Data from CPU
+        data_out    : out std_logic_vector(7 downto 0);  -- Data to CPU
+        main_clk    : in  std_logic;                     -- cpu_clock_gen clk_4x
+        spi_byte    : in  std_logic := '0';              -- phi2 pulse per SPI byte
+        ev_clk      : in  std_logic := '0';              -- sdram_clk
+        ev_hit      : in  std_logic := '0';              -- ev_clk pulses
+        ev_miss     : in  std_logic := '0';
+        ev_write    : in  std_logic := '0';
+        ev_activate : in  std_logic := '0';
+        ev_row_hit  : in  std_logic := '0';
+        ev_refresh  : in  std_logic := '0';
+        ev_ihit     : in  std_logic := '0';
+        ev_imiss    : in  std_logic := '0';
+        ev_prefetch : in  std_logic := '0';
+        ev_pf_hit   : in  std_logic := '0'
+    );
+end component;
+
+component bus_trace is
+    port (
+        phi2        : in  std_logic;                     -- CPU clock
+        reset_n     : in  std_logic;                     -- reset active low
+        cs_n        : in  std_logic;                     -- Chip select (active low)
+        rw          : in  std_logic;                     -- Read/Write (low = write)
+        address     : in  std_logic_vector(3 downto 0);  -- Address bits A3..A0
+        data_in     : in  std_logic_vector(7 downto 0);  -- Data from CPU
+        data_out    : out std_logic_vector(7 downto 0);  -- Data to CPU
+        main_clk    : in  std_logic;                     -- cpu_clock_gen clk_4x
+        bus_address : in  std_logic_vector(15 downto 0); -- traced bus
+        bus_data    : in  std_logic_vector(7 downto 0);
+        bus_rw      : in  std_logic;
+        bus_sync    : in  std_logic;
+        ext         : in  std_logic_vector(7 downto 0) := (others => '0')
+    );
+end component;
+
 	attribute keep : string;
 
 	constant RAM_LIMIT  : integer := RAM_SIZE_KB * 1024;
@@ -371,6 +438,9 @@ end component;
 	signal mspi_data	  : std_logic_vector(7 downto 0);
 	signal aci_data	  : std_logic_vector(7 downto 0);
 	signal timer_data	  : std_logic_vector(7 downto 0);
+	signal pmu_data	  : std_logic_vector(7 downto 0);
+	signal trace_data	  : std_logic_vector(7 downto 0);
+	signal io_data		  : std_logic_vector(7 downto 0);
 	signal ram_addr 	  : std_logic_vector(18 downto 0);
 	signal rw			  : std_logic;
 	signal vma  		  : std_logic;
@@ -384,12 +454,18 @@ end component;
 	signal mspi_cs_n    : std_logic;
 	signal sspi_cs_n    : std_logic;
 	signal timer_cs_n   : std_logic;
+	signal pmu_cs_n     : std_logic;
+	signal trace_cs_n   : std_logic;
+	signal io_cs_n      : std_logic;
+	signal spi_byte     : std_logic := '0';
 	signal pia_cs_n     : std_logic;
 	signal phi2         : std_logic;
 	signal sync         : std_logic;
 	signal aci_in       : std_logic;
 	signal aci_out      : std_logic;
 	signal mrdy         : std_logic;
+	signal cpu_phase    : std_logic_vector(1 downto 0);
+	signal cpu_stretch  : std_logic;
 	
 	signal spi_sck_ext  : std_logic;
    signal spi_cs_ext   : std_logic;
@@ -409,11 +485,28 @@ begin
 	bus_data       <= data_bus;
 	bus_phi2       <= phi2;
 	bus_rw         <= rw;
+	bus_sync       <= sync;
 	mrdy           <= bus_mrdy;
+	bus_phase      <= cpu_phase;
+	bus_stretch    <= cpu_stretch;
+	ext_io_cs_n    <= io_cs_n;
+	tram_data      <= ext_tram_data;
+	io_data        <= ext_io_data;
+
+-- Phase 2 (RAM_IN_SDRAM): the RAM and the $E000 window are both served by
+-- the bridge on ext_tram, sram_addr = the 16-bit CPU address; ext_ram
+-- stays idle and the EBR is left to the ROM and the cache
+gen_ram_ebr: if RAM_IN_SDRAM = false generate
 	ext_ram_cs_n   <= ram_cs_n;
 	ext_tram_cs_n  <= tram_cs_n;
 	ram_data       <= ext_ram_data;
-	tram_data      <= ext_tram_data;
+end generate gen_ram_ebr;
+
+gen_ram_sdram: if RAM_IN_SDRAM = true generate
+	ext_ram_cs_n   <= '1';
+	ext_tram_cs_n  <= ram_cs_n and tram_cs_n;
+	ram_data       <= ext_tram_data;
+end generate gen_ram_sdram;
 						
 -- Apple 1 CPU can be either CPU65XX for the 6502 or  CPU68 for the 6800
 
@@ -433,7 +526,9 @@ c0: if CPU_CORE = "65XX" generate
 									nmi_n           => nmi_n,
 									irq_n           => irq_n,
 									so_n            => so_n,
-									mrdy            => mrdy);
+									mrdy            => mrdy,
+									phase           => cpu_phase,
+									stretch         => cpu_stretch);
 end generate c0;
 
 c1: if CPU_CORE = "T65" generate
@@ -450,7 +545,9 @@ c1: if CPU_CORE = "T65" generate
 									nmi_n           => nmi_n,
 									irq_n           => irq_n,
 									so_n            => so_n,
-									mrdy            => mrdy);
+									mrdy            => mrdy,
+									phase           => cpu_phase,
+									stretch         => cpu_stretch);
 end generate c1;
 
 c2: if CPU_CORE = "MX65" generate
@@ -467,7 +564,9 @@ c2: if CPU_CORE = "MX65" generate
 									 nmi_n           => nmi_n,
 									 irq_n           => irq_n,
 									 so_n            => so_n,
-									 mrdy            => mrdy);
+									 mrdy            => mrdy,
+									 phase           => cpu_phase,
+									 stretch         => cpu_stretch);
 end generate c2;
 											  
 end generate gen_cpu0;
@@ -486,7 +585,9 @@ gen_cpu1: if CPU_TYPE = "65C02" generate
 									 nmi_n           => nmi_n,
 									 irq_n           => irq_n,
 									 so_n            => so_n,
-									 mrdy            => mrdy);
+									 mrdy            => mrdy,
+									 phase           => cpu_phase,
+									 stretch         => cpu_stretch);
 end generate gen_cpu1;
 											  
 gen_cpu2: if CPU_TYPE = "6800" generate
@@ -503,7 +604,9 @@ gen_cpu2: if CPU_TYPE = "6800" generate
 									nmi_n           => nmi_n,
 									irq_n           => irq_n,
 									so_n            => so_n,
-  									mrdy            => mrdy);
+  									mrdy            => mrdy,
+  									phase           => cpu_phase,
+  									stretch         => cpu_stretch);
 end generate gen_cpu2;
 
 gen_cpu3: if CPU_TYPE = "6809" generate
@@ -520,7 +623,9 @@ gen_cpu3: if CPU_TYPE = "6809" generate
 									nmi_n           => nmi_n,
 									irq_n           => irq_n,
 									so_n            => so_n,
-  									mrdy            => mrdy);
+  									mrdy            => mrdy,
+  									phase           => cpu_phase,
+  									stretch         => cpu_stretch);
 end generate gen_cpu3;
 
 
@@ -604,7 +709,8 @@ gen_mspi: if HAS_MSPI = true generate
 									  spi_sck         => spi_sck,   
 									  spi_cs_n        => spi_cs,    
 								 	  spi_mosi        => spi_mosi,  
-  									  spi_miso        => spi_miso); 
+  									  spi_miso        => spi_miso,
+									  spi_byte        => spi_byte); 
 end generate gen_mspi;
 
 
@@ -619,10 +725,55 @@ gen_timer: if HAS_TIMER = true generate
 									      timer_clk     => phi2);
 end generate gen_timer;
 
+
+gen_pmu: if HAS_PMU = true generate
+	pmu0: pmu          port map(phi2          => phi2,
+									      reset_n       => cpu_reset_n,
+									      cs_n          => pmu_cs_n,
+									      rw            => rw,
+									      address       => address_bus(3 downto 0),
+									      data_in       => data_bus,
+									      data_out      => pmu_data,
+									      main_clk      => main_clk,
+									      spi_byte      => spi_byte,
+									      ev_clk        => pmu_ev_clk,
+									      ev_hit        => pmu_events(0),
+									      ev_miss       => pmu_events(1),
+									      ev_write      => pmu_events(2),
+									      ev_activate   => pmu_events(3),
+									      ev_row_hit    => pmu_events(4),
+									      ev_refresh    => pmu_events(5),
+									      ev_ihit       => pmu_events(6),
+									      ev_imiss      => pmu_events(7),
+									      ev_prefetch   => pmu_events(8),
+									      ev_pf_hit     => pmu_events(9));
+end generate gen_pmu;
+
+
+gen_trace: if HAS_TRACE = true generate
+	trace: bus_trace    port map(phi2          => phi2,
+									      reset_n       => cpu_reset_n,
+									      cs_n          => trace_cs_n,
+									      rw            => rw,
+									      address       => address_bus(3 downto 0),
+									      data_in       => data_bus,
+									      data_out      => trace_data,
+									      main_clk      => main_clk,
+									      bus_address   => address_bus,
+									      bus_data      => data_bus,
+									      bus_rw        => rw,
+									      bus_sync      => sync,
+									      ext           => trace_ext);
+end generate gen_trace;
+
 											
    aci_cs_n     <= '0' when vma = '1' and address_bus(15 downto 9)   = x"C" & "000"  else '1';   -- IF WOZACI
    mspi_cs_n    <= '0' when vma = '1' and address_bus(15 downto 4)   = x"C20"        else '1';   -- IF MASTER SPI CONTROLLER
    timer_cs_n   <= '0' when vma = '1' and address_bus(15 downto 4)   = x"C21"        else '1';   -- IF TIMER
+   pmu_cs_n     <= '0' when vma = '1' and address_bus(15 downto 4)   = x"C22"        else '1';   -- IF PMU
+   trace_cs_n   <= '0' when vma = '1' and address_bus(15 downto 4)   = x"C23"        else '1';   -- IF BUS TRACE
+   io_cs_n      <= '0' when vma = '1' and address_bus(15 downto 8)   = x"C2"  and
+                           unsigned(address_bus(7 downto 4)) >= 4                  else '1';   -- BOARD PERIPHERALS C240-C2FF
    pia_cs_n     <= '0' when vma = '1' and address_bus(15 downto 4)   = x"D01"        else '1';   -- REPLICA CONSOLE PIA
    tram_cs_n    <= '0' when vma = '1' and address_bus(15 downto 12)  = x"E"          else '1';   -- SDRAM TEST
 	
@@ -631,6 +782,9 @@ end generate gen_timer;
 		         aci_data      when aci_cs_n    = '0' else 
 		         mspi_data     when mspi_cs_n   = '0' else 
 		         timer_data    when timer_cs_n  = '0' else 
+		         pmu_data      when pmu_cs_n    = '0' else 
+		         trace_data    when trace_cs_n  = '0' else 
+		         io_data       when io_cs_n     = '0' else 
 		         ram_data      when ram_cs_n    = '0' else 
 		         tram_data     when tram_cs_n   = '0' else 
 			      pia_data      when pia_cs_n    = '0' else
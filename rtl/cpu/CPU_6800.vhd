@@ -36,7 +36,11 @@ entity CPU_6800 is
 		so_n        : in  std_logic := '1';  -- Set overflow (not used by 6800)
 		
 		-- wait states
-		mrdy        : in  std_logic
+		mrdy        : in  std_logic;
+
+		-- clock generator state (SDRAM bridge, bus trace)
+		phase       : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase, gray coded
+		stretch     : out std_logic                      -- '1' while mrdy stretches phi2
 	);
 end CPU_6800;
 
@@ -49,7 +53,8 @@ architecture MC6800_impl of CPU_6800 is
 			  mrdy    : in  STD_LOGIC;       -- Memory Ready
 			  clk_1x  : out STD_LOGIC;       -- CPU clock (stretched)
 			  clk_2x  : out STD_LOGIC;       -- 2x clock for 6502 cores
-			  stretch : out STD_LOGIC        -- '1' only when actually stretching
+			  stretch : out STD_LOGIC;       -- '1' only when actually stretching
+			  phase   : out STD_LOGIC_VECTOR(1 downto 0)  -- count, gray coded (for the SDRAM bridge)
 		 );
 	end component;
 
@@ -88,7 +93,8 @@ begin
 									    mrdy    => mrdy,
 									    clk_1x  => mc6800_clk,
 									    clk_2x  => open,
-									    stretch => open);	
+									    stretch => stretch,
+									    phase   => phase);	
 
 	E <= mc6800_clk;
 	data_bus <= data_in;
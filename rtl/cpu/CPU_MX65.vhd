@@ -35,7 +35,11 @@ entity CPU_MX65 is
 		so_n        : in  std_logic := '1'; -- Set overflow (active low)
 		
 		-- wait states
-		mrdy        : in  std_logic
+		mrdy        : in  std_logic;
+
+		-- clock generator state (SDRAM bridge, bus trace)
+		phase       : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase, gray coded
+		stretch     : out std_logic                      -- '1' while mrdy stretches phi2
 	);
 end CPU_MX65;
 
@@ -48,7 +52,8 @@ architecture MX65_impl of CPU_MX65 is
 			  mrdy    : in  STD_LOGIC;       -- Memory Ready
 			  clk_1x  : out STD_LOGIC;       -- CPU clock (stretched)
 			  clk_2x  : out STD_LOGIC;       -- 2x clock for 6502 cores
-			  stretch : out STD_LOGIC        -- '1' only when actually stretching
+			  stretch : out STD_LOGIC;       -- '1' only when actually stretching
+			  phase   : out STD_LOGIC_VECTOR(1 downto 0)  -- count, gray coded (for the SDRAM bridge)
 		 );
 	end component;
 	
@@ -87,7 +92,8 @@ architecture MX65_impl of CPU_MX65 is
 							          mrdy    => mrdy,
 							          clk_1x  => phi2_internal,
 							          clk_2x  => mx65_clk,
-							          stretch => open);	
+							          stretch => stretch,
+							          phase   => phase);	
 	
 	
 	phi2 <= phi2_internal;
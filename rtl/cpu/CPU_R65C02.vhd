@@ -30,7 +30,11 @@ entity CPU_R65C02 is
 		so_n        : in  std_logic := '1'; -- Set overflow (active low)
 		
 		-- wait states
-		mrdy        : in  std_logic
+		mrdy        : in  std_logic;
+
+		-- clock generator state (SDRAM bridge, bus trace)
+		phase       : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase, gray coded
+		stretch     : out std_logic                      -- '1' while mrdy stretches phi2
 	);
 end CPU_R65C02;
 
@@ -43,7 +47,8 @@ architecture CPU_R65C02_impl of CPU_R65C02 is
 			  mrdy    : in  STD_LOGIC;       -- Memory Ready
 			  clk_1x  : out STD_LOGIC;       -- CPU clock (stretched)
 			  clk_2x  : out STD_LOGIC;       -- 2x clock for 6502 cores
-			  stretch : out STD_LOGIC        -- '1' only when actually stretching
+			  stretch : out STD_LOGIC;       -- '1' only when actually stretching
+			  phase   : out STD_LOGIC_VECTOR(1 downto 0)  -- count, gray coded (for the SDRAM bridge)
 		 );
 	end component;
 
@@ -91,7 +96,8 @@ begin
 									    mrdy    => mrdy,
 									    clk_1x  => phi2_internal,
 									    clk_2x  => r6502_clk,
-									    stretch => open);
+									    stretch => stretch,
+									    phase   => phase);
 											  
 	-- R65C02 instantiation
 	cpu65c02_inst: R65C02
@@ -33,7 +33,11 @@ entity CPU_T65 is
 		irq_n       : in  std_logic;        -- Interrupt request (active low)
 		so_n        : in  std_logic := '1'; -- Set overflow (active low)
 		-- wait states
-		mrdy        : in  std_logic         -- Memory Ready (Low = stretch clock)
+		mrdy        : in  std_logic;        -- Memory Ready (Low = stretch clock)
+
+		-- clock generator state (SDRAM bridge, bus trace)
+		phase       : out std_logic_vector(1 downto 0);  -- cpu_clock_gen phase, gray coded
+		stretch     : out std_logic                      -- '1' while mrdy stretches phi2
 	);
 end CPU_T65;
 
@@ -46,7 +50,8 @@ architecture T65_impl of CPU_T65 is
 			  mrdy    : in  STD_LOGIC;       -- Memory Ready
 			  clk_1x  : out STD_LOGIC;       -- CPU clock (stretched)
 			  clk_2x  : out STD_LOGIC;       -- 2x clock for 6502 cores
-			  stretch : out STD_LOGIC        -- '1' only when actually stretching
+			  stretch : out STD_LOGIC;       -- '1' only when actually stretching
+			  phase   : out STD_LOGIC_VECTOR(1 downto 0)  -- count, gray coded (for the SDRAM bridge)
 		 );
 	end component;
 
@@ -63,7 +68,8 @@ begin
 									    mrdy    => mrdy,
 									    clk_1x  => phi2_internal,
 									    clk_2x  => t65_clk,
-									    stretch => open);
+									    stretch => stretch,
+									    phase   => phase);
 	
 	-- T65 Instantiation
 	t65_inst: work.T65 
@@ -9,25 +9,30 @@ entity cpu_clock_gen is
         mrdy    : in  STD_LOGIC;       -- Memory Ready
         clk_1x  : out STD_LOGIC;       -- CPU clock (stretched)
         clk_2x  : out STD_LOGIC;       -- 2x clock for 6502 cores
-        stretch : out STD_LOGIC        -- '1' only when actually stretching
+        stretch : out STD_LOGIC;       -- '1' only when actually stretching
+        phase   : out STD_LOGIC_VECTOR(1 downto 0)  -- count, gray coded (for the SDRAM bridge)
     );
 end cpu_clock_gen;
 
 architecture Behavioral of cpu_clock_gen is
     signal count      : unsigned(1 downto 0) := "00";
     signal count_prev : unsigned(1 downto 0) := "00";
+    signal phase_gray : std_logic_vector(1 downto 0) := "00";
 begin
     process(clk_4x, reset_n)
     begin
         if reset_n = '0' then
             count      <= "00";
             count_prev <= "00";
+            phase_gray <= "00";
         elsif rising_edge(clk_4x) then
             count_prev <= count;
             
             -- Advance counter UNLESS we're at stretch state (count=3) and mrdy='0'
             if not (count = "11" and mrdy = '0') then
                 count <= count + 1;
+                -- gray code of the new count: 00 01 11 10
+                phase_gray <= (count(1) xor count(0)) & (not count(1));
             end if;
         end if;
     end process;
@@ -44,4 +49,11 @@ begin
     -- This happens when count=3, mrdy='0', AND we were already at count=3
     stretch <= '1' when (count = "11" and count_prev = "11" and mrdy = '0') else '0';
     
+    -- Phase prediction for the SDRAM bridge
+    -- Registered gray code of count, one bit changes per clk_4x so it can
+    -- be synchronized into another clock domain. Counts 0 and 1 (phi1,
+    -- E low) are never stretched: once E falls, E rises again exactly two
+    -- clk_4x periods later and the CPU cannot access memory in between.
+    phase <= phase_gray;
+    
 end Behavioral;
\ No newline at end of file
@@ -15,7 +15,8 @@ entity mspi_iface is
         spi_sck     : out std_logic;
         spi_cs_n    : out std_logic;
         spi_mosi    : out std_logic;
-        spi_miso    : in  std_logic
+        spi_miso    : in  std_logic;
+        spi_byte    : out std_logic                      -- one phi2 pulse per byte transferred (pmu)
     );
 end mspi_iface;
 
@@ -84,11 +85,13 @@ begin
          spi_done      <= '1';
 			spi_enable    <= '0';
          spi_start     <= '0';
+         spi_byte      <= '0';
          cpol          <= '0';
          cpha          <= '0';
          spi_divider   <= (others => '1');
 		elsif rising_edge(phi2) then
 			spi_busy_last <= spi_busy;
+			spi_byte      <= '0';
             
          if spi_start = '1' then
 				if spi_busy = '0' and spi_done = '0' then
@@ -107,6 +110,7 @@ begin
 				data_out_reg  <= spi_data_out;
             data_ready    <= '1';
             spi_done      <= '0';
+            spi_byte      <= '1';
          end if;		
 		
 			if cs_n = '0' then
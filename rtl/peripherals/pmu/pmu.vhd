@@ -0,0 +1,241 @@
+--------------------------------------------------------------------------------
+-- Performance Monitoring Unit
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- PMU - Theory of Operation
+--------------------------------------------------------------------------------
+-- Thirteen 32-bit event counters for benchmarks (cc65, BASIC, FatFs...).
+-- Exact numbers instead of the 256-access cache_hitp window.
+--
+-- 1. Counters
+--    0 CPU cycles       phi2 cycles
+--    1 Stretched clocks main_clk (clk_4x) clocks the CPU clock was held by
+--                       mrdy (cpu_clock_gen stretch), 4 per CPU cycle lost
+--    2 Cache hits       )
+--    3 Cache misses     ) sram_sdram_cached_bridge ev_hit/ev_miss/ev_write
+--    4 Cache writes     )
+--    5 SDRAM activates  )
+--    6 SDRAM row hits   ) sdram_controller ev_activate/ev_row_hit/ev_refresh
+--    7 SDRAM refreshes  )
+--    8 SPI bytes        mspi_iface transfers done
+--    9 I-fetch hits     ) bridge ev_ihit/ev_imiss: the opcode fetches
+--   10 I-fetch misses   ) (SYNC) among 2 and 3, data = 2 - 9, 3 - 10
+--   11 Prefetches       ) bridge ev_prefetch/ev_pf_hit: next-line
+--   12 Prefetch hits    ) prefetches started / prefetched lines used
+--
+-- 2. Clock Domains
+--    - CPU cycles and SPI bytes count on phi2
+--    - Stretched clocks count on main_clk: phi2 (clk_1x) is high for
+--      count 2 and 3 of cpu_clock_gen, every further clock with phi2
+--      high is a held count 3, i.e. a stretch
+--    - Cache and SDRAM events count on ev_clk (sdram_clk), one clock
+--      pulse per event
+--    - FREEZE and CLEAR go to main_clk / ev_clk through 2 flops; both
+--      are faster than phi2, so a one phi2 cycle CLEAR is always seen
+--
+-- 3. Register Window (base $C220)
+--    +0 CONTROL R/W: bit 0 FREEZE (1 = all counters hold)
+--                W:   bit 1 CLEAR  (1 = all counters to 0, self clearing)
+--    +1 SELECT  R/W: counter number 0 .. 12
+--    +4 COUNT   32-bit selected counter, little endian (+4 .. +7)
+--               reading +4 latches the whole counter, +5 .. +7 return
+--               the latch: read +4 first
+--
+-- 4. Exact Numbers
+--    - A counter of another clock domain read while running can be torn
+--      between two increments; set FREEZE, read, clear FREEZE
+--    - Typical benchmark: CLEAR, FREEZE = 0, run, FREEZE = 1, read all
+--------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity pmu is
+    port (
+        phi2        : in  std_logic;                     -- CPU clock
+        reset_n     : in  std_logic;                     -- reset active low
+        cs_n        : in  std_logic;                     -- Chip select (active low)
+        rw          : in  std_logic;                     -- Read/Write (low = write)
+        address     : in  std_logic_vector(3 downto 0);  -- Address bits A3..A0
+        data_in     : in  std_logic_vector(7 downto 0);  -- Data from CPU
+        data_out    : out std_logic_vector(7 downto 0);  -- Data to CPU
+        main_clk    : in  std_logic;                     -- cpu_clock_gen clk_4x
+        spi_byte    : in  std_logic := '0';              -- phi2 pulse per SPI byte
+        ev_clk      : in  std_logic := '0';              -- sdram_clk
+        ev_hit      : in  std_logic := '0';              -- ev_clk pulses
+        ev_miss     : in  std_logic := '0';
+        ev_write    : in  std_logic := '0';
+        ev_activate : in  std_logic := '0';
+        ev_row_hit  : in  std_logic := '0';
+        ev_refresh  : in  std_logic := '0';
+        ev_ihit     : in  std_logic := '0';
+        ev_imiss    : in  std_logic := '0';
+        ev_prefetch : in  std_logic := '0';
+        ev_pf_hit   : in  std_logic := '0'
+    );
+end pmu;
+
+architecture rtl of pmu is
+
+    constant NUM_COUNTERS : integer := 13;
+
+    type counter_array is array (natural range <>) of unsigned(31 downto 0);
+    signal cpu_cycles : unsigned(31 downto 0) := (others => '0');   -- counter 0
+    signal stretched  : unsigned(31 downto 0) := (others => '0');   -- counter 1
+    signal events     : counter_array(2 to 7) := (others => (others => '0'));   -- counters 2 to 7
+    signal spi_bytes  : unsigned(31 downto 0) := (others => '0');   -- counter 8
+    signal ext_events : counter_array(9 to 12) := (others => (others => '0'));  -- counters 9 to 12
+    signal selected   : unsigned(31 downto 0);
+
+    signal freeze     : std_logic := '0';
+    signal clear      : std_logic := '0';
+    signal sel        : integer range 0 to NUM_COUNTERS-1 := 0;
+    signal latch      : unsigned(31 downto 0) := (others => '0');
+
+    -- main_clk domain
+    signal m_freeze_meta, m_freeze : std_logic := '0';
+    signal m_clear_meta,  m_clear  : std_logic := '0';
+    signal phi2_high  : integer range 0 to 2 := 0;   -- main_clk clocks phi2 has been high
+
+    -- ev_clk domain
+    signal e_freeze_meta, e_freeze : std_logic := '0';
+    signal e_clear_meta,  e_clear  : std_logic := '0';
+
+begin
+
+    selected <= cpu_cycles when sel = 0 else
+                stretched  when sel = 1 else
+                spi_bytes  when sel = 8 else
+                ext_events(sel) when sel >= 9 else
+                events(sel);
+
+    -- Stretched clocks (main_clk)
+    STRETCH_PROCESS: process(main_clk)
+    begin
+        if rising_edge(main_clk) then
+            m_freeze_meta <= freeze;
+            m_freeze      <= m_freeze_meta;
+            m_clear_meta  <= clear;
+            m_clear       <= m_clear_meta;
+
+            if phi2 = '0' then
+                phi2_high <= 0;
+            elsif phi2_high < 2 then
+                phi2_high <= phi2_high + 1;
+            end if;
+
+            if m_clear = '1' then
+                stretched <= (others => '0');
+            elsif m_freeze = '0' and phi2 = '1' and phi2_high = 2 then
+                stretched <= stretched + 1;
+            end if;
+        end if;
+    end process STRETCH_PROCESS;
+
+    -- Cache and SDRAM events (ev_clk)
+    EVENT_PROCESS: process(ev_clk)
+        variable ev : std_logic_vector(12 downto 2);
+    begin
+        if rising_edge(ev_clk) then
+            e_freeze_meta <= freeze;
+            e_freeze      <= e_freeze_meta;
+            e_clear_meta  <= clear;
+            e_clear       <= e_clear_meta;
+
+            ev := ev_pf_hit & ev_prefetch & ev_imiss & ev_ihit & '0' &
+                  ev_refresh & ev_row_hit & ev_activate & ev_write & ev_miss & ev_hit;
+            for i in 2 to 7 loop
+                if e_clear = '1' then
+                    events(i) <= (others => '0');
+                elsif e_freeze = '0' and ev(i) = '1' then
+                    events(i) <= events(i) + 1;
+                end if;
+            end loop;
+            for i in 9 to 12 loop
+                if e_clear = '1' then
+                    ext_events(i) <= (others => '0');
+                elsif e_freeze = '0' and ev(i) = '1' then
+                    ext_events(i) <= ext_events(i) + 1;
+                end if;
+            end loop;
+        end if;
+    end process EVENT_PROCESS;
+
+    -- CPU cycles, SPI bytes and CPU interface (phi2)
+    CPU_INTERFACE: process(phi2, reset_n)
+    begin
+        if reset_n = '0' then
+            freeze <= '0';
+            clear  <= '1';
+            sel    <= 0;
+        elsif rising_edge(phi2) then
+            clear <= '0';
+
+            if clear = '1' then
+                cpu_cycles <= (others => '0');
+                spi_bytes  <= (others => '0');
+            elsif freeze = '0' then
+                cpu_cycles <= cpu_cycles + 1;
+                if spi_byte = '1' then
+                    spi_bytes <= spi_bytes + 1;
+                end if;
+            end if;
+
+            if cs_n = '0' then
+                case address is
+                    when "0000" => -- 0xC220 Control Register
+                        if rw = '0' then
+                            freeze <= data_in(0);
+                            clear  <= data_in(1);
+                        else
+                            data_out <= "0000000" & freeze;
+                        end if;
+
+                    when "0001" => -- 0xC221 Counter Select
+                        if rw = '0' then
+                            if to_integer(unsigned(data_in)) < NUM_COUNTERS then
+                                sel <= to_integer(unsigned(data_in));
+                            end if;
+                        else
+                            data_out <= std_logic_vector(to_unsigned(sel, 8));
+                        end if;
+
+                    when "0100" => -- 0xC224 Count bits 7..0 (latches the counter)
+                        if rw = '1' then
+                            latch    <= selected;
+                            data_out <= std_logic_vector(selected(7 downto 0));
+                        end if;
+
+                    when "0101" => -- 0xC225 Count bits 15..8
+                        data_out <= std_logic_vector(latch(15 downto 8));
+
+                    when "0110" => -- 0xC226 Count bits 23..16
+                        data_out <= std_logic_vector(latch(23 downto 16));
+
+                    when "0111" => -- 0xC227 Count bits 31..24
+                        data_out <= std_logic_vector(latch(31 downto 24));
+
+                    when others =>
+                        data_out <= (others => '0');
+                end case;
+            end if;
+        end if;
+    end process CPU_INTERFACE;
+
+end architecture rtl;
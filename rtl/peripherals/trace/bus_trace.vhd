@@ -0,0 +1,302 @@
+--------------------------------------------------------------------------------
+-- CPU Bus Trace Buffer
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- Bus Trace - Theory of Operation
+--------------------------------------------------------------------------------
+-- A small logic analyzer in block RAM: one entry per CPU cycle, circular,
+-- with a trigger and a post-trigger count. Shows where the stall cycles
+-- go in real programs (BASIC, games, FatFs) without probing the debug
+-- pins.
+--
+-- 1. Entry (40 bits, 2**DEPTH_LOG2 entries, 1024 = 5 M9K)
+--    byte 0/1  address
+--    byte 2    data (read or written)
+--    byte 3    bit 0 R/W, bit 1 SYNC (opcode fetch), bit 2 stretched,
+--              bit 3 trigger entry, bits 7:4 stretched clocks (max 15)
+--    byte 4    ext: board state (e.g. bridge state / debug), sampled
+--              with the cycle
+--
+-- 2. Capture (main_clk)
+--    - Every main_clk clock with phi2 high samples the bus, the falling
+--      edge of phi2 writes the last sample: address and data are valid
+--      at the end of the cycle
+--    - Stretched clocks: phi2 high for more than 2 clk_4x clocks
+--      (held count 3 of cpu_clock_gen, like the PMU)
+--
+-- 3. Trigger (CONTROL bits 3:2)
+--    00 immediate:  the first cycle after ARM
+--    01 address:    (address and MASK) = (COMPARE and MASK)
+--    10 opcode:     SYNC cycle with (data and MASK) = (COMPARE and MASK),
+--                   low bytes only
+--    11 PC:         SYNC cycle with the address condition
+--    - Recording runs from ARM (pre-trigger history), the trigger entry
+--      is flagged, POST more entries are recorded, then it stops
+--    - POST >= depth: the history before the trigger is overwritten
+--
+-- 4. Register Window (base $C230)
+--    +0  CONTROL  W: bit 0 = 1 ARM (clear, record), bit 1 = 1 STOP,
+--                    bits 3:2 trigger mode
+--                 R: bit 0 RUNNING, bit 1 TRIGGERED, bits 3:2 mode
+--    +1  COMPARE  low, +2 high
+--    +3  MASK     low, +4 high (1 = bit compared)
+--    +5  POST     low, +6 high
+--    +7  INDEX    low, +8 high: entry to read, 0 = oldest
+--    +9  COUNT    low, +10 high: entries recorded (read only)
+--    +11 .. +15   entry bytes 0 .. 4, reading +15 increments INDEX
+--    - Dump: STOP (or wait for RUNNING = 0), INDEX = 0, then COUNT
+--      times read +11 .. +15
+--
+-- 5. Clock Domains
+--    - Registers and the RAM read port on phi2, capture on main_clk
+--    - ARM / STOP are toggles through 2 flops, RUNNING / TRIGGERED come
+--      back through 2 flops; COMPARE, MASK, POST are static while armed
+--    - INDEX / COUNT are stable once RUNNING = 0
+--------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity bus_trace is
+    generic (
+        DEPTH_LOG2  : integer := 10                      -- 2**DEPTH_LOG2 entries (max 16)
+    );
+    port (
+        phi2        : in  std_logic;                     -- CPU clock
+        reset_n     : in  std_logic;                     -- reset active low
+        cs_n        : in  std_logic;                     -- Chip select (active low)
+        rw          : in  std_logic;                     -- Read/Write (low = write)
+        address     : in  std_logic_vector(3 downto 0);  -- Address bits A3..A0
+        data_in     : in  std_logic_vector(7 downto 0);  -- Data from CPU
+        data_out    : out std_logic_vector(7 downto 0);  -- Data to CPU
+        main_clk    : in  std_logic;                     -- cpu_clock_gen clk_4x
+        bus_address : in  std_logic_vector(15 downto 0); -- traced bus
+        bus_data    : in  std_logic_vector(7 downto 0);
+        bus_rw      : in  std_logic;
+        bus_sync    : in  std_logic;
+        ext         : in  std_logic_vector(7 downto 0) := (others => '0')
+    );
+end bus_trace;
+
+architecture rtl of bus_trace is
+
+    constant DEPTH : integer := 2 ** DEPTH_LOG2;
+
+    type trace_ram_type is array (0 to DEPTH-1) of std_logic_vector(39 downto 0);
+    signal trace_ram   : trace_ram_type;
+
+    -- CPU side (phi2)
+    signal arm_toggle  : std_logic := '0';
+    signal stop_toggle : std_logic := '0';
+    signal mode        : std_logic_vector(1 downto 0) := "00";
+    signal compare     : std_logic_vector(15 downto 0) := (others => '0');
+    signal mask        : std_logic_vector(15 downto 0) := (others => '0');
+    signal post        : unsigned(15 downto 0) := to_unsigned(DEPTH / 2, 16);
+    signal index       : unsigned(15 downto 0) := (others => '0');
+    signal rd_addr     : unsigned(DEPTH_LOG2-1 downto 0);
+    signal q           : std_logic_vector(39 downto 0) := (others => '0');
+    signal running_meta, running_cpu     : std_logic := '0';
+    signal triggered_meta, triggered_cpu : std_logic := '0';
+
+    -- Capture side (main_clk)
+    signal arm_meta, arm_sync, arm_prev    : std_logic := '0';
+    signal stop_meta, stop_sync, stop_prev : std_logic := '0';
+    signal running     : std_logic := '0';
+    signal triggered   : std_logic := '0';
+    signal wptr        : unsigned(DEPTH_LOG2-1 downto 0) := (others => '0');
+    signal count       : unsigned(16 downto 0) := (others => '0');  -- entries recorded (to DEPTH)
+    signal post_left   : unsigned(15 downto 0) := (others => '0');
+    signal phi2_prev   : std_logic := '0';
+    signal phi2_high   : integer range 0 to 2 := 0;
+    signal s_address   : std_logic_vector(15 downto 0) := (others => '0');
+    signal s_data      : std_logic_vector(7 downto 0) := (others => '0');
+    signal s_rw        : std_logic := '1';
+    signal s_sync      : std_logic := '0';
+    signal s_ext       : std_logic_vector(7 downto 0) := (others => '0');
+    signal s_stretch   : unsigned(3 downto 0) := (others => '0');
+    signal match       : std_logic;
+
+begin
+
+    assert DEPTH_LOG2 >= 4 and DEPTH_LOG2 <= 16
+        report "bus_trace: DEPTH_LOG2 must be 4 to 16" severity failure;
+
+    -- Trigger condition on the last sample of the cycle
+    process(mode, compare, mask, s_address, s_data, s_sync)
+    begin
+        match <= '0';
+        case mode is
+            when "00" =>
+                match <= '1';
+            when "01" =>
+                if (s_address and mask) = (compare and mask) then
+                    match <= '1';
+                end if;
+            when "10" =>
+                if s_sync = '1' and (s_data and mask(7 downto 0)) = (compare(7 downto 0) and mask(7 downto 0)) then
+                    match <= '1';
+                end if;
+            when others =>
+                if s_sync = '1' and (s_address and mask) = (compare and mask) then
+                    match <= '1';
+                end if;
+        end case;
+    end process;
+
+    -- Capture process (runs on main_clk)
+    CAPTURE_PROCESS: process(main_clk)
+        variable flags : std_logic_vector(7 downto 0);
+    begin
+        if rising_edge(main_clk) then
+            arm_meta  <= arm_toggle;
+            arm_sync  <= arm_meta;
+            arm_prev  <= arm_sync;
+            stop_meta <= stop_toggle;
+            stop_sync <= stop_meta;
+            stop_prev <= stop_sync;
+            phi2_prev <= phi2;
+
+            if phi2 = '1' then
+                -- Sample the bus while phi2 is high, the last sample is written
+                s_address <= bus_address;
+                s_data    <= bus_data;
+                s_rw      <= bus_rw;
+                s_sync    <= bus_sync;
+                s_ext     <= ext;
+                if phi2_high < 2 then
+                    phi2_high <= phi2_high + 1;
+                elsif s_stretch /= 15 then
+                    s_stretch <= s_stretch + 1;
+                end if;
+            else
+                phi2_high <= 0;
+                s_stretch <= (others => '0');
+            end if;
+
+            if arm_sync /= arm_prev then
+                running   <= '1';
+                triggered <= '0';
+                wptr      <= (others => '0');
+                count     <= (others => '0');
+            elsif stop_sync /= stop_prev then
+                running   <= '0';
+            elsif phi2_prev = '1' and phi2 = '0' then
+                -- End of a CPU cycle
+                if running = '1' then
+                    flags(0) := s_rw;
+                    flags(1) := s_sync;
+                    flags(2) := '0';
+                    if s_stretch /= 0 then
+                        flags(2) := '1';
+                    end if;
+                    flags(3) := match and not triggered;
+                    flags(7 downto 4) := std_logic_vector(s_stretch);
+                    trace_ram(to_integer(wptr)) <= s_ext & flags & s_data & s_address;
+                    wptr <= wptr + 1;
+                    if count /= DEPTH then
+                        count <= count + 1;
+                    end if;
+                    if triggered = '0' then
+                        if match = '1' then
+                            triggered <= '1';
+                            post_left <= post;
+                            if post = 0 then
+                                running <= '0';
+                            end if;
+                        end if;
+                    elsif post_left = 1 then
+                        running   <= '0';
+                    else
+                        post_left <= post_left - 1;
+                    end if;
+                end if;
+            end if;
+        end if;
+    end process CAPTURE_PROCESS;
+
+    -- Read port: entry INDEX counted from the oldest one
+    rd_addr <= wptr + index(DEPTH_LOG2-1 downto 0) when count = DEPTH else
+               index(DEPTH_LOG2-1 downto 0);
+
+    -- CPU interface process (runs on phi2)
+    CPU_INTERFACE: process(phi2, reset_n)
+    begin
+        if reset_n = '0' then
+            arm_toggle  <= '0';
+            stop_toggle <= '0';
+            mode        <= "00";
+            index       <= (others => '0');
+        elsif rising_edge(phi2) then
+            q              <= trace_ram(to_integer(rd_addr));
+            running_meta   <= running;
+            running_cpu    <= running_meta;
+            triggered_meta <= triggered;
+            triggered_cpu  <= triggered_meta;
+
+            if cs_n = '0' then
+                case address is
+                    when "0000" => -- 0xC230 Control Register
+                        if rw = '0' then
+                            mode <= data_in(3 downto 2);
+                            if data_in(0) = '1' then
+                                arm_toggle <= not arm_toggle;
+                            elsif data_in(1) = '1' then
+                                stop_toggle <= not stop_toggle;
+                            end if;
+                        else
+                            data_out <= "0000" & mode & triggered_cpu & running_cpu;
+                        end if;
+
+                    when "0001" => -- 0xC231 Compare Low
+                        if rw = '0' then compare(7 downto 0)  <= data_in; else data_out <= compare(7 downto 0);  end if;
+                    when "0010" => -- 0xC232 Compare High
+                        if rw = '0' then compare(15 downto 8) <= data_in; else data_out <= compare(15 downto 8); end if;
+                    when "0011" => -- 0xC233 Mask Low
+                        if rw = '0' then mask(7 downto 0)     <= data_in; else data_out <= mask(7 downto 0);     end if;
+                    when "0100" => -- 0xC234 Mask High
+                        if rw = '0' then mask(15 downto 8)    <= data_in; else data_out <= mask(15 downto 8);    end if;
+                    when "0101" => -- 0xC235 Post Low
+                        if rw = '0' then post(7 downto 0)     <= unsigned(data_in); else data_out <= std_logic_vector(post(7 downto 0));  end if;
+                    when "0110" => -- 0xC236 Post High
+                        if rw = '0' then post(15 downto 8)    <= unsigned(data_in); else data_out <= std_logic_vector(post(15 downto 8)); end if;
+                    when "0111" => -- 0xC237 Index Low
+                        if rw = '0' then index(7 downto 0)    <= unsigned(data_in); else data_out <= std_logic_vector(index(7 downto 0));  end if;
+                    when "1000" => -- 0xC238 Index High
+                        if rw = '0' then index(15 downto 8)   <= unsigned(data_in); else data_out <= std_logic_vector(index(15 downto 8)); end if;
+
+                    when "1001" => -- 0xC239 Count Low
+                        data_out <= std_logic_vector(count(7 downto 0));
+                    when "1010" => -- 0xC23A Count High (DEPTH = 65536 reads as 0)
+                        data_out <= std_logic_vector(count(15 downto 8));
+
+                    when "1011" => data_out <= q(7 downto 0);    -- 0xC23B address low
+                    when "1100" => data_out <= q(15 downto 8);   -- 0xC23C address high
+                    when "1101" => data_out <= q(23 downto 16);  -- 0xC23D data
+                    when "1110" => data_out <= q(31 downto 24);  -- 0xC23E flags
+                    when others =>                               -- 0xC23F ext, next entry
+                        data_out <= q(39 downto 32);
+                        if rw = '1' then
+                            index <= index + 1;
+                        end if;
+                end case;
+            end if;
+        end if;
+    end process CPU_INTERFACE;
+
+end architecture rtl;
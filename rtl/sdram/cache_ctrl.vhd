@@ -0,0 +1,265 @@
+--------------------------------------------------------------------------------
+-- Cache Control Registers
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- Cache Control - Theory of Operation
+--------------------------------------------------------------------------------
+-- CPU register window for sram_sdram_cached_bridge: runtime enable,
+-- invalidation, flush, line locking and exact hit / miss counters, so
+-- loaders and cc65 programs can keep the cache coherent and measure
+-- themselves.
+--
+-- 1. Register Window (base = cache_ctrl window, e.g. $C250)
+--    +0  CONTROL  R/W: bit 0 ENABLE (reset 1, 0 = every access goes to
+--                      SDRAM, the cache is invalidated when it comes back)
+--                 R:   bit 7 BUSY (command running)
+--                      bit 6 FULL (last PRELOAD skipped lines: every way
+--                      of their set was locked already)
+--    +1  COMMAND  W: 1 INVALIDATE ALL   every line (dirty data dropped)
+--                    2 INVALIDATE LINE  the line holding ADDR
+--                    3 FLUSH            write back the dirty lines, drain
+--                                       the posted writes
+--                    4 LOCK             lock the cached lines of ADDR..END
+--                    5 UNLOCK ALL
+--                    6 CLEAR            HITS and MISSES to 0
+--                    7 PRELOAD          fetch the missing lines of
+--                                       ADDR..END and lock them all
+--                 R: last command
+--                 Ignored while BUSY: poll CONTROL bit 7 before the next
+--    +2  ADDR     R/W: 16-bit CPU address, little endian (+2 .. +3)
+--    +4  HITS     32-bit, little endian (+4 .. +7), reading +4 latches
+--    +8  MISSES   32-bit, little endian (+8 .. +11), reading +8 latches
+--                 (read the low byte first, like the pmu)
+--    +12 END      R/W: last address of the LOCK / PRELOAD range
+--                      (+12 .. +13)
+--
+-- 2. Typical Use
+--    - After loading code into SDRAM behind the cache (DMA, SD card,
+--      a loader writing through another path): INVALIDATE ALL
+--    - Self-modifying code with WRITE_BACK: FLUSH, then INVALIDATE LINE
+--    - Scratchpad: set ADDR and END around the routine, PRELOAD, wait
+--      for BUSY to drop; it then never misses (see the bridge, 15.).
+--      FULL set: the range is larger than the lockable ways of its sets
+--    - UNLOCK ALL gives the ways back to the rest of the program
+--    - Benchmark: CLEAR, run, read HITS and MISSES
+--
+-- 3. Clock Domains
+--    - Registers on phi2, commands to sdram_clk as a toggle (2 flops),
+--      the engine answers with an acknowledge toggle once maint_busy /
+--      flush_busy of the bridge are low again (2 flops back)
+--    - ADDR, END and the command are static while BUSY
+--    - ENABLE is a level, 2 flops into sdram_clk
+--    - FULL is a level from the bridge, static while not BUSY, 2 flops
+--      into phi2
+--    - HITS / MISSES count ev_hit / ev_miss on clk; they only move
+--      during CPU accesses to the SDRAM window, so they are stable when
+--      the CPU reads them
+--------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+entity cache_ctrl is
+    generic (
+        ADDR_BITS      : integer := 16      -- bridge sram_addr width
+    );
+    port (
+        -- CPU register window
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+
+        -- Bridge side (sdram_clk)
+        clk            : in  std_logic;
+        cache_en       : out std_logic;
+        flush          : out std_logic;
+        flush_busy     : in  std_logic := '0';
+        maint_req      : out std_logic;
+        maint_op       : out std_logic_vector(2 downto 0) := "000";
+        maint_lo       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_hi       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_busy     : in  std_logic := '0';
+        maint_full     : in  std_logic := '0';
+        ev_hit         : in  std_logic := '0';
+        ev_miss        : in  std_logic := '0'
+    );
+end cache_ctrl;
+
+architecture rtl of cache_ctrl is
+
+    constant CMD_INVALIDATE_ALL  : integer := 1;
+    constant CMD_INVALIDATE_LINE : integer := 2;
+    constant CMD_FLUSH           : integer := 3;
+    constant CMD_LOCK            : integer := 4;
+    constant CMD_UNLOCK_ALL      : integer := 5;
+    constant CMD_CLEAR           : integer := 6;
+    constant CMD_PRELOAD         : integer := 7;
+
+    -- CPU side (phi2)
+    signal enable        : std_logic := '1';
+    signal command       : integer range 0 to 7 := 0;
+    signal cmd_toggle    : std_logic := '0';
+    signal ack_meta      : std_logic := '0';
+    signal ack_cpu       : std_logic := '0';
+    signal busy          : std_logic;
+    signal full_meta     : std_logic := '0';
+    signal full_cpu      : std_logic := '0';
+    signal addr_lo       : std_logic_vector(15 downto 0) := (others => '0');
+    signal addr_hi       : std_logic_vector(15 downto 0) := (others => '0');
+    signal hits_latch    : unsigned(31 downto 0) := (others => '0');
+    signal misses_latch  : unsigned(31 downto 0) := (others => '0');
+
+    -- Engine side (clk)
+    signal en_meta       : std_logic := '1';
+    signal en_sync       : std_logic := '1';
+    signal cmd_meta      : std_logic := '0';
+    signal cmd_sync      : std_logic := '0';
+    signal cmd_prev      : std_logic := '0';
+    signal ack_toggle    : std_logic := '0';
+    signal waiting       : std_logic := '0';
+    signal settle        : integer range 0 to 3 := 0;
+    signal hits          : unsigned(31 downto 0) := (others => '0');
+    signal misses        : unsigned(31 downto 0) := (others => '0');
+
+begin
+
+    busy     <= cmd_toggle xor ack_cpu;
+    cache_en <= en_sync;
+    maint_lo <= std_logic_vector(resize(unsigned(addr_lo), ADDR_BITS));
+    maint_hi <= std_logic_vector(resize(unsigned(addr_hi), ADDR_BITS));
+
+    --========================================
+    -- CPU register window (phi2)
+    --========================================
+
+    process(phi2, cpu_reset_n)
+    begin
+        if cpu_reset_n = '0' then
+            enable     <= '1';
+            command    <= 0;
+        elsif rising_edge(phi2) then
+            ack_meta <= ack_toggle;
+            ack_cpu  <= ack_meta;
+            full_meta <= maint_full;
+            full_cpu  <= full_meta;
+
+            if cs_n = '0' then
+                case address is
+                    when "0000" => -- CONTROL
+                        if rw = '0' then
+                            enable <= data_in(0);
+                        else
+                            data_out <= busy & full_cpu & "00000" & enable;
+                        end if;
+
+                    when "0001" => -- COMMAND
+                        if rw = '0' then
+                            if busy = '0' and to_integer(unsigned(data_in)) >= CMD_INVALIDATE_ALL and
+                               to_integer(unsigned(data_in)) <= CMD_PRELOAD then
+                                command    <= to_integer(unsigned(data_in(2 downto 0)));
+                                cmd_toggle <= not cmd_toggle;
+                            end if;
+                        else
+                            data_out <= std_logic_vector(to_unsigned(command, 8));
+                        end if;
+
+                    when "0010" =>
+                        if rw = '0' then addr_lo(7 downto 0)  <= data_in; else data_out <= addr_lo(7 downto 0);  end if;
+                    when "0011" =>
+                        if rw = '0' then addr_lo(15 downto 8) <= data_in; else data_out <= addr_lo(15 downto 8); end if;
+                    when "1100" =>
+                        if rw = '0' then addr_hi(7 downto 0)  <= data_in; else data_out <= addr_hi(7 downto 0);  end if;
+                    when "1101" =>
+                        if rw = '0' then addr_hi(15 downto 8) <= data_in; else data_out <= addr_hi(15 downto 8); end if;
+
+                    when "0100" =>
+                        hits_latch <= hits;
+                        data_out   <= std_logic_vector(hits(7 downto 0));
+                    when "0101" => data_out <= std_logic_vector(hits_latch(15 downto 8));
+                    when "0110" => data_out <= std_logic_vector(hits_latch(23 downto 16));
+                    when "0111" => data_out <= std_logic_vector(hits_latch(31 downto 24));
+                    when "1000" =>
+                        misses_latch <= misses;
+                        data_out     <= std_logic_vector(misses(7 downto 0));
+                    when "1001" => data_out <= std_logic_vector(misses_latch(15 downto 8));
+                    when "1010" => data_out <= std_logic_vector(misses_latch(23 downto 16));
+                    when "1011" => data_out <= std_logic_vector(misses_latch(31 downto 24));
+                    when others => data_out <= (others => '0');
+                end case;
+            end if;
+        end if;
+    end process;
+
+    --========================================
+    -- Engine (clk)
+    --========================================
+    -- A new command toggle starts one bridge operation (or clears the
+    -- counters), settle covers the clocks before the bridge shows busy,
+    -- then the acknowledge toggle follows once it is idle again.
+
+    process(clk)
+    begin
+        if rising_edge(clk) then
+            en_meta  <= enable;
+            en_sync  <= en_meta;
+            cmd_meta <= cmd_toggle;
+            cmd_sync <= cmd_meta;
+
+            flush     <= '0';
+            maint_req <= '0';
+
+            if ev_hit = '1' then
+                hits <= hits + 1;
+            end if;
+            if ev_miss = '1' then
+                misses <= misses + 1;
+            end if;
+
+            if cmd_sync /= cmd_prev then
+                cmd_prev <= cmd_sync;
+                waiting  <= '1';
+                settle   <= 3;
+                case command is
+                    when CMD_INVALIDATE_ALL  => maint_req <= '1'; maint_op <= "000";
+                    when CMD_INVALIDATE_LINE => maint_req <= '1'; maint_op <= "001";
+                    when CMD_LOCK            => maint_req <= '1'; maint_op <= "010";
+                    when CMD_UNLOCK_ALL      => maint_req <= '1'; maint_op <= "011";
+                    when CMD_PRELOAD         => maint_req <= '1'; maint_op <= "100";
+                    when CMD_FLUSH           => flush     <= '1';
+                    when CMD_CLEAR           =>
+                        hits   <= (others => '0');
+                        misses <= (others => '0');
+                    when others              => null;
+                end case;
+            elsif waiting = '1' then
+                if settle /= 0 then
+                    settle <= settle - 1;
+                elsif maint_busy = '0' and flush_busy = '0' then
+                    waiting    <= '0';
+                    ack_toggle <= cmd_sync;
+                end if;
+            end if;
+        end if;
+    end process;
+
+end rtl;
@@ -0,0 +1,215 @@
+--------------------------------------------------------------------------------
+-- SDRAM Multi-Port Arbiter
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- SDRAM Arbiter - Theory of Operation
+--------------------------------------------------------------------------------
+-- Shares one sdram_controller between NUM_PORTS clients (CPU bridge, SPI
+-- DMA, video/readback, host loader...). Sits between the clients and the
+-- controller, same clock (sdram_clk).
+--
+-- 1. Client Interface
+--    - Every port is a copy of the controller interface:
+--      req, wr_n, addr, din, byte_en, burst -> ack, dvalid, ready
+--    - Ports are packed in flat vectors, port i uses:
+--      * p_req(i), p_wr_n(i), p_burst(i), p_ack(i), p_dvalid(i), p_ready(i)
+--      * p_addr((i+1)*ADDR_WIDTH-1 downto i*ADDR_WIDTH)
+--      * p_din((i+1)*16-1 downto i*16)
+--      * p_byte_en((i+1)*2-1 downto i*2)
+--    - dout is shared: valid for port i when p_ack(i) or p_dvalid(i)
+--    - Protocol unchanged: wait for p_ready, assert req, hold it (and
+--      the address/data) until ack, drop it on ack
+--
+-- 2. Arbitration (one request in the controller at a time)
+--    - ROUND_ROBIN = false: fixed priority, port 0 highest
+--      (put the CPU bridge on port 0)
+--    - ROUND_ROBIN = true: the search starts after the last served
+--      port, every requester is served within NUM_PORTS requests
+--    - A grant is taken when the controller is ready and held until the
+--      controller acks (last beat of a burst)
+--
+-- 3. Back-pressure
+--    - p_ready(i) = '1' only when no request is in service, the
+--      controller is ready and port i is the one that would be granted
+--      (the winner, or any port while nobody requests): a client that
+--      sees it low waits
+--    - A client that already holds req keeps its place; it is granted
+--      as soon as the current request is acked
+--
+-- 4. Shared Bank State
+--    - All ports go to the same controller, so an open row left by one
+--      client is a row hit for the others
+--    - The controller look-ahead (next_req/next_addr) gets the request
+--      that will be granted next when another port is waiting, else the
+--      own hint of the port in service (p_next_req/p_next_addr): the
+--      bank of the next client is opened behind the current access
+--
+-- 5. Re-latch Protection
+--    - The controller may be back in IDLE in the cycle it acks (single
+--      reads). req is masked with ack so the request is not taken twice
+--------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+entity sdram_arbiter is
+    generic (
+        NUM_PORTS      : integer := 2;      -- number of clients
+        ADDR_WIDTH     : integer := 25;     -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+        ROUND_ROBIN    : boolean := false   -- false = fixed priority (port 0 first), true = round-robin
+    );
+    port (
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+
+        -- Client ports (packed, see 1.)
+        p_req          : in  std_logic_vector(NUM_PORTS-1 downto 0);
+        p_wr_n         : in  std_logic_vector(NUM_PORTS-1 downto 0);
+        p_addr         : in  std_logic_vector(NUM_PORTS*ADDR_WIDTH-1 downto 0);
+        p_din          : in  std_logic_vector(NUM_PORTS*16-1 downto 0);
+        p_byte_en      : in  std_logic_vector(NUM_PORTS*2-1 downto 0);
+        p_burst        : in  std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+        p_next_req     : in  std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+        p_next_addr    : in  std_logic_vector(NUM_PORTS*ADDR_WIDTH-1 downto 0) := (others => '0');
+        p_dout         : out std_logic_vector(15 downto 0);
+        p_ready        : out std_logic_vector(NUM_PORTS-1 downto 0);
+        p_ack          : out std_logic_vector(NUM_PORTS-1 downto 0);
+        p_dvalid       : out std_logic_vector(NUM_PORTS-1 downto 0);
+
+        -- sdram_controller side
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0';
+        next_req       : out std_logic;
+        next_addr      : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+
+        -- Debug
+        grant_port     : out integer range 0 to NUM_PORTS-1
+    );
+end sdram_arbiter;
+
+architecture rtl of sdram_arbiter is
+
+    -- Next port to serve: first requester at or after 'first' (wrapping)
+    function pick(reqs : std_logic_vector; first : integer) return integer is
+        variable p : integer;
+    begin
+        for i in 0 to NUM_PORTS-1 loop
+            p := (first + i) mod NUM_PORTS;
+            if reqs(p) = '1' then
+                return p;
+            end if;
+        end loop;
+        return first;
+    end function;
+
+    signal busy        : std_logic := '0';                        -- a request is in the controller
+    signal grant       : integer range 0 to NUM_PORTS-1 := 0;     -- port in service
+    signal last        : integer range 0 to NUM_PORTS-1 := NUM_PORTS-1;  -- last port served (round-robin)
+    signal first       : integer range 0 to NUM_PORTS-1;          -- where the search starts
+    signal winner      : integer range 0 to NUM_PORTS-1;          -- next port to grant
+
+begin
+
+    assert NUM_PORTS >= 1
+        report "sdram_arbiter: NUM_PORTS must be at least 1" severity failure;
+
+    first  <= (last + 1) mod NUM_PORTS when ROUND_ROBIN else 0;
+    winner <= pick(p_req, first);
+
+    --========================================
+    -- Grant
+    --========================================
+    -- IDLE (busy='0'): grant the winner when the controller is ready
+    -- BUSY (busy='1'): forward the request until the controller acks
+
+    process(clk)
+    begin
+        if rising_edge(clk) then
+            if reset_n = '0' then
+                busy  <= '0';
+                grant <= 0;
+                last  <= NUM_PORTS-1;
+            elsif busy = '0' then
+                if ready = '1' and p_req /= (p_req'range => '0') then
+                    grant <= winner;
+                    busy  <= '1';
+                end if;
+            elsif ack = '1' then
+                last <= grant;
+                busy <= '0';
+            end if;
+        end if;
+    end process;
+
+    --========================================
+    -- Controller side mux
+    --========================================
+
+    req     <= busy and p_req(grant) and not ack;
+    wr_n    <= p_wr_n(grant);
+    addr    <= p_addr((grant+1)*ADDR_WIDTH-1 downto grant*ADDR_WIDTH);
+    din     <= p_din((grant+1)*16-1 downto grant*16);
+    byte_en <= p_byte_en((grant+1)*2-1 downto grant*2);
+    burst   <= p_burst(grant);
+
+    -- Look-ahead: the next port to be granted, else the hint of the
+    -- port in service
+    process(p_req, p_next_req, p_addr, p_next_addr, busy, grant)
+        variable w : std_logic_vector(NUM_PORTS-1 downto 0);  -- requests not in service
+        variable n : integer range 0 to NUM_PORTS-1;
+    begin
+        w := p_req;
+        w(grant) := '0';
+        if ROUND_ROBIN then
+            n := pick(w, (grant + 1) mod NUM_PORTS);
+        else
+            n := pick(w, 0);
+        end if;
+        if busy = '1' and w /= (w'range => '0') then
+            next_req  <= '1';
+            next_addr <= p_addr((n+1)*ADDR_WIDTH-1 downto n*ADDR_WIDTH);
+        else
+            next_req  <= busy and p_next_req(grant);
+            next_addr <= p_next_addr((grant+1)*ADDR_WIDTH-1 downto grant*ADDR_WIDTH);
+        end if;
+    end process;
+
+    --========================================
+    -- Client side
+    --========================================
+
+    p_dout <= dout;
+
+    ports : for i in 0 to NUM_PORTS-1 generate
+        p_ack(i)    <= ack    when busy = '1' and grant = i else '0';
+        p_dvalid(i) <= dvalid when busy = '1' and grant = i else '0';
+        p_ready(i)  <= ready and not busy when p_req = (p_req'range => '0') or winner = i else '0';
+    end generate;
+
+    grant_port <= grant;
+
+end rtl;
@@ -0,0 +1,449 @@
+--------------------------------------------------------------------------------
+-- SDRAM Built-In Self Test
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- SDRAM BIST - Theory of Operation
+--------------------------------------------------------------------------------
+-- Hardware memory test on the client port of sdram_controller, running at
+-- the full SDRAM clock. Started and read back by the CPU through a 16
+-- byte register window. Replaces hours of software/projects/test-sdram
+-- loops ($E000-$EFFF, 4 patterns) by seconds over the whole chip.
+--
+-- 1. Placement
+--    - Between the client (bridge, arbiter or trainer) and the controller,
+--      same clock (sdram_clk)
+--    - Idle: everything passes straight through
+--    - Running: the client sees ready = '0' (its requests wait), the CPU
+--      keeps running from ROM / internal RAM and polls STATUS
+--    - A test starts only when the client has no request pending
+--
+-- 2. Tests (CONTROL bits 2:1), region = words 0 .. 2**SIZE-1
+--    00 March C-:  any(w0) up(r0,w1) up(r1,w0) dn(r0,w1) dn(r1,w0) any(r0)
+--                  0 = x"0000", 1 = x"FFFF" (stuck-at, transition and
+--                  coupling faults)
+--    01 Walking ones: 16 rounds of write all / read all, word a holds
+--                  x"0001" rotated left by (a + round) mod 16
+--    10 Address in address: the word address folded to 16 bits, then
+--                  its complement (address lines, aliasing)
+--    11 Random:    32-bit LFSR, write all then read all with the same
+--                  seed (data dependent faults)
+--
+-- 3. Measurements (32-bit)
+--    - ERRORS:   words read back with a wrong value
+--    - ACCESSES: SDRAM requests acked (reads + writes)
+--    - CYCLES:   sdram_clk cycles from start to done
+--    - words/second = ACCESSES * FREQ_MHZ * 1e6 / CYCLES
+--    - cycles per access = CYCLES / ACCESSES
+--    - The CPU reads a copy taken when DONE reaches phi2 (see 5.): the
+--      registers and FAIL hold the last finished test, also while BUSY
+--
+-- 4. Register Window (base = BIST window, e.g. $C240)
+--    +0  CONTROL  W: bit 0 = 1 start, bits 2:1 test
+--                 R: bit 0 BUSY, bit 1 DONE, bit 2 FAIL, bits 5:4 test
+--    +1  SIZE     R/W: log2 of the region in words (4 .. ADDR_WIDTH),
+--                 reset value ADDR_WIDTH (whole chip)
+--    +4  ERRORS   32-bit, little endian (+4 .. +7)
+--    +8  ACCESSES 32-bit, little endian (+8 .. +11)
+--    +12 CYCLES   32-bit, little endian (+12 .. +15)
+--
+-- 5. Clock Domains
+--    - CPU registers on phi2, engine on clk
+--    - start is a toggle (phi2 -> clk, 2 flops), BUSY/DONE go back
+--      through 2 flops; test and size are static while BUSY
+--    - The 32-bit counters are never read across the domains while they
+--      count: they are static once done is set, and copied on the phi2
+--      edge where the synchronized DONE rises (no torn reads)
+--    - FAIL = copied ERRORS /= 0
+--
+-- 6. Re-latch Protection
+--    - Same as sdram_arbiter: the test req is masked with ack
+--
+-- The region is overwritten: run it before loading anything in SDRAM.
+--------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+entity sdram_bist is
+    generic (
+        ADDR_WIDTH     : integer := 25      -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+    );
+    port (
+        -- CPU register window
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+
+        -- SDRAM side
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+
+        -- Client side
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+
+        -- sdram_controller side
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0'
+    );
+end sdram_bist;
+
+architecture rtl of sdram_bist is
+
+    constant LFSR_SEED : std_logic_vector(31 downto 0) := x"ACE12468";
+
+    -- Address folded to 16 bits (address in address test)
+    function fold(a : unsigned) return std_logic_vector is
+        variable v : std_logic_vector(15 downto 0) := (others => '0');
+    begin
+        for i in a'range loop
+            v(i mod 16) := v(i mod 16) xor a(i);
+        end loop;
+        return v;
+    end function;
+
+    -- CPU side (phi2)
+    signal start_toggle  : std_logic := '0';
+    signal test_sel      : std_logic_vector(1 downto 0) := "00";
+    signal size_log2     : integer range 4 to ADDR_WIDTH := ADDR_WIDTH;
+    signal busy_meta, busy_cpu : std_logic := '0';
+    signal done_meta, done_cpu : std_logic := '0';
+    signal fail_cpu      : std_logic := '0';
+    signal errors_cpu    : unsigned(31 downto 0) := (others => '0');  -- copies taken at DONE
+    signal accesses_cpu  : unsigned(31 downto 0) := (others => '0');
+    signal cycles_cpu    : unsigned(31 downto 0) := (others => '0');
+
+    -- Engine side (clk)
+    type bist_state_type is (B_IDLE, B_START, B_READ, B_READ_ACK, B_WRITE, B_WRITE_ACK, B_NEXT);
+    signal b_state       : bist_state_type := B_IDLE;
+    signal start_meta    : std_logic := '0';
+    signal start_sync    : std_logic := '0';
+    signal start_prev    : std_logic := '0';
+    signal running       : std_logic := '0';
+    signal done          : std_logic := '0';
+    signal test          : std_logic_vector(1 downto 0) := "00";   -- test latched at start
+    signal pass          : integer range 0 to 5 := 0;
+    signal iter          : integer range 0 to 15 := 0;
+    signal b_addr        : unsigned(ADDR_WIDTH-1 downto 0) := (others => '0');
+    signal last_addr     : unsigned(ADDR_WIDTH-1 downto 0) := (others => '1');
+    signal lfsr          : std_logic_vector(31 downto 0) := LFSR_SEED;
+    signal b_req         : std_logic := '0';
+    signal b_wr_n        : std_logic := '1';
+    signal errors        : unsigned(31 downto 0) := (others => '0');
+    signal accesses      : unsigned(31 downto 0) := (others => '0');
+    signal cycles        : unsigned(31 downto 0) := (others => '0');
+
+    -- Current pass (combinational)
+    signal p_rd          : std_logic;   -- pass reads and compares
+    signal p_wr          : std_logic;   -- pass writes
+    signal p_down        : std_logic;   -- pass walks the addresses downwards
+    signal p_last        : std_logic;   -- last pass of the iteration
+    signal i_last        : std_logic;   -- last iteration of the test
+    signal rd_val        : std_logic_vector(15 downto 0);
+    signal wr_val        : std_logic_vector(15 downto 0);
+
+begin
+
+    --========================================
+    -- CPU register window (phi2)
+    --========================================
+
+    process(phi2, cpu_reset_n)
+    begin
+        if cpu_reset_n = '0' then
+            start_toggle <= '0';
+            test_sel     <= "00";
+            size_log2    <= ADDR_WIDTH;
+            fail_cpu     <= '0';
+            errors_cpu   <= (others => '0');
+            accesses_cpu <= (others => '0');
+            cycles_cpu   <= (others => '0');
+        elsif rising_edge(phi2) then
+            busy_meta <= running;
+            busy_cpu  <= busy_meta;
+            done_meta <= done;
+            done_cpu  <= done_meta;
+
+            -- done is set after the last count: copy the counters once
+            if done_meta = '1' and done_cpu = '0' then
+                errors_cpu   <= errors;
+                accesses_cpu <= accesses;
+                cycles_cpu   <= cycles;
+                fail_cpu     <= '0';
+                if errors /= 0 then
+                    fail_cpu <= '1';
+                end if;
+            end if;
+
+            if cs_n = '0' then
+                case address is
+                    when "0000" => -- CONTROL
+                        if rw = '0' then
+                            test_sel <= data_in(2 downto 1);
+                            if data_in(0) = '1' and busy_cpu = '0' then
+                                start_toggle <= not start_toggle;
+                            end if;
+                        else
+                            data_out <= "00" & test_sel & '0' & fail_cpu & done_cpu & busy_cpu;
+                        end if;
+
+                    when "0001" => -- SIZE
+                        if rw = '0' then
+                            if to_integer(unsigned(data_in(4 downto 0))) < 4 then
+                                size_log2 <= 4;
+                            elsif to_integer(unsigned(data_in(4 downto 0))) > ADDR_WIDTH then
+                                size_log2 <= ADDR_WIDTH;
+                            else
+                                size_log2 <= to_integer(unsigned(data_in(4 downto 0)));
+                            end if;
+                        else
+                            data_out <= std_logic_vector(to_unsigned(size_log2, 8));
+                        end if;
+
+                    when "0100" => data_out <= std_logic_vector(errors_cpu(7 downto 0));
+                    when "0101" => data_out <= std_logic_vector(errors_cpu(15 downto 8));
+                    when "0110" => data_out <= std_logic_vector(errors_cpu(23 downto 16));
+                    when "0111" => data_out <= std_logic_vector(errors_cpu(31 downto 24));
+                    when "1000" => data_out <= std_logic_vector(accesses_cpu(7 downto 0));
+                    when "1001" => data_out <= std_logic_vector(accesses_cpu(15 downto 8));
+                    when "1010" => data_out <= std_logic_vector(accesses_cpu(23 downto 16));
+                    when "1011" => data_out <= std_logic_vector(accesses_cpu(31 downto 24));
+                    when "1100" => data_out <= std_logic_vector(cycles_cpu(7 downto 0));
+                    when "1101" => data_out <= std_logic_vector(cycles_cpu(15 downto 8));
+                    when "1110" => data_out <= std_logic_vector(cycles_cpu(23 downto 16));
+                    when "1111" => data_out <= std_logic_vector(cycles_cpu(31 downto 24));
+                    when others => data_out <= (others => '0');
+                end case;
+            end if;
+        end if;
+    end process;
+
+    --========================================
+    -- Pass table
+    --========================================
+    -- March C- : 6 passes, 1 iteration
+    -- others   : pass 0 writes, pass 1 reads, 16 / 2 / 1 iterations
+
+    process(test, pass, iter, b_addr, lfsr)
+        variable v : std_logic_vector(15 downto 0);
+    begin
+        p_rd   <= '0';
+        p_wr   <= '0';
+        p_down <= '0';
+        p_last <= '0';
+        i_last <= '0';
+        rd_val <= (others => '0');
+        wr_val <= (others => '0');
+
+        case test is
+            when "00" =>
+                i_last <= '1';
+                case pass is
+                    when 0 =>      p_wr <= '1'; wr_val <= x"0000";
+                    when 1 =>      p_rd <= '1'; rd_val <= x"0000"; p_wr <= '1'; wr_val <= x"FFFF";
+                    when 2 =>      p_rd <= '1'; rd_val <= x"FFFF"; p_wr <= '1'; wr_val <= x"0000";
+                    when 3 =>      p_rd <= '1'; rd_val <= x"0000"; p_wr <= '1'; wr_val <= x"FFFF"; p_down <= '1';
+                    when 4 =>      p_rd <= '1'; rd_val <= x"FFFF"; p_wr <= '1'; wr_val <= x"0000"; p_down <= '1';
+                    when others => p_rd <= '1'; rd_val <= x"0000"; p_last <= '1';
+                end case;
+
+            when others =>
+                if test = "01" then
+                    v := std_logic_vector(rotate_left(to_unsigned(1, 16),
+                                          (to_integer(b_addr(3 downto 0)) + iter) mod 16));
+                    if iter = 15 then
+                        i_last <= '1';
+                    end if;
+                elsif test = "10" then
+                    v := fold(b_addr);
+                    if iter = 1 then
+                        v := not v;
+                        i_last <= '1';
+                    end if;
+                else
+                    v := lfsr(15 downto 0);
+                    i_last <= '1';
+                end if;
+                rd_val <= v;
+                wr_val <= v;
+                if pass = 0 then
+                    p_wr <= '1';
+                else
+                    p_rd   <= '1';
+                    p_last <= '1';
+                end if;
+        end case;
+    end process;
+
+    --========================================
+    -- Engine (clk)
+    --========================================
+    -- B_IDLE:  wait for start (client idle, controller ready)
+    -- B_START: first access of the word: read (compare) or write
+    -- B_READ / B_READ_ACK, B_WRITE / B_WRITE_ACK: one request each
+    -- B_NEXT:  next word, next pass, next iteration or done
+
+    process(clk)
+    begin
+        if rising_edge(clk) then
+            start_meta <= start_toggle;
+            start_sync <= start_meta;
+
+            if reset_n = '0' then
+                b_state    <= B_IDLE;
+                start_prev <= start_sync;
+                running    <= '0';
+                done       <= '0';
+                b_req      <= '0';
+                b_wr_n     <= '1';
+            else
+                if running = '1' then
+                    cycles <= cycles + 1;
+                end if;
+
+                case b_state is
+                    when B_IDLE =>
+                        if start_sync /= start_prev and c_req = '0' and ready = '1' then
+                            start_prev <= start_sync;
+                            test       <= test_sel;
+                            last_addr  <= shift_right(to_unsigned(0, ADDR_WIDTH) - 1, ADDR_WIDTH - size_log2);
+                            b_addr     <= (others => '0');
+                            pass       <= 0;
+                            iter       <= 0;
+                            lfsr       <= LFSR_SEED;
+                            errors     <= (others => '0');
+                            accesses   <= (others => '0');
+                            cycles     <= (others => '0');
+                            running    <= '1';
+                            done       <= '0';
+                            b_state    <= B_START;
+                        end if;
+
+                    when B_START =>
+                        if p_rd = '1' then
+                            b_state <= B_READ;
+                        else
+                            b_state <= B_WRITE;
+                        end if;
+
+                    when B_READ =>
+                        if ready = '1' then
+                            b_req   <= '1';
+                            b_wr_n  <= '1';
+                            b_state <= B_READ_ACK;
+                        end if;
+
+                    when B_READ_ACK =>
+                        if ack = '1' then
+                            b_req    <= '0';
+                            accesses <= accesses + 1;
+                            if dout /= rd_val then
+                                errors <= errors + 1;
+                            end if;
+                            if p_wr = '1' then
+                                b_state <= B_WRITE;
+                            else
+                                b_state <= B_NEXT;
+                            end if;
+                        end if;
+
+                    when B_WRITE =>
+                        if ready = '1' then
+                            b_req   <= '1';
+                            b_wr_n  <= '0';
+                            b_state <= B_WRITE_ACK;
+                        end if;
+
+                    when B_WRITE_ACK =>
+                        if ack = '1' then
+                            b_req    <= '0';
+                            b_wr_n   <= '1';
+                            accesses <= accesses + 1;
+                            b_state  <= B_NEXT;
+                        end if;
+
+                    when B_NEXT =>
+                        -- LFSR steps once per word, the same way in every pass
+                        lfsr    <= lfsr(30 downto 0) & (lfsr(31) xor lfsr(21) xor lfsr(1) xor lfsr(0));
+                        b_state <= B_START;
+                        if (p_down = '0' and b_addr /= last_addr) then
+                            b_addr <= b_addr + 1;
+                        elsif (p_down = '1' and b_addr /= 0) then
+                            b_addr <= b_addr - 1;
+                        elsif p_last = '0' then
+                            -- next pass, from the bottom or the top
+                            pass <= pass + 1;
+                            lfsr <= LFSR_SEED;
+                            if test = "00" and (pass + 1 = 3 or pass + 1 = 4) then
+                                b_addr <= last_addr;
+                            else
+                                b_addr <= (others => '0');
+                            end if;
+                        elsif i_last = '0' then
+                            pass   <= 0;
+                            iter   <= iter + 1;
+                            lfsr   <= LFSR_SEED;
+                            b_addr <= (others => '0');
+                        else
+                            running <= '0';
+                            done    <= '1';
+                            b_state <= B_IDLE;
+                        end if;
+                end case;
+            end if;
+        end if;
+    end process;
+
+    --========================================
+    -- Port mux
+    --========================================
+
+    req     <= b_req and not ack when running = '1' else c_req;
+    wr_n    <= b_wr_n            when running = '1' else c_wr_n;
+    addr    <= std_logic_vector(b_addr) when running = '1' else c_addr;
+    din     <= wr_val            when running = '1' else c_din;
+    byte_en <= "11"              when running = '1' else c_byte_en;
+    burst   <= '0'               when running = '1' else c_burst;
+
+    c_dout   <= dout;
+    c_ready  <= ready  and not running;
+    c_ack    <= ack    and not running;
+    c_dvalid <= dvalid and not running;
+
+end rtl;
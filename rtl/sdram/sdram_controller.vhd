@@ -60,12 +60,17 @@
 --      * Row automatically closes after operation
 --      * Simpler state machine, no explicit precharge needed
 --      * Slightly slower for sequential same-row accesses
---    - When USE_AUTO_PRECHARGE = false:
+--    - When USE_AUTO_PRECHARGE = false (open-row / page mode):
 --      * READ and WRITE commands issued with A10=0
 --      * Row remains open for next access
---      * Controller tracks active row per bank
+--      * Controller tracks one open row per bank (4 banks)
 --      * Faster for sequential accesses to same row
---      * Must explicitly precharge before changing rows
+--      * Access to another bank keeps the other open rows: only that
+--        bank is activated (if idle) or precharged + activated (if
+--        another row is open in it), PRECHARGE with A10=0
+--      * PRECHARGE ALL (A10=1) only before an AUTO REFRESH
+--      * Per-bank tRAS (ACTIVATE to PRECHARGE) and tRP (PRECHARGE to
+--        ACTIVATE) counters, driven from the commands sent to the chip
 --
 --    Note: READ and WRITE commands are unified in the state machine.
 --    The only hardware difference between a plain access and an
@@ -79,7 +84,7 @@
 --      c) Issue 8 AUTO REFRESH commands (separated by tRFC)
 --      d) Load MODE REGISTER with operating parameters:
 --         - CAS Latency = 2 cycles
---         - Burst Length = 1 (single access)
+--         - Burst Length = BURST_LENGTH (1, 4 or 8)
 --         - Burst Type = Sequential
 --         - Write Burst Mode = Single Location
 --      e) Wait tMRD cycles, then ready for normal operation
@@ -90,14 +95,31 @@
 --    - When USE_AUTO_REFRESH = true:
 --      * Controller automatically generates refresh requests
 --      * Internal counter triggers refresh every 7.8µs
---      * Refresh postponed if CPU access in progress
 --      * Automatic and transparent to external logic
 --
 --    - When USE_AUTO_REFRESH = false:
---      * External logic provides refresh_req signal
+--      * External logic provides refresh_req signal (one pulse per
+--        refresh interval)
 --      * Useful for multi-master systems or custom scheduling
 --      * Controller still handles timing and protocol
 --
+--    Refresh debt (JEDEC postponed refresh):
+--      * Every interval adds one refresh to refresh_debt, every AUTO
+--        REFRESH issued removes one
+--      * Up to MAX_REFRESH_DEBT (8, the JEDEC limit) refreshes may be
+--        owed, requests are served first
+--      * Refreshes are paid when the controller is idle and the client
+--        says no access is coming (refresh_ok = '1', e.g. CPU in phi1
+--        or running from the cache); while idle they go back to back,
+--        so the debt is caught up in bursts
+--      * Only when the debt is full does a refresh go before a pending
+--        request (one refresh, then requests again)
+--      * refresh_ok defaults to '1': refresh as soon as idle
+--      * quiet_cycles (from the bridge phase prediction) = clocks before
+--        the next request can arrive; an opportunistic REFRESH or
+--        PRECHARGE ALL only starts if it is back in IDLE by then, so
+--        maintenance never delays a CPU access (default 255: no limit)
+--
 --    Refresh sequence:
 --      1. If row active: PRECHARGE first
 --      2. Issue AUTO REFRESH command
@@ -116,14 +138,36 @@
 --      - Generates SDRAM commands
 --      - No registered outputs (pure combinational)
 --
--- 7. Address Mapping
---    CPU Address breakdown:
+-- 7. Address Mapping (generic ADDR_MAPPING)
+--    "BANK_ROW_COL" (default):
 --      [BANK(1:0)][ROW(12:0 or 11:0)][COL(9:0 or 7:0)]
 --
---    Example for DE10-Lite (13-bit row, 10-bit col):
---      addr(24:23) = Bank select (BA1:0)
---      addr(22:10) = Row address (13 bits)
---      addr(9:0)   = Column address (10 bits)
+--      Example for DE10-Lite (13-bit row, 10-bit col):
+--        addr(24:23) = Bank select (BA1:0)
+--        addr(22:10) = Row address (13 bits)
+--        addr(9:0)   = Column address (10 bits)
+--
+--      Contiguous memory sits in one bank, so a stream crossing a row
+--      boundary always closes the row it just used.
+--
+--    "ROW_BANK_COL" (bank interleaved):
+--      [ROW(12:0 or 11:0)][BANK(1:0)][COL(9:0 or 7:0)]
+--
+--      Example for DE10-Lite:
+--        addr(24:12) = Row address (13 bits)
+--        addr(11:10) = Bank select (BA1:0)
+--        addr(9:0)   = Column address (10 bits)
+--
+--      Consecutive pages go to consecutive banks: with open rows
+--      (USE_AUTO_PRECHARGE = false) a sequential stream finds the next
+--      bank idle (ACTIVATE only, no PRECHARGE) and code and data streams
+--      a few pages apart keep their rows open in different banks.
+--
+--    "ROW_BANK_XOR" (bank interleaved, hashed):
+--      Same as ROW_BANK_COL but BA = addr(11:10) xor addr(13:12), the
+--      two low row bits. Addresses a multiple of 4 pages apart (same
+--      bank with ROW_BANK_COL) are spread over the 4 banks too.
+--      The mapping is a bijection: row and column are unchanged.
 --
 -- 8. Clock Domain
 --    - Single clock domain (no CDC required)
@@ -142,25 +186,78 @@
 --     - tRP:   Precharge time (~20ns)
 --     - tRCD:  RAS-to-CAS delay (~20ns)
 --     - tRFC:  Refresh cycle time (~70ns)
+--     - tRAS:  Row active time (~42ns), checked per bank before PRECHARGE
 --     - tMRD:  Mode register delay (2 cycles fixed)
 --     - CAS Latency: 2 cycles (configurable in MODE_REG)
 --
--- 11. Debug Interface
+-- 11. Burst Reads (Cache Line Fill)
+--     - BURST_LENGTH generic programs the mode register burst length:
+--       * 1 = legacy single-word accesses (default)
+--       * 4 or 8 = burst reads, writes stay single location (A9=1)
+--     - Assert burst='1' together with req for a read to get BURST_LENGTH
+--       consecutive 16-bit words from ONE READ command
+--     - dvalid pulses once per word (one word per clock, no gaps)
+--       dout holds the word while dvalid is high
+--     - ack is asserted together with the LAST word of the burst
+--     - Sequential burst type: the column wraps inside the BL-aligned
+--       block, so a burst started on word 5 of an 8 word block returns
+--       words 5,6,7,0,1,2,3,4 (critical word first)
+--     - Plain reads (burst='0') still return a single word; the extra
+--       burst beats are masked with DQM and cut with BURST STOP
+--     - A 16-byte cache line (8 words) is filled by a single ACTIVATE +
+--       READ with BURST_LENGTH = 8 instead of 8 or 16 separate accesses
+--
+-- 12. Debug Interface
 --     Provides visibility into controller state via debug outputs:
 --     - debug_state: Current FSM state (4 bits)
 --     - debug_cmd: Current SDRAM command being issued
 --     - debug_addr_[10,9,0]: Key address bits
 --     - debug_dqm: Data mask signals
 --     - refresh_active: High during refresh operation
+--     - ev_activate / ev_row_hit / ev_refresh: one clock pulse per
+--       ACTIVATE, per request served from an open row, per AUTO
+--       REFRESH after initialization (PMU counters)
+--
+-- 13. Bank Look-ahead (next_req / next_addr)
+--     - The client may announce a request that follows the current one
+--       (next_req = '1', next_addr) - e.g. the next entry of its write
+--       queue, or the line it will fill after a write back
+--     - While the current access sits in NOP cycles (tRCD wait, CAS
+--       latency, burst beats, write recovery) the controller prepares
+--       the bank of the announced request, if it is another bank:
+--       * bank idle:              ACTIVATE (tRP of the bank, tRRD met)
+--       * other row open in bank: PRECHARGE that bank (tRAS met)
+--     - When the request arrives its row is open: READ/WRITE is issued
+--       right away (after tRCD, counted per bank from the ACTIVATE)
+--     - Only a hint: a wrong or missing announcement costs nothing but
+--       an open row; the FSM still runs one request at a time
+--     - No look-ahead while the refresh debt is full
+--
+-- 14. Read Capture Delay (rd_delay)
+--     - Read data is sampled CAS_LATENCY + rd_delay clocks after READ
+--       (plus the usual +1), ack/dvalid follow the sample point
+--     - rd_delay = "00" is the original timing
+--     - sdram_trainer sweeps it at power-on (write/read back patterns)
+--       and keeps the smallest passing value, so a board can run the
+--       SDRAM faster than its hand-tuned clock phase allows
 --
 -- Performance Characteristics:
 --     With AUTO_PRECHARGE = true:
 --       - Read:  ACT + tRCD + READ + CAS_LAT + tRP = ~8-10 cycles
 --       - Write: ACT + tRCD + WRITE + tRP = ~6-8 cycles
+--       - Burst: ACT + tRCD + READ + CAS_LAT + BURST_LENGTH = ~14 cycles
+--                for 8 words (vs ~80 cycles for 8 single reads)
 --
 --     With AUTO_PRECHARGE = false and same-row access:
 --       - Read:  READ + CAS_LAT = ~4 cycles (much faster!)
 --       - Write: WRITE + 1 = ~2 cycles (much faster!)
+--     With AUTO_PRECHARGE = false and an idle bank:
+--       - ACT + tRCD + READ/WRITE, the rows open in the other banks stay
+--     With AUTO_PRECHARGE = false and another row open in the bank:
+--       - PRE (bank) + tRP + ACT + tRCD + READ/WRITE
+--     With the bank prepared by the look-ahead (either mode):
+--       - READ/WRITE as for a same-row access, PRE/ACT hidden behind
+--         the previous access
 --
 --------------------------------------------------------------------------------
 
@@ -176,9 +273,14 @@ entity sdram_controller is
         TRP_NS             : integer := 20;   -- Precharge time (for PRECHARGE wait)
         TRCD_NS            : integer := 20;   -- RAS to CAS delay (for ACTIVE→READ/WRITE)
         TRFC_NS            : integer := 70;   -- Refresh cycle time (for AUTO REFRESH wait)
+        TRAS_NS            : integer := 42;   -- Row active time (ACTIVE→PRECHARGE, same bank)
+        TRRD_NS            : integer := 14;   -- ACTIVE to ACTIVE, different banks
+        MAX_REFRESH_DEBT   : integer := 8;    -- refreshes that may be postponed (JEDEC: 8)
+        ADDR_MAPPING       : string  := "BANK_ROW_COL"; -- "BANK_ROW_COL", "ROW_BANK_COL" or "ROW_BANK_XOR"
         CAS_LATENCY        : integer := 2;    -- CAS Latency: 2 or 3 cycles
         USE_AUTO_PRECHARGE : boolean := true; -- true = READA/WRITEA false = READ/WRITE
-        USE_AUTO_REFRESH   : boolean := true  -- true = autorefresh, false = triggered refresh
+        USE_AUTO_REFRESH   : boolean := true; -- true = autorefresh, false = triggered refresh
+        BURST_LENGTH       : integer := 1     -- Read burst length: 1, 4 or 8
     );
     port(
         clk            : in    std_logic;  
@@ -191,10 +293,20 @@ entity sdram_controller is
         din            : in    std_logic_vector(15 downto 0);
         dout           : out   std_logic_vector(15 downto 0);
         byte_en        : in    std_logic_vector(1 downto 0); 
+        burst          : in    std_logic := '0';  -- '1' with req = burst read of BURST_LENGTH words
+        rd_delay       : in    unsigned(1 downto 0) := "00";  -- extra capture clocks (sdram_trainer)
+        next_req       : in    std_logic := '0';  -- look-ahead: a request to next_addr follows
+        next_addr      : in    std_logic_vector(ROW_BITS+COL_BITS+1 downto 0) := (others => '0');
         ready          : out   std_logic;
         ack            : out   std_logic;
+        dvalid         : out   std_logic;         -- one pulse per word returned by a burst read
         refresh_req    : in    std_logic;
+        refresh_ok     : in    std_logic := '1';  -- '1' = no access expected, owed refreshes may run
+        quiet_cycles   : in    unsigned(7 downto 0) := (others => '1');  -- clocks before the next request
         refresh_active : out   std_logic;
+        ev_activate    : out   std_logic;  -- event pulses for the pmu
+        ev_row_hit     : out   std_logic;
+        ev_refresh     : out   std_logic;
         
         -- SDRAM pins
         sdram_clk      : out   std_logic;
@@ -248,6 +360,7 @@ architecture rtl of sdram_controller is
     constant ST_READ              : std_logic_vector(3 downto 0) := "0111";
     constant ST_WRITE             : std_logic_vector(3 downto 0) := "1000";
     constant ST_PRECHARGE         : std_logic_vector(3 downto 0) := "1001";
+    constant ST_PRECHARGE_BANK    : std_logic_vector(3 downto 0) := "1010";
     
     constant DQM_IDLE             : std_logic_vector(1 downto 0) := "00";
     
@@ -255,16 +368,40 @@ architecture rtl of sdram_controller is
 	 constant TRP_CYCLES           : integer := ((TRP_NS * FREQ_MHZ) + 999) / 1000;
 	 constant TRCD_CYCLES          : integer := ((TRCD_NS * FREQ_MHZ) + 999) / 1000;
 	 constant TRFC_CYCLES          : integer := ((TRFC_NS * FREQ_MHZ) + 999) / 1000;  -- Use THIS for AUTO REFRESH!
+	 constant TRAS_CYCLES          : integer := ((TRAS_NS * FREQ_MHZ) + 999) / 1000;
+	 constant TRRD_CYCLES          : integer := ((TRRD_NS * FREQ_MHZ) + 999) / 1000;
 	 constant TMRD_CYCLES          : integer := 2;  -- Mode register delay (2 cycles fixed)
     constant TWR_CYCLES           : integer := 2;  -- Write recovery time
     
     -- Mode Register Parameters (JEDEC Standard bit fields)
-    constant MR_BURST_LENGTH      : std_logic_vector(2 downto 0) := "000";  -- Bits [2:0]: Burst Length = 1
     constant MR_BURST_TYPE        : std_logic := '0';                       -- Bit [3]: Sequential (0) or Interleaved (1)
     constant MR_OPERATING_MODE    : std_logic_vector(1 downto 0) := "00";   -- Bits [8:7]: Standard operation
-    constant MR_WRITE_BURST_MODE  : std_logic := '0';                       -- Bit [9]: Single location access (1) or Burst (0)
     constant MR_RESERVED          : std_logic_vector(2 downto 0) := "000";  -- Bits [12:10]: Must be 000
     
+    -- Burst Length encoding for Mode Register bits [2:0]
+    function burst_length_bits return std_logic_vector is
+    begin
+        if BURST_LENGTH = 4 then
+            return "010";
+        elsif BURST_LENGTH = 8 then
+            return "011";
+        else
+            return "000";  -- Default to 1 if invalid
+        end if;
+    end function;
+    
+    -- Write Burst Mode for Mode Register bit [9]
+    -- With read bursts enabled, writes must stay single location (1)
+    -- so a byte store never touches the following columns
+    function write_burst_mode_bit return std_logic is
+    begin
+        if BURST_LENGTH > 1 then
+            return '1';
+        else
+            return '0';
+        end if;
+    end function;
+    
     -- CAS Latency encoding for Mode Register bits [6:4]
     function cas_latency_bits return std_logic_vector is
     begin
@@ -282,28 +419,36 @@ architecture rtl of sdram_controller is
     -- Format: [12:10] Reserved | [9] WBM | [8:7] Mode | [6:4] CAS | [3] BT | [2:0] BL
     constant MODE_REG             : std_logic_vector(12 downto 0) := 
 			 MR_RESERVED          &  -- [12:10] Reserved (must be 000)
-			 MR_WRITE_BURST_MODE  &  -- [9] Write burst mode
+			 write_burst_mode_bit &  -- [9] Write burst mode
 			 MR_OPERATING_MODE    &  -- [8:7] Operating mode  
 			 cas_latency_bits     &  -- [6:4] CAS Latency (auto from constant)
 			 MR_BURST_TYPE        &  -- [3] Burst type
-			 MR_BURST_LENGTH;        -- [2:0] Burst length   
+			 burst_length_bits;      -- [2:0] Burst length (auto from constant)
 
 	 -- ISSI datatasheet at least 100µs delay 
 	 -- before issing a command other than NOP or INHIBIT
     constant INIT_WAIT            : integer := FREQ_MHZ * 200;      -- 200µs
 	 constant REFRESH_INTERVAL     : integer := (FREQ_MHZ * 78) / 10; -- 7.8µs
+	 -- IDLE to IDLE through ST_REFRESH / ST_PRECHARGE (opportunistic maintenance)
+	 constant REF_WINDOW           : integer := TRFC_CYCLES + 2;
+	 constant PRE_WINDOW           : integer := TRP_CYCLES + 2;
+	 
+	 -- Read capture: data sampled rd_delay clocks after the CAS latency
+	 signal rd_lat                 : integer range CAS_LATENCY to CAS_LATENCY + 3;
+
+	 -- With auto-precharge the bank only starts precharging once the whole
+	 -- burst has left the chip, so wait burst + tRP before the next ACTIVATE
+	 signal read_ap_end            : integer range 0 to CAS_LATENCY + 3 + BURST_LENGTH + TRP_CYCLES;
 
     signal state                  : std_logic_vector(3 downto 0) := ST_INIT;
     signal state_next             : std_logic_vector(3 downto 0) := ST_INIT;
 	 signal seq_count              : integer range 0 to INIT_WAIT + 50 := 0;
 	 signal seq_count_next         : integer range 0 to INIT_WAIT + 50 := 0;
-	 signal row_active             : std_logic := '0';  -- '1' when a row is open
-  	 signal row_active_next        : std_logic := '0';  -- '1' when a row is open
-    signal need_refresh           : std_logic := '0';  -- '1' when a refresh is needed
-    signal need_refresh_next      : std_logic := '0';  -- '1' when a refresh is needed
-    signal refresh_postponed      : std_logic := '0';  -- '1' when a refresh is postponed
-    signal refresh_postponed_next : std_logic := '0';  -- '1' when a refresh is postponed
+    signal refresh_debt           : integer range 0 to MAX_REFRESH_DEBT := 0;  -- refreshes owed
+    signal need_refresh           : std_logic;  -- '1' when a refresh is owed
+    signal refresh_urgent         : std_logic;  -- '1' when the debt is full
     signal ack_next               : std_logic := '0';
+    signal dvalid_next            : std_logic := '0';
     signal ready_next             : std_logic := '0';
     signal dout_next              : std_logic_vector(15 downto 0);
     
@@ -318,11 +463,49 @@ architecture rtl of sdram_controller is
     signal byte_en_latched        : std_logic_vector(1 downto 0);
     signal din_latched            : std_logic_vector(15 downto 0);
     signal wr_n_latched           : std_logic;
+    signal burst_latched          : std_logic := '0';
 	 
-	signal active_row             : std_logic_vector(ROW_BITS-1 downto 0) := (others => '0');
-	signal active_row_next        : std_logic_vector(ROW_BITS-1 downto 0) := (others => '0');
-	signal active_bank            : std_logic_vector(1 downto 0) := "00";
-	signal active_bank_next       : std_logic_vector(1 downto 0) := "00";
+    -- Address split according to ADDR_MAPPING
+    function map_bank(a : std_logic_vector) return std_logic_vector is
+    begin
+        if ADDR_MAPPING = "ROW_BANK_XOR" then
+            return a(COL_BITS+1 downto COL_BITS) xor a(COL_BITS+3 downto COL_BITS+2);
+        elsif ADDR_MAPPING = "ROW_BANK_COL" then
+            return a(COL_BITS+1 downto COL_BITS);
+        else
+            return a(a'high downto a'high-1);
+        end if;
+    end function;
+
+    function map_row(a : std_logic_vector) return std_logic_vector is
+    begin
+        if ADDR_MAPPING = "BANK_ROW_COL" then
+            return a(a'high-2 downto COL_BITS);
+        else
+            return a(a'high downto COL_BITS+2);
+        end if;
+    end function;
+
+    signal req_bank               : std_logic_vector(1 downto 0);
+    signal req_row                : std_logic_vector(ROW_BITS-1 downto 0);
+    signal req_col                : std_logic_vector(COL_BITS-1 downto 0);
+
+    -- Bank look-ahead
+    signal nxt_bank               : std_logic_vector(1 downto 0);
+    signal nxt_row                : std_logic_vector(ROW_BITS-1 downto 0);
+    signal la_slot                : std_logic;  -- current state issues a NOP this cycle
+    signal act_gap                : integer range 0 to TRRD_CYCLES;  -- clocks since the last ACTIVATE
+
+    -- Open row tracking, one row per bank
+    type bank_row_type   is array (0 to 3) of std_logic_vector(ROW_BITS-1 downto 0);
+    type bank_count_type is array (0 to 3) of integer range 0 to TRAS_CYCLES + TRP_CYCLES;
+    signal bank_open              : std_logic_vector(3 downto 0) := "0000";  -- '1' when a row is open in the bank
+    signal bank_open_next         : std_logic_vector(3 downto 0) := "0000";
+    signal bank_row               : bank_row_type := (others => (others => '0'));
+    signal bank_row_next          : bank_row_type := (others => (others => '0'));
+    signal bank_tras              : bank_count_type;  -- clocks since ACTIVATE (saturates at TRAS_CYCLES)
+    signal bank_trp               : bank_count_type;  -- clocks since PRECHARGE (saturates at TRP_CYCLES)
+    signal all_tras_met           : std_logic;        -- every bank may be precharged
   
     -- Command outputs
 
@@ -346,8 +529,36 @@ begin
     -- Output assignments
     sdram_clk  <= not clk;
     sdram_dq   <= sdram_dq_next when (state = ST_WRITE) else (others => 'Z');
+
+    assert ADDR_MAPPING = "BANK_ROW_COL" or ADDR_MAPPING = "ROW_BANK_COL" or ADDR_MAPPING = "ROW_BANK_XOR"
+        report "sdram_controller: unknown ADDR_MAPPING" severity failure;
+
+    -- Address mapping
+    req_col  <= addr(COL_BITS-1 downto 0);
+    req_row  <= map_row(addr);
+    req_bank <= map_bank(addr);
+    nxt_row  <= map_row(next_addr);
+    nxt_bank <= map_bank(next_addr);
+
+    -- Command slots the look-ahead may use (the state itself issues a NOP)
+    la_slot <= '1' when (state = ST_ACTIVATE and seq_count /= 0) or
+                        (state = ST_WRITE and seq_count >= 2) or
+                        (state = ST_READ and seq_count /= 0 and
+                         not (burst_latched = '0' and seq_count = rd_lat + 1))
+                   else '0';
+
+    rd_lat      <= CAS_LATENCY + to_integer(rd_delay);
+    read_ap_end <= rd_lat + BURST_LENGTH + TRP_CYCLES;
     
+    need_refresh   <= '1' when refresh_debt /= 0 else '0';
+    refresh_urgent <= '1' when refresh_debt >= MAX_REFRESH_DEBT else '0';
+
+    all_tras_met <= '1' when bank_tras(0) >= TRAS_CYCLES and bank_tras(1) >= TRAS_CYCLES and
+                             bank_tras(2) >= TRAS_CYCLES and bank_tras(3) >= TRAS_CYCLES
+                        else '0';
+
     process(clk)
+        variable refresh_tick : std_logic;
     begin
         if rising_edge(clk) then
             if reset_n = '0' then
@@ -363,23 +574,29 @@ begin
                 sdram_dqm         <= "11";
                 ready             <= '0';
                 ack               <= '0';
+                dvalid            <= '0';
                 refresh_counter   <= 0;
-                need_refresh      <= '0';
+                refresh_debt      <= 0;
                 init_done         <= '0';
+                bank_open         <= "0000";
+                bank_tras         <= (others => TRAS_CYCLES);
+                bank_trp          <= (others => TRP_CYCLES);
+                act_gap           <= TRRD_CYCLES;
+                ev_activate       <= '0';
+                ev_row_hit        <= '0';
+                ev_refresh        <= '0';
                 
             else
                 state             <= state_next;
                 seq_count         <= seq_count_next;
-                row_active        <= row_active_next;
-                active_row        <= active_row_next;
-                active_bank       <= active_bank_next;
-                need_refresh      <= need_refresh_next;
+                bank_open         <= bank_open_next;
+                bank_row          <= bank_row_next;
                 init_done         <= init_done_next;
                 refresh_count     <= refresh_count_next;
-                refresh_postponed <= refresh_postponed_next;
             
                 -- transfer next values to controller
                 ack               <= ack_next;
+                dvalid            <= dvalid_next;
                 ready             <= ready_next;
                 dout              <= dout_next;
                 
@@ -392,21 +609,63 @@ begin
                 sdram_addr        <= sdram_addr_next;
                 sdram_ba          <= sdram_ba_next;
                 sdram_dqm         <= sdram_dqm_next;
+
+                -- Per-bank tRAS / tRP bookkeeping from the command going out
+                for b in 0 to 3 loop
+                    if cmd_next = CMD_ACT and to_integer(unsigned(sdram_ba_next)) = b then
+                        bank_tras(b) <= 0;
+                    elsif bank_tras(b) < TRAS_CYCLES then
+                        bank_tras(b) <= bank_tras(b) + 1;
+                    end if;
+                    if cmd_next = CMD_PRE and (sdram_addr_next(10) = '1' or
+                                               to_integer(unsigned(sdram_ba_next)) = b) then
+                        bank_trp(b) <= 0;
+                    elsif bank_trp(b) < TRP_CYCLES then
+                        bank_trp(b) <= bank_trp(b) + 1;
+                    end if;
+                end loop;
+                -- Event pulses
+                ev_activate <= '0';
+                ev_row_hit  <= '0';
+                ev_refresh  <= '0';
+                if cmd_next = CMD_ACT then
+                    ev_activate <= '1';
+                end if;
+                if cmd_next = CMD_REF and init_done = '1' then
+                    ev_refresh <= '1';
+                end if;
+                if state = ST_IDLE and (state_next = ST_READ or state_next = ST_WRITE) then
+                    ev_row_hit <= '1';
+                end if;
+
+                if cmd_next = CMD_ACT then
+                    act_gap <= 0;
+                elsif act_gap < TRRD_CYCLES then
+                    act_gap <= act_gap + 1;
+                end if;
             
+                refresh_tick := '0';
                 if USE_AUTO_REFRESH = true then
                     -- Refresh counter (ONLY after initialization complete)
                     if init_done = '1' then
                         if refresh_counter >= REFRESH_INTERVAL then
                             refresh_counter <= 0;
-                            need_refresh <= '1';
+                            refresh_tick := '1';
                         else
                             refresh_counter <= refresh_counter + 1;
                         end if;
                     end if;
                 else
-                    if refresh_req = '1' then
-                        need_refresh <= '1';
+                    refresh_tick := refresh_req and init_done;
+                end if;
+
+                -- Refresh debt: one more per interval, one less per AUTO REFRESH
+                if state = ST_REFRESH and cmd_next = CMD_REF then
+                    if refresh_tick = '0' then
+                        refresh_debt <= refresh_debt - 1;
                     end if;
+                elsif refresh_tick = '1' and refresh_debt < MAX_REFRESH_DEBT then
+                    refresh_debt <= refresh_debt + 1;
                 end if;
             end if;
         end if;    
@@ -416,12 +675,16 @@ begin
         -- Current state registers
         state,
         seq_count,
-        row_active,
-        active_row,
-        active_bank,
+        bank_open,
+        bank_row,
+        bank_tras,
+        bank_trp,
+        all_tras_met,
+        act_gap,
+        la_slot,
         need_refresh,
+        refresh_urgent,
         refresh_count,
-        refresh_postponed,
         init_done,
         refresh_counter,
         
@@ -432,13 +695,25 @@ begin
         byte_en_latched,
         din_latched,
         wr_n_latched,
+        burst_latched,
+        rd_lat,
+        read_ap_end,
        
         -- External inputs from CPU/system
         req,
+        refresh_ok,
+        quiet_cycles,
         wr_n,
         addr,
+        req_bank,
+        req_row,
+        req_col,
+        next_req,
+        nxt_bank,
+        nxt_row,
         byte_en,
         din,
+        burst,
         
         -- Input from SDRAM
         sdram_dq
@@ -453,14 +728,13 @@ begin
         sdram_dqm_next <= "11";
         sdram_cke_next <= '1';
         sdram_dq_next <= (others => 'Z');
-        row_active_next <= row_active;
-        active_row_next <= active_row;
-        active_bank_next <= active_bank;
-        need_refresh_next <= need_refresh;
+        bank_open_next <= bank_open;
+        bank_row_next <= bank_row;
         refresh_count_next <= refresh_count;
         init_done_next <= init_done;
         ready_next <= '0';
         ack_next <= '0';
+        dvalid_next <= '0';
         dout_next <= (others => '0');
     
     
@@ -616,8 +890,11 @@ begin
         --                       (data appears 2 clocks after READ command)
         --   A3      = "0"   --> Burst Type = Sequential
         --                       (addresses increment: 0,1,2,3... not interleaved)
-        --   A2:A0   = "000" --> Burst Length = 1 word
+        --   A2:A0   = "000" --> Burst Length = 1 word (BURST_LENGTH = 1)
         --                       (single access per command, not burst of 2/4/8)
+        --             "010" --> Burst Length = 4 words (BURST_LENGTH = 4)
+        --             "011" --> Burst Length = 8 words (BURST_LENGTH = 8)
+        --                       A9 is then forced to '1' so writes stay single
         --
         -- Command Timing:
         --   Cycle 1:      Issue LOAD MODE REGISTER command
@@ -644,9 +921,10 @@ begin
         -- ST_IDLE - Wait for CPU request or refresh
         --========================================
         -- Purpose: Default idle state. Monitors for:
-        --          1. Pending refresh (need_refresh or refresh_postponed)
+        --          1. Full refresh debt (refresh_urgent)
         --          2. CPU read/write request (req = '1')
-        --          Prioritizes postponed refresh over new CPU requests.
+        --          3. Owed refresh while the client allows it (refresh_ok)
+        --          Requests go before refreshes until the debt is full.
         --
         -- Signal Requirements:
         --   CMD    = NOP --> No operation
@@ -655,38 +933,43 @@ begin
         --
         -- Decision Logic:
         --
-        -- Priority 1: Postponed Refresh (highest priority)
-        --   If need_refresh='1' AND refresh_postponed='1':
-        --     → Must service delayed refresh immediately
-        --     → If row_active='1': Go to PRECHARGE first
-        --     → If row_active='0': Go directly to REFRESH
+        -- Priority 1: Urgent Refresh (highest priority)
+        --   If refresh_urgent='1' (MAX_REFRESH_DEBT refreshes owed):
+        --     → Must service one refresh immediately
+        --     → If any bank has an open row: Go to PRECHARGE (all) first
+        --     → If all banks are idle: Go directly to REFRESH
         --
         -- Priority 2: CPU Request
         --   If req='1' (CPU wants access):
         --     → Latch address, data, byte_en, wr_n from CPU
         --     → Parse address into bank, row, column
-        --     → Check if refresh is needed (set postponed flag if so)
+        --     → An owed refresh simply stays in refresh_debt
         --     
         --     With USE_AUTO_PRECHARGE = true:
-        --       → Always go to ACTIVATE (simple path)
+        --       → Go to ACTIVATE (simple path), unless the look-ahead
+        --         already opened the row: READ/WRITE
         --       → Row will auto-close after read/write
         --     
         --     With USE_AUTO_PRECHARGE = false:
-        --       → Check if same bank/row already active:
+        --       → Check the open row of the addressed bank:
         --         * Same row: Go directly to READ/WRITE (fast!)
-        --         * Different row: PRECHARGE → ACTIVATE → READ/WRITE
-        --         * No row active: ACTIVATE → READ/WRITE
+        --         * Different row: PRECHARGE_BANK → ACTIVATE → READ/WRITE
+        --         * Bank idle: ACTIVATE → READ/WRITE
+        --       → Rows open in the other banks are left open
         --
-        -- Priority 3: Normal Refresh
-        --   If need_refresh='1' (and not postponed):
-        --     → If row_active='1': Go to PRECHARGE first
-        --     → If row_active='0': Go directly to REFRESH
+        -- Priority 3: Opportunistic Refresh
+        --   If need_refresh='1' and refresh_ok='1':
+        --     → If any bank has an open row: Go to PRECHARGE (all) first
+        --       (only if quiet_cycles >= PRE_WINDOW)
+        --     → If all banks are idle: Go directly to REFRESH
+        --       (only if quiet_cycles >= REF_WINDOW)
+        --     → Back here after tRFC: the next owed refresh follows
+        --       unless a request came in (refresh burst)
         --
         -- Refresh Postponement:
-        --   - If CPU request arrives when refresh needed, set postponed flag
-        --   - Allows CPU burst to complete before servicing refresh
-        --   - Refresh will be highest priority next time through IDLE
-        --   - Prevents excessive refresh delays (data retention guarantee)
+        --   - Requests never wait for a refresh while the debt is not full
+        --   - The debt is paid when the client is quiet (refresh_ok)
+        --   - Up to MAX_REFRESH_DEBT (8) intervals: JEDEC retention limit
         
         when ST_IDLE =>
             cmd_next       <= CMD_NOP;
@@ -694,9 +977,9 @@ begin
             ready_next     <= '1';
             seq_count_next <= 0;
 
-            if need_refresh = '1' and refresh_postponed = '1' then
-                -- Need to precharge first if row is active
-                if row_active = '1' then
+            if refresh_urgent = '1' then
+                -- Need to precharge first if a row is active
+                if bank_open /= "0000" then
                     state_next <= ST_PRECHARGE;
                     ready_next <= '0';
                 else
@@ -705,48 +988,47 @@ begin
                 end if;
                 -- check if we have a request    
             elsif req = '1' then
-                if need_refresh = '1' then
-                    refresh_postponed_next <= '1';
-                end if;
                 -- Latch address
-                addr_bank_latched <= addr(addr'high downto addr'high-1);
-                addr_row_latched  <= addr(addr'high-2 downto COL_BITS);
-                addr_col_latched  <= addr(COL_BITS-1 downto 0);
+                addr_bank_latched <= req_bank;
+                addr_row_latched  <= req_row;
+                addr_col_latched  <= req_col;
                 byte_en_latched   <= byte_en;
                 wr_n_latched      <= wr_n;
                 din_latched       <= din;
-
-                if USE_AUTO_PRECHARGE = true then
-                    state_next    <= ST_ACTIVATE;
-                    ready_next <= '0';
+                if BURST_LENGTH > 1 then
+                    burst_latched <= burst and wr_n;  -- bursts are reads only
                 else
-                    -- Check if accessing same row/bank
-                    if row_active = '1' and 
-                        active_bank = addr(addr'high downto addr'high-1) and
-                        active_row  = addr(addr'high-2 downto COL_BITS) then
-                        -- Same row! Go directly to read/write
-                        if wr_n = '0' then
-                            state_next <= ST_WRITE;
-                        else
-                            state_next <= ST_READ;
-                        end if;
+                    burst_latched <= '0';
+                end if;
+
+                -- Check the row open in the addressed bank (with
+                -- auto-precharge only the look-ahead leaves a row open)
+                if bank_open(to_integer(unsigned(req_bank))) = '1' and
+                   bank_row(to_integer(unsigned(req_bank))) = req_row then
+                    -- Same row! Go directly to read/write
+                    if wr_n = '0' then
+                        state_next <= ST_WRITE;
                     else
-                        -- Different row, need to activate (precharge first if needed)
-                        if row_active = '1' then
-                            state_next <= ST_PRECHARGE;
-                        else
-                            state_next <= ST_ACTIVATE;
-                        end if;
+                        state_next <= ST_READ;
                     end if;
-                    ready_next <= '0';
-               end if;
-            -- check if a refresh is needed
-            elsif need_refresh = '1' then
-                -- Need to precharge first if row is active
-                if row_active = '1' then
-                    state_next <= ST_PRECHARGE;
-                    ready_next <= '0';
                 else
+                    -- Different row, need to activate (precharge this bank first if needed)
+                    if bank_open(to_integer(unsigned(req_bank))) = '1' then
+                        state_next <= ST_PRECHARGE_BANK;
+                    else
+                        state_next <= ST_ACTIVATE;
+                    end if;
+                end if;
+                ready_next <= '0';
+            -- pay an owed refresh while the client is quiet
+            elsif need_refresh = '1' and refresh_ok = '1' then
+                -- Need to precharge first if a row is active
+                if bank_open /= "0000" then
+                    if quiet_cycles >= PRE_WINDOW then
+                        state_next <= ST_PRECHARGE;
+                        ready_next <= '0';
+                    end if;
+                elsif quiet_cycles >= REF_WINDOW then
                     state_next <= ST_REFRESH;
                     ready_next <= '0';
                 end if;
@@ -776,9 +1058,8 @@ begin
         --
         -- Timing: Wait tRFC cycles (~70ns = 7 cycles @ 100MHz)
         --
-        -- Flags Cleared on Completion:
-        --   need_refresh = '0'      --> This refresh serviced
-        --   refresh_postponed = '0' --> Clear any postponement flag
+        -- Refresh Debt:
+        --   refresh_debt - 1 when CMD_REF is issued (sync process)
         --
         -- Exit Condition: Return to ST_IDLE after tRFC delay completes
         --
@@ -792,8 +1073,6 @@ begin
                 seq_count_next <= seq_count + 1;
             elsif seq_count = TRFC_CYCLES then
                 cmd_next               <= CMD_NOP;
-                need_refresh_next      <= '0';
-                refresh_postponed_next <= '0';
                 state_next             <= ST_IDLE;
                 seq_count_next         <= 0;
             else
@@ -802,10 +1081,10 @@ begin
             end if;
 
         --========================================
-        -- ST_PRECHARGE - Close currently active row
+        -- ST_PRECHARGE - Close all open rows (before refresh)
         --========================================
-        -- Purpose: Close (precharge) the currently open row to allow access
-        --          to a different row, or prepare for refresh operation.
+        -- Purpose: Close (precharge) every open row to prepare for the
+        --          refresh operation.
         --
         -- Signal Requirements:
         --   CMD    = PRECHARGE (CS_N RAS_N CAS_N WE_N = 0010)
@@ -815,20 +1094,20 @@ begin
         --   DQM    = (don't care)
         --
         -- Command Timing:
-        --   Cycle 1 (seq_count=0):  Issue CMD_PRE with A10=1
+        --   Cycle 1 (seq_count=0):  Issue CMD_PRE with A10=1 once tRAS is
+        --                           met in every bank (NOP until then)
         --   Cycles 2-tRP:           Issue CMD_NOP while banks precharge
-        --   Cycle tRP:              Complete, clear row_active, return to IDLE
+        --   Cycle tRP:              Complete, clear bank_open, return to IDLE
         --
         -- Timing: Wait tRP cycles (~20ns = 2 cycles @ 100MHz)
         --
         -- Why A10=1 (All Banks)?
-        --   - Simpler: Don't need to track which specific bank to precharge
-        --   - Safer: Ensures all banks are in known precharged state
-        --   - Cost: Negligible (tRP timing same for single or all banks)
+        --   - AUTO REFRESH needs every bank idle
+        --   - Row misses only close their own bank (ST_PRECHARGE_BANK)
         --
         -- State Management:
-        --   row_active = '0' after completion
-        --   active_row/active_bank preserved (for debugging)
+        --   bank_open = "0000" after completion
+        --   bank_row preserved (for debugging)
         --
         -- Exit Condition: ALWAYS returns to ST_IDLE
         --                 IDLE will then decide next action:
@@ -840,20 +1119,54 @@ begin
 
         when ST_PRECHARGE =>
             if seq_count = 0 then
-                cmd_next        <= CMD_PRE;
-                sdram_addr_next <= (10 => '1', others => '0');  -- Set ALL bits!
-                seq_count_next  <= seq_count + 1;
+                if all_tras_met = '1' then
+                    cmd_next        <= CMD_PRE;
+                    sdram_addr_next <= (10 => '1', others => '0');  -- Set ALL bits!
+                    seq_count_next  <= seq_count + 1;
+                else
+                    cmd_next        <= CMD_NOP;  -- tRAS not met yet
+                end if;
             elsif seq_count = TRP_CYCLES then
                 -- according to ISSI datasheet
                 -- precharge always retuns to IDLE
                 cmd_next        <= CMD_NOP;
                 sdram_addr_next <= (others => '0');   -- Clear Address
-                row_active_next <= '0';
+                bank_open_next  <= "0000";
                 state_next      <= ST_IDLE;
                 seq_count_next  <= 0;
             else
                 cmd_next        <= CMD_NOP;
                 seq_count_next  <= seq_count + 1;
+            end if;
+
+        --========================================
+        -- ST_PRECHARGE_BANK - Close the open row of one bank (row miss)
+        --========================================
+        -- Purpose: The addressed bank has another row open. Close only that
+        --          bank, the rows open in the other banks stay open.
+        --
+        -- Signal Requirements:
+        --   CMD    = PRECHARGE (CS_N RAS_N CAS_N WE_N = 0010)
+        --   A10    = '0' --> Selected bank only
+        --   BA     = addr_bank_latched
+        --
+        -- Command Timing:
+        --   NOP until tRAS of the bank is met, then issue CMD_PRE and go
+        --   straight to ST_ACTIVATE, which waits for the bank tRP itself
+        --   (bank_trp) before issuing the ACTIVATE.
+        --
+        -- Write recovery (tWR) is already covered: ST_WRITE only returns
+        -- to IDLE tRP cycles after the WRITE command.
+
+        when ST_PRECHARGE_BANK =>
+            cmd_next <= CMD_NOP;
+            if bank_tras(to_integer(unsigned(addr_bank_latched))) >= TRAS_CYCLES then
+                cmd_next        <= CMD_PRE;
+                sdram_ba_next   <= addr_bank_latched;
+                sdram_addr_next <= (others => '0');  -- A10=0: this bank only
+                bank_open_next(to_integer(unsigned(addr_bank_latched))) <= '0';
+                state_next      <= ST_ACTIVATE;
+                seq_count_next  <= 0;
             end if;	
         
         --========================================
@@ -870,6 +1183,8 @@ begin
         --
         -- Command Timing:
         --   Cycle 1 (seq_count=0):  Issue CMD_ACT with bank and row address
+        --                           once tRP of the bank is met (NOP until
+        --                           then, right after ST_PRECHARGE_BANK)
         --                           Latch bank/row into active tracking
         --   Cycles 2-tRCD:          Issue CMD_NOP while row activates
         --   Cycle tRCD:             Row ready! Transition to ST_READ or ST_WRITE
@@ -878,9 +1193,8 @@ begin
         --         This is RAS-to-CAS delay - time for row to stabilize
         --
         -- State Tracking (when USE_AUTO_PRECHARGE = false):
-        --   active_row  = addr_row_latched   --> Remember which row is open
-        --   active_bank = addr_bank_latched  --> Remember which bank
-        --   row_active  = '1'                --> Flag that a row is open
+        --   bank_row(bank)  = addr_row_latched  --> Remember which row is open
+        --   bank_open(bank) = '1'               --> Flag that a row is open
         --
         -- Exit Path:
         --   Always → ST_READ or ST_WRITE
@@ -889,13 +1203,17 @@ begin
         
         when ST_ACTIVATE =>
             if seq_count = 0 then
-                cmd_next         <= CMD_ACT;
-                sdram_ba_next    <= addr_bank_latched;
-                sdram_addr_next  <= std_logic_vector(resize(unsigned(addr_row_latched), ROW_BITS));
-                active_row_next  <= addr_row_latched;
-                active_bank_next <= addr_bank_latched;
-                row_active_next  <= '1';
-                seq_count_next   <= seq_count + 1;
+                if bank_trp(to_integer(unsigned(addr_bank_latched))) >= TRP_CYCLES and
+                   act_gap >= TRRD_CYCLES then
+                    cmd_next         <= CMD_ACT;
+                    sdram_ba_next    <= addr_bank_latched;
+                    sdram_addr_next  <= std_logic_vector(resize(unsigned(addr_row_latched), ROW_BITS));
+                    bank_row_next(to_integer(unsigned(addr_bank_latched)))  <= addr_row_latched;
+                    bank_open_next(to_integer(unsigned(addr_bank_latched))) <= '1';
+                    seq_count_next   <= seq_count + 1;
+                else
+                    cmd_next         <= CMD_NOP;  -- tRP of the bank / tRRD not met yet
+                end if;
             elsif seq_count = TRCD_CYCLES then
                 cmd_next         <= CMD_NOP;
                 if wr_n_latched = '0' then
@@ -922,6 +1240,7 @@ begin
         --                               '0' = row stays open
         --   A9:0   = Column address
         --   DQM    = NOT byte_en --> Byte selection
+        --            "00" for the whole burst when burst_latched = '1'
         --
         -- Command Timing:
         --   Cycle 1 (seq_count=0):   Issue READ command with A10 as above
@@ -929,6 +1248,16 @@ begin
         --   Cycle CAS_LAT+1:         Data valid, capture and acknowledge
         --                            Issue BST to stop any residual burst
         --
+        -- Burst Read (burst_latched = '1', BURST_LENGTH = 4 or 8):
+        --   Cycles CAS_LAT+1 .. CAS_LAT+BURST_LENGTH:
+        --                            One word per clock, dvalid pulses
+        --                            ack on the last word, no BST needed
+        --
+        -- Auto-precharge with BURST_LENGTH > 1:
+        --   BST is not allowed on a READA, the chip always plays the full
+        --   burst and precharges afterwards. Stay here until read_ap_end
+        --   so the next ACTIVATE respects tRP. ack is still given early.
+        --
         -- NOTE: The +1 in CAS_LATENCY+1 is required because:
         --   seq_count=0: Issue READ command
         --   seq_count=1: First cycle of CAS latency
@@ -936,12 +1265,18 @@ begin
         --   seq_count=3: Data valid (= CAS_LATENCY+1)
         --   Data becomes valid one cycle AFTER the CAS latency period completes
         --
+        -- Read Capture Delay:
+        --   The capture points above use rd_lat = CAS_LATENCY + rd_delay.
+        --   rd_delay (0-3) is found at power-on by sdram_trainer, it absorbs
+        --   the board/PLL delay of the data path at high SDRAM clocks.
+        --   The chip side (READ, DQM, BST) is unchanged.
+        --
         -- Row Management after operation:
         --   USE_AUTO_PRECHARGE = true:  Row closed internally by SDRAM (A10=1)
-        --                               row_active <= '0', back to ST_IDLE
+        --                               bank_open(bank) <= '0', back to ST_IDLE
         --   USE_AUTO_PRECHARGE = false: Row stays open (A10=0)
-        --                               row_active STAYS '1', back to ST_IDLE
-        --                               active_row/active_bank unchanged
+        --                               bank_open(bank) STAYS '1', back to ST_IDLE
+        --                               bank_row unchanged
         --                               Next access to same row skips ACTIVATE
         --
         -- Performance:
@@ -950,7 +1285,9 @@ begin
 
 
         when ST_READ =>
-            if seq_count = 0 then
+            if seq_count = 0 and bank_tras(to_integer(unsigned(addr_bank_latched))) < TRCD_CYCLES then
+                cmd_next                             <= CMD_NOP;  -- row opened by the look-ahead, tRCD
+            elsif seq_count = 0 then
                 cmd_next                             <= CMD_READ;
                 sdram_ba_next                        <= addr_bank_latched;
                 sdram_addr_next                      <= (others => '0');
@@ -960,23 +1297,70 @@ begin
                     sdram_addr_next(10)              <= '0';  -- A10=0, No auto-precharge
                 end if;
                 sdram_addr_next(COL_BITS-1 downto 0) <= addr_col_latched;
-                sdram_dqm_next                       <= not byte_en_latched;
+                if burst_latched = '1' then
+                    sdram_dqm_next                   <= "00";  -- all beats, both bytes
+                else
+                    sdram_dqm_next                   <= not byte_en_latched;
+                end if;
                 seq_count_next                       <= seq_count + 1;
-            elsif seq_count = CAS_LATENCY + 1 then
+            elsif burst_latched = '1' and seq_count > rd_lat and
+                  seq_count <= rd_lat + BURST_LENGTH then
+                -- Burst beat: same +1 offset as a single read, one word per clock
+                cmd_next       <= CMD_NOP;
+                dout_next      <= sdram_dq;
+                dvalid_next    <= '1';
+                sdram_dqm_next <= "00";
+                if seq_count = rd_lat + BURST_LENGTH then
+                    ack_next   <= '1';           -- last word of the burst
+                    if USE_AUTO_PRECHARGE = true then
+                        seq_count_next <= seq_count + 1;
+                    else
+                        state_next     <= ST_IDLE;
+                        seq_count_next <= 0;
+                    end if;
+                else
+                    seq_count_next <= seq_count + 1;
+                end if;
+            elsif burst_latched = '0' and seq_count = rd_lat + 1 then
                 -- NOTE: The +1 is REQUIRED because:
                 --   seq_count=0: Issue READ command
                 --   seq_count=1: First cycle of CAS latency
                 --   seq_count=2: Second cycle of CAS latency (CAS_LATENCY=2)
                 --   seq_count=3: Data valid (=CAS_LATENCY+1)
                 -- Data becomes valid one cycle AFTER the CAS latency period completes            
-                cmd_next       <= CMD_BST;   -- was CMD_NOP
                 dout_next      <= sdram_dq;
                 ack_next       <= '1';
-                sdram_dqm_next <= DQM_IDLE; --"11";
+                if USE_AUTO_PRECHARGE = true then
+                    -- READA: no BST (not allowed with auto-precharge), let
+                    -- the burst run out masked by DQM and wait tRP in
+                    -- read_ap_end, which closes bank_open
+                    cmd_next       <= CMD_NOP;
+                    if BURST_LENGTH = 1 then
+                        sdram_dqm_next <= DQM_IDLE; --"11";
+                    end if;
+                    seq_count_next <= seq_count + 1;
+                elsif BURST_LENGTH = 1 then
+                    cmd_next       <= CMD_BST;   -- was CMD_NOP
+                    sdram_dqm_next <= DQM_IDLE; --"11";
+                    state_next     <= ST_IDLE;
+                    seq_count_next <= 0;
+                else
+                    -- Cut the unwanted beats, keep them masked off the bus
+                    cmd_next       <= CMD_BST;
+                    state_next     <= ST_IDLE;
+                    seq_count_next <= 0;
+                end if;
+            elsif seq_count >= read_ap_end then
+                -- Auto-precharge burst finished + tRP elapsed
+                cmd_next       <= CMD_NOP;
+                bank_open_next(to_integer(unsigned(addr_bank_latched))) <= '0';
                 state_next     <= ST_IDLE;
                 seq_count_next <= 0;
             else
                 cmd_next       <= CMD_NOP;
+                if burst_latched = '1' and seq_count <= rd_lat + BURST_LENGTH then
+                    sdram_dqm_next <= "00";
+                end if;
                 seq_count_next <= seq_count + 1;
             end if;
 
@@ -1005,10 +1389,10 @@ begin
         --
         -- Row Management after operation:
         --   USE_AUTO_PRECHARGE = true:  Row closed internally by SDRAM (A10=1)
-        --                               row_active <= '0', back to ST_IDLE
+        --                               bank_open(bank) <= '0', back to ST_IDLE
         --   USE_AUTO_PRECHARGE = false: Row stays open (A10=0)
-        --                               row_active STAYS '1', back to ST_IDLE
-        --                               active_row/active_bank unchanged
+        --                               bank_open(bank) STAYS '1', back to ST_IDLE
+        --                               bank_row unchanged
         --                               Next access to same row skips ACTIVATE
         --
         -- Performance:
@@ -1017,7 +1401,9 @@ begin
       
 
         when ST_WRITE =>
-            if seq_count = 0 then
+            if seq_count = 0 and bank_tras(to_integer(unsigned(addr_bank_latched))) < TRCD_CYCLES then
+                cmd_next                             <= CMD_NOP;  -- row opened by the look-ahead, tRCD
+            elsif seq_count = 0 then
                 cmd_next                             <= CMD_WRITE;
                 sdram_ba_next                        <= addr_bank_latched;
                 sdram_addr_next                      <= (others => '0');
@@ -1040,7 +1426,7 @@ begin
                 cmd_next             <= CMD_NOP;
                 sdram_dqm_next       <= DQM_IDLE; --"11";
                 if USE_AUTO_PRECHARGE = true  then
-                    row_active_next  <= '0';  
+                    bank_open_next(to_integer(unsigned(addr_bank_latched))) <= '0';
                 end if;
                 state_next           <= ST_IDLE;
                 seq_count_next       <= 0;
@@ -1053,6 +1439,33 @@ begin
             state_next <= ST_INIT;
                 
     end case;
+
+    --========================================
+    -- Bank look-ahead
+    --========================================
+    -- Uses a NOP slot of the current access to prepare the bank of the
+    -- announced next request (see 13. in the header). The current bank
+    -- is never touched, the per-bank counters keep tRAS/tRP/tRRD.
+
+    if la_slot = '1' and next_req = '1' and refresh_urgent = '0' and
+       nxt_bank /= addr_bank_latched then
+        if bank_open(to_integer(unsigned(nxt_bank))) = '0' then
+            if bank_trp(to_integer(unsigned(nxt_bank))) >= TRP_CYCLES and
+               act_gap >= TRRD_CYCLES then
+                cmd_next        <= CMD_ACT;
+                sdram_ba_next   <= nxt_bank;
+                sdram_addr_next <= nxt_row;
+                bank_row_next(to_integer(unsigned(nxt_bank)))  <= nxt_row;
+                bank_open_next(to_integer(unsigned(nxt_bank))) <= '1';
+            end if;
+        elsif bank_row(to_integer(unsigned(nxt_bank))) /= nxt_row and
+              bank_tras(to_integer(unsigned(nxt_bank))) >= TRAS_CYCLES then
+            cmd_next        <= CMD_PRE;
+            sdram_ba_next   <= nxt_bank;
+            sdram_addr_next <= (others => '0');  -- A10=0: this bank only
+            bank_open_next(to_integer(unsigned(nxt_bank))) <= '0';
+        end if;
+    end if;
     end process;
 
-end rtl;
\ No newline at end of file
+end rtl;
\ No newline at end of file
@@ -0,0 +1,259 @@
+--------------------------------------------------------------------------------
+-- SDRAM Read Capture Trainer
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- SDRAM Trainer - Theory of Operation
+--------------------------------------------------------------------------------
+-- Power-on calibration of the read capture point of sdram_controller.
+-- Sits between the client (bridge or arbiter) and the controller, same
+-- clock (sdram_clk).
+--
+-- 1. Why
+--    - The read data comes back CAS_LATENCY clocks after READ on the
+--      chip, plus the board and PLL phase delay of sdram_clk / DQ
+--    - At 100 MHz the fixed capture point works; at 133 MHz the data may
+--      arrive one clock later depending on the board
+--    - Instead of hand-tuning the PLL phase per board, the controller
+--      samples CAS_LATENCY + rd_delay clocks after READ and the trainer
+--      finds rd_delay
+--
+-- 2. Sweep
+--    - Once the controller is ready (initialization done), for
+--      rd_delay = 0, 1, 2, 3:
+--      * write TRAIN_WORDS words at addresses 0 .. TRAIN_WORDS-1
+--      * read them back with that rd_delay and compare
+--    - Patterns change with the word and the delay (pattern xor
+--      delay*x"1111"), so a stale value on the bus never matches
+--    - The first (smallest, fastest) passing rd_delay is kept
+--    - No passing value: rd_delay = 0, train_ok = '0'
+--
+-- 3. Client Port
+--    - Held off (ready = '0') until training is done
+--    - Then everything passes straight through, the trainer is idle
+--    - The first TRAIN_WORDS words of the SDRAM are overwritten at
+--      power-on (the content is undefined at that point anyway)
+--
+-- 4. Re-latch Protection
+--    - Same as sdram_arbiter: the training req is masked with ack
+--
+-- 5. Limits
+--    - The CAS latency programmed in the mode register stays the
+--      CAS_LATENCY generic; the sweep finds the total read latency seen
+--      by the FPGA (CAS_LATENCY + rd_delay)
+--------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.std_logic_1164.all;
+use IEEE.numeric_std.all;
+
+entity sdram_trainer is
+    generic (
+        ADDR_WIDTH     : integer := 25;     -- sdram_controller addr width (ROW_BITS+COL_BITS+2)
+        TRAIN_WORDS    : integer := 4;      -- words written/read per candidate (1 to 16)
+        ENABLE         : boolean := true    -- false = rd_delay "00", no training
+    );
+    port (
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+
+        -- Client side
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+
+        -- sdram_controller side
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0';
+        rd_delay       : out unsigned(1 downto 0);
+
+        -- Result
+        train_done     : out std_logic;
+        train_ok       : out std_logic
+    );
+end sdram_trainer;
+
+architecture rtl of sdram_trainer is
+
+    type train_state_type is (T_WAIT_READY, T_WRITE, T_WRITE_ACK, T_READ, T_READ_ACK, T_CHECK, T_DONE);
+    signal t_state     : train_state_type := T_WAIT_READY;
+
+    signal delay       : integer range 0 to 3 := 0;               -- candidate rd_delay
+    signal word        : integer range 0 to TRAIN_WORDS-1 := 0;   -- word under test
+    signal mismatch    : std_logic := '0';                        -- candidate failed
+    signal t_req       : std_logic := '0';
+    signal t_wr_n      : std_logic := '1';
+    signal done        : std_logic := '0';
+    signal ok          : std_logic := '0';
+    signal best        : unsigned(1 downto 0) := "00";            -- delay in use
+
+    -- Test word for (candidate, word)
+    function pattern(d : integer; w : integer) return std_logic_vector is
+        variable p : std_logic_vector(15 downto 0);
+    begin
+        case w mod 4 is
+            when 0      => p := x"A55A";
+            when 1      => p := x"5AA5";
+            when 2      => p := x"FF00";
+            when others => p := x"00FF";
+        end case;
+        p := p xor std_logic_vector(to_unsigned(w * 16#0101#, 16));
+        return p xor std_logic_vector(to_unsigned(d * 16#1111#, 16));
+    end function;
+
+    signal expected    : std_logic_vector(15 downto 0);
+
+begin
+
+    assert TRAIN_WORDS >= 1 and TRAIN_WORDS <= 16
+        report "sdram_trainer: TRAIN_WORDS must be 1 to 16" severity failure;
+
+    expected <= pattern(delay, word);
+
+    --========================================
+    -- Sweep FSM
+    --========================================
+    -- T_WAIT_READY: controller initialization
+    -- T_WRITE / T_WRITE_ACK: write the TRAIN_WORDS patterns
+    -- T_READ / T_READ_ACK: read them back with rd_delay = delay
+    -- T_CHECK: keep the first passing delay or try the next one
+    -- T_DONE: pass-through
+
+    process(clk)
+    begin
+        if rising_edge(clk) then
+            if reset_n = '0' then
+                t_state  <= T_WAIT_READY;
+                delay    <= 0;
+                word     <= 0;
+                mismatch <= '0';
+                t_req    <= '0';
+                t_wr_n   <= '1';
+                done     <= '0';
+                ok       <= '0';
+                best     <= "00";
+            else
+                case t_state is
+                    when T_WAIT_READY =>
+                        if ENABLE = false then
+                            ok      <= '1';
+                            done    <= '1';
+                            t_state <= T_DONE;
+                        elsif ready = '1' then
+                            best    <= to_unsigned(delay, 2);
+                            word    <= 0;
+                            t_state <= T_WRITE;
+                        end if;
+
+                    when T_WRITE =>
+                        if ready = '1' then
+                            t_req   <= '1';
+                            t_wr_n  <= '0';
+                            t_state <= T_WRITE_ACK;
+                        end if;
+
+                    when T_WRITE_ACK =>
+                        if ack = '1' then
+                            t_req  <= '0';
+                            t_wr_n <= '1';
+                            if word = TRAIN_WORDS-1 then
+                                word    <= 0;
+                                t_state <= T_READ;
+                            else
+                                word    <= word + 1;
+                                t_state <= T_WRITE;
+                            end if;
+                        end if;
+
+                    when T_READ =>
+                        if ready = '1' then
+                            t_req   <= '1';
+                            t_state <= T_READ_ACK;
+                        end if;
+
+                    when T_READ_ACK =>
+                        if ack = '1' then
+                            t_req <= '0';
+                            if dout /= expected then
+                                mismatch <= '1';
+                            end if;
+                            if word = TRAIN_WORDS-1 then
+                                t_state <= T_CHECK;
+                            else
+                                word    <= word + 1;
+                                t_state <= T_READ;
+                            end if;
+                        end if;
+
+                    when T_CHECK =>
+                        if mismatch = '0' then
+                            ok      <= '1';
+                            done    <= '1';
+                            t_state <= T_DONE;
+                        elsif delay = 3 then
+                            best    <= "00";
+                            done    <= '1';
+                            t_state <= T_DONE;
+                        else
+                            delay    <= delay + 1;
+                            mismatch <= '0';
+                            t_state  <= T_WAIT_READY;
+                        end if;
+
+                    when T_DONE =>
+                        null;
+                end case;
+            end if;
+        end if;
+    end process;
+
+    rd_delay   <= best;
+    train_done <= done;
+    train_ok   <= ok;
+
+    --========================================
+    -- Port mux
+    --========================================
+
+    req     <= c_req     when done = '1' else t_req and not ack;
+    wr_n    <= c_wr_n    when done = '1' else t_wr_n;
+    addr    <= c_addr    when done = '1' else std_logic_vector(to_unsigned(word, ADDR_WIDTH));
+    din     <= c_din     when done = '1' else expected;
+    byte_en <= c_byte_en when done = '1' else "11";
+    burst   <= c_burst   when done = '1' else '0';
+
+    c_dout   <= dout;
+    c_ready  <= ready  and done;
+    c_ack    <= ack    and done;
+    c_dvalid <= dvalid and done;
+
+end rtl;
@@ -1,5 +1,5 @@
 --------------------------------------------------------------------------------
--- SRAM to SDRAM Bridge with Write-Through Cache
+-- SRAM to SDRAM Bridge with Cache
 -- Copyright (c) 2025 Didier Derny
 --
 -- This work is licensed under the Creative Commons 
@@ -19,96 +19,311 @@
 -- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
 --------------------------------------------------------------------------------
 --------------------------------------------------------------------------------
--- SRAM to SDRAM Bridge (Write-Through Cached Version)
+-- SRAM to SDRAM Bridge (Cached Version)
 --------------------------------------------------------------------------------
 -- This module provides a transparent SRAM-like interface to a 16-bit SDRAM
--- controller with an integrated write-through cache for 8-bit CPUs.
+-- controller with an integrated cache for 8-bit CPUs:
+--   - write-through or write-back (WRITE_BACK), see 2.
+--   - posted write-through stores (USE_WRITE_BUFFER), see 2.
+--   - direct-mapped, 2-way or 4-way (ASSOCIATIVITY), see 1.
+--   - split instruction/data ways (SPLIT_ID), see 12.
+--   - next-line prefetch (PREFETCH), see 13.
+--   - burst line fills (BURST_LENGTH), see 4.
+--   - fast page at the bottom of the window (FAST_BYTES), see 16.
+-- With USE_CACHE = false every access goes straight to the SDRAM (see 8.).
 --
 -- Theory of Operation:
 --
--- 1. Cache Architecture (Direct-Mapped)
+-- 1. Cache Architecture (Direct-Mapped or Set-Associative)
 --    - Default: 1KB cache with 16-byte lines = 64 cache lines
---    - Each memory address maps to exactly one cache line:
+--    - ASSOCIATIVITY = 1, 2 or 4 ways per set (1 = direct-mapped)
+--    - Each memory address maps to exactly one set:
 --      * TAG bits: Identify which block is cached
---      * INDEX bits: Select which cache line (6 bits = 64 lines)
+--      * INDEX bits: Select which set (6 bits = 64 sets direct-mapped,
+--        5 bits = 32 sets 2-way, 4 bits = 16 sets 4-way)
 --      * OFFSET bits: Select byte within line (4 bits = 16 bytes)
+--      * Widths derived from the generics with log2:
+--        OFFSET_BITS = log2(LINE_SIZE_BYTES)
+--        INDEX_BITS  = log2(CACHE_SIZE_BYTES / LINE_SIZE_BYTES / ASSOCIATIVITY)
+--        TAG_BITS    = ADDR_BITS - INDEX_BITS - OFFSET_BITS
+--    - Geometry limits (checked at elaboration):
+--      * CACHE_SIZE_BYTES, LINE_SIZE_BYTES: powers of two
+--      * LINE_SIZE_BYTES from 4 to 64 (2 to 32 SDRAM words)
+--      * CACHE_SIZE_BYTES < 2**ADDR_BITS (at least one tag bit)
+--      * Size it per board from the free M9K/M10K blocks: each 8KB of
+--        cache is 8 M9K (8 Kbit blocks) or ~7 M10K
+--    - All ways of the set are compared in parallel (one clock)
+--    - Cache line number = set * ASSOCIATIVITY + way, tag/valid/dirty
+--      bits and data are stored by line number
+--    - Replacement: an invalid way first, else tree pseudo-LRU
+--      (1 bit per set for 2-way, 3 bits per set for 4-way), updated
+--      on every hit and on every allocation
 --    - Cache storage in BRAM (M9K blocks) for efficiency
+--      * Split in two byte banks: even bytes and odd bytes
+--      * One 16-bit SDRAM word = one entry in each bank, written together
+--    - Tags in logic (registers), compared without a read clock
 --    - Valid bit per line indicates if cached data is current
 --
--- 2. Write-Through Policy
+-- 2. Write Policy (WRITE_BACK generic)
+--    WRITE_BACK = false: Write-Through (default)
 --    - Writes ALWAYS go to both cache AND SDRAM
 --    - On write HIT: Update cache line, then write through to SDRAM
 --    - On write MISS: Write through to SDRAM only (NO-ALLOCATE)
 --    - Guarantees SDRAM always has correct data (cache never "dirty")
 --    - Simple and robust - no complex writeback logic needed
+--    WRITE_BACK = true: Write-Back / Write-Allocate
+--    - On write HIT: Update cache line only, set the line dirty bit
+--      (1 clock, like a read hit - no SDRAM access)
+--    - On write MISS: Fetch the line like a read miss, then update it
+--    - Replacing a valid dirty line first writes its 8 words back
+--      (EVICT_READ → EVICT_START → EVICT_WRITING, loop 8x)
+--    - flush input (rising edge): every dirty line is written back and
+--      made clean, flush_busy stays high until it is done. CPU accesses
+--      wait during the flush
+--
+--    Posted writes (USE_WRITE_BUFFER, off by default, write-through only)
+--    - The write to SDRAM is queued in a small FIFO (WRITE_BUFFER_DEPTH
+--      entries of word address, data and byte_en) and MRDY is released
+--      right away, the FIFO drains to SDRAM in the background (WB_DRAIN)
+--    - CPU only waits when the FIFO is full
+--    - A read that misses the cache but matches a pending entry is
+--      forwarded from the FIFO (youngest entry wins)
+--    - Other read misses wait for the FIFO to drain before the line
+--      fill, so a fetched line never misses a posted write
+--    - flush also drains the FIFO (flush_busy until it is empty)
+--
+--    SDRAM look-ahead (sdram_next_req / sdram_next_addr)
+--    - Announces the request that follows the current one so the
+--      controller can open its bank behind the current access:
+--      * the next write buffer entry while two or more are pending
+--      * the line to fill while a dirty line is written back
 --
 -- 3. Read Operations
 --    - On read HIT: Return data instantly from cache (1 clock)
 --    - On read MISS: Fetch entire 16-byte line from SDRAM
---      * FSM loops 16 times to fetch all bytes in the line
---      * Stores complete line in cache
---      * Marks line as valid
---      * Returns requested byte to CPU
+--      * Fill starts on the word the CPU asked for (critical word first)
+--      * Requested byte is returned as soon as its word arrives
+--      * Remaining words are stored in the background
+--      * Line is marked valid once all 8 words are in
 --    - Subsequent reads from same line are cache hits
 --
 -- 4. Line Fetch Mechanism (Read Miss)
---    States: MISS_FETCH_START → MISS_FETCHING (loop 16x) → CACHE_HIT
---    - Fetches all 16 bytes of the cache line sequentially
---    - Each byte requires one SDRAM access (~10 clocks)
---    - Total miss penalty: ~160 clocks for complete line
+--    Fill engine: MISS_FETCH_START → MISS_FETCHING (loop 8x) → FILL_IDLE
+--    CPU side:    CACHE_CHECK → FILL_WAIT → IDLE (MRDY released early)
+--    - Critical word first: the first request starts on the missed word
+--      * BURST_LENGTH = 1: words k..7 then 0..k-1
+--      * BURST_LENGTH > 1: the SDRAM wraps inside the BL aligned block
+--        (sequential burst type), e.g. 5,6,7,4 then 0,1,2,3 for BL=4
+--    - FILL_WAIT forwards the byte from sdram_dout on the beat that
+--      carries it, the CPU then runs while the line completes
+--    - word_present tracks which words already landed, so a read to the
+--      line being filled is served from the cache or waits for its word
+--    - While a fill runs, reads to other cached lines still hit; writes
+--      and read misses wait until the fill is over
+--    - BURST_LENGTH = 1 (single word controller):
+--      * Fetches the 8 16-bit words of the cache line sequentially
+--      * Each word requires one SDRAM access (~10 clocks)
+--      * Each word fills 2 cache bytes (even + odd bank) in one clock
+--      * Total miss penalty: ~80 clocks for complete line
+--    - BURST_LENGTH = 4 or 8 (controller programmed for bursts):
+--      * Line is fetched as 8 consecutive 16-bit words
+--      * One request per BURST_LENGTH words (1 for BL=8, 2 for BL=4)
+--      * Lines shorter than a burst (e.g. 8-byte lines with BL=8) are
+--        fetched with single word reads (FILL_BURST = 1), a burst would
+--        wrap outside of the line
+--      * Controller pulses sdram_dvalid once per word, one word per clock
+--      * Both cache banks are written on every beat
+--      * Total miss penalty: ~15-20 clocks with BL=8 (one ACTIVATE)
 --    - But next 15 accesses in that line are instant hits!
 --
 -- 5. Spatial Locality Optimization
 --    - Sequential code execution: Fetch 1 instruction → next 15 are cached
 --    - Data structures: Accessing one field → nearby fields are cached
 --    - Loop code: First iteration fills cache → subsequent iterations hit
+--    - 2/4-way sets stop code and data 1KB apart from evicting each
+--      other (compare cache_hitp with ASSOCIATIVITY = 1)
 --    - Example: Tight loop at $5000-$500F:
---      * First access: miss, fetch 16 bytes (~160 clocks)
+--      * First access: miss, fetch 8 words (~80 clocks)
 --      * Next 15+ accesses: all hits (1 clock each) = ~100% hit rate
 --
 -- 6. FSM States
 --    - IDLE: Wait for CPU access
 --    - CACHE_CHECK: Check for hit/miss, decide read or write path
 --    - CACHE_HIT: Return data from cache (read only)
---    - MISS_FETCH_START: Begin fetching byte from SDRAM
---    - MISS_FETCHING: Store fetched byte, continue or complete
+--    - FAST_HIT: Read or write the fast page (see 16.)
+--    - FILL_WAIT: Wait for the critical word of a line fill
 --    - WAIT_SDRAM_ACK: Wait for write completion or bypass read
+--    Fill engine (parallel FSM in the same process):
+--    - FILL_IDLE: No line fill in progress
+--    - MISS_FETCH_START: Begin fetching word (or burst) from SDRAM
+--    - MISS_FETCHING: Store fetched word, continue or complete
+--    - EVICT_READ / EVICT_START / EVICT_WRITING: write back a dirty line
+--      (WRITE_BACK = true, before a fill or during a flush)
+--    - WB_DRAIN: write the oldest posted write to SDRAM
 --
 -- 7. Clock Stretching via MRDY
 --    - Same mechanism as non-cached version
 --    - Cache hits return immediately (MRDY high after 1 clock)
---    - Cache misses block CPU until line fetch completes
---    - Writes block CPU until SDRAM write completes
+--    - Cache misses block CPU until the requested word arrives
+--    - Writes block CPU until SDRAM write completes (write-through)
+--      or for 1 clock on a write hit (write-back) or when posted
+--      to the write buffer
 --
 -- 8. Cache Bypass Mode
 --    - When USE_CACHE = false, behaves like non-cached bridge
---    - Allows runtime testing and comparison
 --    - All cache logic is synthesized away if USE_CACHE = false
+--    - Runtime: cache_en = '0' (cache_ctrl ENABLE) makes every access a
+--      miss that goes to SDRAM one byte at a time (CACHE_CHECK bypass,
+--      WAIT_SDRAM_ACK); posted writes still go through the write buffer
+--    - The cache is invalidated when cache_en comes back to '1' (the
+--      lines missed the writes made meanwhile); with WRITE_BACK flush
+--      before disabling, dirty lines are dropped
 --
 -- 9. Cache Statistics
 --    - Tracks hit rate over sliding 256-access window
 --    - Formula: hit_percent = (hit_counter * 25) >> 6
 --    - Approximates (hits * 100) / 256
 --    - Output on cache_hitp for real-time monitoring
+--    - ev_hit / ev_miss / ev_write: one clock pulse per counted access
+--      for exact totals (PMU); hit and miss as in hit_counter
+--    - ev_ihit / ev_imiss: the same pulses for opcode fetches only
+--      (sram_sync = '1'), data = ev_hit - ev_ihit, ev_miss - ev_imiss
+--    - ev_prefetch / ev_pf_hit: prefetches started and prefetched lines
+--      used (see 13.)
+--    - cache_ctrl counts ev_hit / ev_miss in 32-bit registers for the
+--      software (see 14.)
 --
 -- 10. SDRAM Refresh
---    - Same automatic refresh as non-cached version
---    - Refresh only issued when bus is idle
+--    - refresh_req pulses once per refresh interval (7.8µs), the
+--      controller keeps the refresh debt (up to 8 owed)
+--    - refresh_ok tells the controller when it may pay the debt: no CPU
+--      session (phi1, or the rest of phi2 after a hit), no line fill,
+--      no write back and no posted write waiting
+--    - Refreshes then run in the CPU idle time, in bursts, instead of
+--      in front of a miss
+--
+-- 11. Phase Prediction (PHASE_PREDICT, cpu_phase from cpu_clock_gen)
+--    - cpu_phase is the gray coded quarter of the CPU cycle:
+--      00, 01 = phi1 (E low), 11, 10 = phi2 (E high)
+--    - phi1 is never stretched, so the SDRAM clocks per quarter are
+--      measured on the 01 quarter (quarter_len) and every phase change
+--      reloads the number of clocks until E rises again (until_rise):
+--      00 → 2 quarters, 01 → 1, 11 → 4, 10 → 3 (no stretch after
+--      the access)
+--    - quiet_cycles = clocks before a CPU request can reach the
+--      controller (until_rise + decode latency); the controller only
+--      starts a REFRESH or PRECHARGE ALL that completes within it
+--    - Without PHASE_PREDICT quiet_cycles stays at 255 (no limit)
+--
+-- 12. Split Instruction / Data (SPLIT_ID, sram_sync = CPU SYNC)
+--    - Way partitioning: opcode fetches allocate in the low half of the
+--      ways, data in the high half (2-way: way 0 / way 1, 4-way: ways
+--      0-1 / 2-3, pseudo-LRU inside the pair with bit 1 / bit 2)
+--    - A memset or a FatFs sector buffer then only evicts data lines,
+--      the hot code loops stay in their ways
+--    - Lookups still compare all the ways: a line is never cached
+--      twice, code read as data (or written) hits wherever it sits
+--    - Only the SYNC cycle is an instruction fetch, the operand bytes
+--      are data for the CPU wrappers; they mostly hit the line the
+--      opcode just brought in
+--    - Needs ASSOCIATIVITY = 2 or 4 (checked at elaboration)
+--
+-- 13. Next-Line Prefetch (PREFETCH, PREFETCH_BYTES)
+--    - A read (or a write-back write) counted in CACHE_CHECK in the last
+--      PREFETCH_BYTES bytes of its line arms a prefetch of line + 1
+--    - The fill engine starts it from FILL_IDLE when the SDRAM is idle:
+--      no CPU session, no posted write, no flush; a line already cached
+--      (or a dirty victim, with WRITE_BACK) cancels it
+--    - Same fill as a miss, from word 0, into the victim way of the next
+--      set (SPLIT_ID: half of the access that armed it)
+--    - The CPU crossing the line boundary finds it valid, or being
+--      filled (FILL_WAIT for its word); a read miss elsewhere waits for
+--      the prefetch like for any background fill
+--    - pf_bits marks the prefetched lines not used yet: the first access
+--      to one pulses ev_pf_hit, ev_prefetch pulses on every prefetch
+--      started (useless prefetches = ev_prefetch - ev_pf_hit)
+--
+-- 14. Maintenance (maint_req / maint_op, cache_ctrl registers)
+--    - maint_req (one sdram_clk pulse) queues maint_op, run by the fill
+--      engine in FILL_IDLE after the write buffer drained (like a
+--      flush); CPU accesses wait in CACHE_CHECK until maint_busy drops
+--      * INVALIDATE ALL:  every line invalid and unlocked (1 clock)
+--      * INVALIDATE LINE: the line holding maint_lo, if cached (one
+--        clock per way of its set)
+--      * LOCK:            every cached line inside maint_lo .. maint_hi
+--        is locked (one clock per line)
+--      * UNLOCK ALL:      all lock bits cleared (1 clock)
+--      * PRELOAD:         every line of maint_lo .. maint_hi is fetched
+--        if missing and locked (see 15.)
+--    - Invalidation drops dirty data: flush first with WRITE_BACK
+--    - A locked line is never a victim (demand fill or prefetch); a
+--      miss in a set without an unlocked way (in its SPLIT_ID half) is
+--      not allocated and served from SDRAM like the bypass mode
+--    - LOCK only pins what is cached: run the routine (or read the
+--      range) once, then lock it; PRELOAD needs no warm-up
+--
+-- 15. Preload / Scratchpad (maint_op PRELOAD)
+--    - Walks maint_lo .. maint_hi one line at a time through the
+--      prefetch lookup (pf_line_addr, pf_present, pf_victim_line):
+--      * cached:  locked where it is, next line (1 clock)
+--      * missing: filled into the victim way like a prefetch (word 0
+--        first, a dirty victim is written back first), locked from the
+--        start of the fill; the next pass finds it cached
+--      * every way of the set locked: skipped, maint_full set (the
+--        range does not fit, the line keeps missing)
+--    - SPLIT_ID: preloaded lines go to the instruction half
+--    - maint_full stays valid until the next maint_req
+--    - Locked lines are never evicted: the time critical loops (SPI
+--      byte loop, sd_read copy, interpreter inner loop) then hit on
+--      every access, 1 clock, whatever else the CPU touches
+--    - Pinned capacity: ASSOCIATIVITY ways per set; with SPLIT_ID only
+--      the instruction half, which leaves the data half to the rest
+--
+-- 16. Fast Page (FAST_BYTES, all RAM behind the bridge)
+--    - The first FAST_BYTES of the bridge window (sram_addr below
+--      FAST_BYTES) live in a dedicated on-chip RAM and never reach the
+--      SDRAM: with the whole CPU RAM behind the bridge (Replica1_CORE
+--      RAM_IN_SDRAM) and FAST_BYTES = 512 that is the zero page and
+--      the stack
+--    - IDLE → FAST_HIT → IDLE for reads and writes: one clock less than
+--      a cache hit, no miss ever, no wait for a fill, a flush, a
+--      maintenance operation or the write buffer
+--    - Not a cache access: no ev_hit / ev_miss, not in cache_hitp
+--    - Not initialised by reset, like the EBR RAM it replaces
+--    - 0 = no fast page (default); else a power of two below the window
+--      size (512 = one M9K)
 --
 -- Performance Characteristics:
 --    - Cache HIT: 1 clock (instant)
---    - Cache MISS (read): ~160 clocks (fetch entire 16-byte line)
+--    - Cache MISS (read): CPU released after ~10 clocks (critical word)
+--                         line complete after ~80 clocks (8 words)
+--                         or ~20 clocks with BURST_LENGTH = 8
 --    - Write (hit or miss): ~10-15 clocks (SDRAM write time)
+--      Write-back hit: 1 clock, dirty miss adds ~80 clocks of write back
+--      Posted write: 1 clock while the write buffer is not full
 --    - Expected hit rate on real 6502/6809 code: 80-95%
 --    - Expected hit rate on random access: 25-50% (due to spatial locality)
 --    - Enables CPUs to run at 10-15 MHz with 120 MHz SDRAM
 --
 -- Design Notes:
---    - Cache data stored as 1D array for proper BRAM inference
+--    - Cache data stored as two 1D byte arrays (even/odd) for proper
+--      BRAM inference with a word wide fill port
+--    - Simple dual-port banks: one write address (cache_wr_word: a fill
+--      beat, else the CPU byte held in cpu_wr_pending) and one read
+--      address (cache_rd_word: CACHE_HIT or the write back), both in
+--      cache_write / the main process on sdram_clk
+--    - A CPU byte (write hit, write-allocate merge) is written one clock
+--      later, or after the fill beats; CACHE_CHECK and EVICT_READ wait
+--      for it, so no read sees the old byte
 --    - All address calculations captured in IDLE state to prevent
 --      metastability when sram_addr changes during operation
 --    - NO-ALLOCATE on write miss prevents creating lines with garbage data
+--      (write-through); write-back allocates on a full line fill instead
 --    - Write-through simplifies coherency (SDRAM is always correct)
+--    - Write-back: SDRAM is only correct after a flush, anything else
+--      reading SDRAM behind the bridge must flush first
+--    - Line write back reads the cache through the same read port as
+--      CACHE_HIT (cache_rd_word), the CPU is stalled while it runs
 --
 --------------------------------------------------------------------------------
 
@@ -122,10 +337,20 @@ entity sram_sdram_bridge is
         ADDR_BITS        : integer := 24;
         SDRAM_MHZ        : integer := 100;
         GENERATE_REFRESH : boolean := true;
+        PHASE_PREDICT    : boolean := false;  -- use cpu_phase to place refreshes (see 11.)
         USE_CACHE        : boolean := true;
+        WRITE_BACK       : boolean := false;  -- false = write-through/no-allocate, true = write-back/write-allocate
+        USE_WRITE_BUFFER : boolean := false;  -- post write-through stores, MRDY released when queued
+        WRITE_BUFFER_DEPTH : integer := 4;    -- posted writes: 2, 4 or 8 entries
         -- Cache parameters
         CACHE_SIZE_BYTES : integer := 1024;   -- 1KB cache
         LINE_SIZE_BYTES  : integer := 16;     -- 16-byte cache lines
+        ASSOCIATIVITY    : integer := 1;      -- ways per set: 1 (direct-mapped), 2 or 4
+        SPLIT_ID         : boolean := false;  -- opcode fetches / data in separate ways (see 12.)
+        PREFETCH         : boolean := false;  -- next-line prefetch (see 13.)
+        PREFETCH_BYTES   : integer := 4;      -- access in the last N bytes of a line arms it
+        BURST_LENGTH     : integer := 1;      -- must match sdram_controller BURST_LENGTH (1, 4 or 8)
+        FAST_BYTES       : integer := 0;      -- always-hit on-chip page at the bottom of the window (see 16.)
 		RAM_BLOCK_TYPE   : string  := "M9K, no_rw_check"   -- "M9K", "M4K", "M10K", "AUTO"
     );
     port (
@@ -137,12 +362,14 @@ entity sram_sdram_bridge is
         sram_ce_n     : in  std_logic;
         sram_we_n     : in  std_logic;
         sram_oe_n     : in  std_logic;
+        sram_sync     : in  std_logic := '0';  -- opcode fetch (CPU SYNC)
         sram_addr     : in  std_logic_vector(ADDR_BITS-1 downto 0);
         sram_din      : in  std_logic_vector(7 downto 0);
         sram_dout     : out std_logic_vector(7 downto 0);
         
         -- Memory ready output (for clock stretching)
         mrdy          : out std_logic;
+        cpu_phase     : in  std_logic_vector(1 downto 0) := "00";  -- cpu_clock_gen phase (gray)
         
         -- SDRAM controller interface
         sdram_req     : out std_logic;
@@ -153,27 +380,91 @@ entity sram_sdram_bridge is
         sdram_byte_en : out std_logic_vector(1 downto 0);
         sdram_ready   : in  std_logic;
         sdram_ack     : in  std_logic;
+        sdram_burst   : out std_logic;
+        sdram_dvalid  : in  std_logic := '0';
+        sdram_next_req  : out std_logic;  -- look-ahead hint for sdram_controller next_req
+        sdram_next_addr : out std_logic_vector(ADDR_BITS-2 downto 0);
         refresh_req   : out std_logic;
+        refresh_ok    : out std_logic;  -- to sdram_controller refresh_ok
+        quiet_cycles  : out unsigned(7 downto 0);  -- to sdram_controller quiet_cycles
         
+        -- Cache control (write-back)
+        flush         : in  std_logic := '0';  -- rising edge: write back all dirty lines / drain posted writes
+        flush_busy    : out std_logic;
+
+        -- Cache control (cache_ctrl registers, sdram_clk domain)
+        cache_en      : in  std_logic := '1';  -- '0': every access goes to SDRAM
+        maint_req     : in  std_logic := '0';  -- pulse: run maint_op (see 14.)
+        maint_op      : in  std_logic_vector(2 downto 0) := "000";
+        maint_lo      : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_hi      : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_busy    : out std_logic;
+        maint_full    : out std_logic;         -- PRELOAD skipped a line (see 15.)
+
         -- Cache statistics
         cache_hitp    : out unsigned(6 downto 0);  -- 0 to 100%
+        ev_hit        : out std_logic;  -- event pulses for the pmu
+        ev_miss       : out std_logic;
+        ev_write      : out std_logic;
+        ev_ihit       : out std_logic;  -- opcode fetch hits / misses
+        ev_imiss      : out std_logic;
+        ev_prefetch   : out std_logic;  -- prefetches started / first use of a prefetched line
+        ev_pf_hit     : out std_logic;
         debug         : out std_logic_vector(2 downto 0)
     );
 end sram_sdram_bridge;
 
 architecture rtl of sram_sdram_bridge is
 
+    -- log2 of a power of two (cache geometry)
+    function log2(n : integer) return integer is
+        variable bits : integer := 0;
+    begin
+        while (2 ** bits) < n loop
+            bits := bits + 1;
+        end loop;
+        return bits;
+    end function;
+
+    -- Line fill burst: bursts longer than the line would wrap outside of it
+    function fill_burst_length(burst_length, line_words : integer) return integer is
+    begin
+        if burst_length > line_words then
+            return 1;
+        end if;
+        return burst_length;
+    end function;
+
+    -- Fast page array size: one unused byte when there is no fast page
+    function fast_size(fast_bytes : integer) return integer is
+    begin
+        if fast_bytes = 0 then
+            return 1;
+        end if;
+        return fast_bytes;
+    end function;
+
     -- Refresh timing
     constant REFRESH_INTERVAL : integer := (SDRAM_MHZ * 78) / 10;
     
     -- Cache geometry
     constant NUM_LINES    : integer := CACHE_SIZE_BYTES / LINE_SIZE_BYTES;  -- 64 lines
-    constant INDEX_BITS   : integer := 6;   -- log2(64)
-    constant OFFSET_BITS  : integer := 4;   -- log2(16)
+    constant NUM_SETS     : integer := NUM_LINES / ASSOCIATIVITY;           -- 64 sets direct-mapped
+    constant LINE_WORDS   : integer := LINE_SIZE_BYTES / 2;                 -- 8 SDRAM words
+    constant CACHE_WORDS  : integer := CACHE_SIZE_BYTES / 2;
+    constant INDEX_BITS   : integer := log2(NUM_SETS);         -- 6 direct-mapped
+    constant OFFSET_BITS  : integer := log2(LINE_SIZE_BYTES);  -- 4
     constant TAG_BITS     : integer := ADDR_BITS - INDEX_BITS - OFFSET_BITS;
+    constant FILL_BURST   : integer := fill_burst_length(BURST_LENGTH, LINE_WORDS);
     
-    type state_type is (IDLE, CACHE_CHECK, CACHE_HIT, MISS_FETCH_START, MISS_FETCHING, WAIT_SDRAM_ACK);
+    -- CPU side FSM
+    type state_type is (IDLE, CACHE_CHECK, CACHE_HIT, FAST_HIT, FILL_WAIT, WAIT_SDRAM_ACK);
     signal state             : state_type := IDLE;
+
+    -- Line fill engine (runs in the background of the CPU FSM)
+    type fill_state_type is (FILL_IDLE, MISS_FETCH_START, MISS_FETCHING,
+                             EVICT_READ, EVICT_START, EVICT_WRITING, WB_DRAIN);
+    signal fill_state        : fill_state_type := FILL_IDLE;
     
     -- Synchronizers
     signal E_meta, E_sync    : std_logic;
@@ -183,42 +474,211 @@ architecture rtl of sram_sdram_bridge is
     
     -- Refresh
     signal refresh_counter   : integer range 0 to REFRESH_INTERVAL := 0;
-    signal refresh_pending   : std_logic := '0';
+
+    -- Phase prediction
+    constant MISS_LATENCY    : integer := 2;  -- E_sync rise to sdram_req (IDLE, CACHE_CHECK)
+    signal phase_meta        : std_logic_vector(1 downto 0) := "00";
+    signal phase_sync        : std_logic_vector(1 downto 0) := "00";
+    signal phase_prev        : std_logic_vector(1 downto 0) := "00";
+    signal quarter_count     : integer range 0 to 63 := 0;   -- clocks in the current 01 quarter
+    signal quarter_len       : integer range 1 to 63 := 1;   -- clocks per quarter (measured)
+    signal until_rise        : integer range 0 to 255 := 0;  -- clocks until E rises again
     
-    -- Cache storage (1KB in BRAM) - TABLEAU 1D
-    type cache_data_type is array (0 to CACHE_SIZE_BYTES-1) of std_logic_vector(7 downto 0);
-    signal cache_data : cache_data_type;
+    -- Cache storage (1KB in BRAM) - two 1D byte banks, indexed by word
+    type cache_data_type is array (0 to CACHE_WORDS-1) of std_logic_vector(7 downto 0);
+    signal cache_even : cache_data_type;   -- bytes with addr(0) = '0' (sdram_dout(7 downto 0))
+    signal cache_odd  : cache_data_type;   -- bytes with addr(0) = '1' (sdram_dout(15 downto 8))
     
-    -- Tag storage
+    -- Tag storage, in registers: all ways are read in the same clock
+    -- (hit_detect, pf_detect, maint_addr), no registered read for a BRAM
     type tag_array_type is array (0 to NUM_LINES-1) of std_logic_vector(TAG_BITS-1 downto 0);
     signal tag_array : tag_array_type := (others => (others => '0'));
 
     -- Attributes BRAM
     attribute ramstyle : string;
-    attribute ramstyle of cache_data : signal is RAM_BLOCK_TYPE; -- was M9K
-    attribute ramstyle of tag_array  : signal is RAM_BLOCK_TYPE; -- was M9K 
+    attribute ramstyle of cache_even : signal is RAM_BLOCK_TYPE; -- was M9K
+    attribute ramstyle of cache_odd  : signal is RAM_BLOCK_TYPE;
+
+    -- Fast page (see 16.), one byte per address
+    constant FAST_SIZE : integer := fast_size(FAST_BYTES);
+    type fast_data_type is array (0 to FAST_SIZE-1) of std_logic_vector(7 downto 0);
+    signal fast_ram   : fast_data_type;
+    signal fast_addr  : integer range 0 to FAST_SIZE-1 := 0;
+    attribute ramstyle of fast_ram   : signal is RAM_BLOCK_TYPE;
 
     -- Valid bits
     signal valid_bits : std_logic_vector(NUM_LINES-1 downto 0) := (others => '0');
     
+    -- Dirty bits (write-back only)
+    signal dirty_bits : std_logic_vector(NUM_LINES-1 downto 0) := (others => '0');
+
+    -- Pseudo-LRU tree per set: bit 0 = root (0: LRU in ways 0-1, 1: in ways 2-3),
+    -- bit 1 = LRU of ways 0-1, bit 2 = LRU of ways 2-3 (2-way uses bit 0 only)
+    type plru_array_type is array (0 to NUM_SETS-1) of std_logic_vector(2 downto 0);
+    signal plru_bits  : plru_array_type := (others => (others => '0'));
+
+    -- Tree pseudo-LRU: point every node on the way's path away from it
+    function plru_touch(plru : std_logic_vector(2 downto 0); way : integer) return std_logic_vector is
+        variable result : std_logic_vector(2 downto 0);
+    begin
+        result := plru;
+        if ASSOCIATIVITY = 4 then
+            if way < 2 then
+                result(0) := '1';
+                if way = 0 then result(1) := '1'; else result(1) := '0'; end if;
+            else
+                result(0) := '0';
+                if way = 2 then result(2) := '1'; else result(2) := '0'; end if;
+            end if;
+        elsif ASSOCIATIVITY = 2 then
+            if way = 0 then result(0) := '1'; else result(0) := '0'; end if;
+        end if;
+        return result;
+    end function;
+
+    -- Replacement way of the set at line base: first invalid unlocked way
+    -- (a PRELOAD line is locked while it fills), else the
+    -- pseudo-LRU way, else the first unlocked way (SPLIT_ID: inside the
+    -- half of the ways of the access type); a locked way only when all are
+    function pick_victim(valid, locked : std_logic_vector; base : integer;
+                         plru : std_logic_vector(2 downto 0); fetch : std_logic) return integer is
+        variable first  : integer range 0 to 3;
+        variable last   : integer range 0 to 3;
+        variable result : integer range 0 to 3;
+    begin
+        first := 0;
+        last  := ASSOCIATIVITY-1;
+        if SPLIT_ID = true then
+            if fetch = '1' then
+                last  := ASSOCIATIVITY/2 - 1;
+            else
+                first := ASSOCIATIVITY/2;
+            end if;
+        end if;
+        result := first;
+        if ASSOCIATIVITY = 4 then
+            if (SPLIT_ID = false and plru(0) = '0') or (SPLIT_ID = true and fetch = '1') then
+                if plru(1) = '0' then result := 0; else result := 1; end if;
+            else
+                if plru(2) = '0' then result := 2; else result := 3; end if;
+            end if;
+        elsif ASSOCIATIVITY = 2 and SPLIT_ID = false then
+            if plru(0) = '0' then result := 0; else result := 1; end if;
+        end if;
+        if locked(base + result) = '1' then
+            for way in last downto first loop
+                if locked(base + way) = '0' then
+                    result := way;
+                end if;
+            end loop;
+        end if;
+        for way in ASSOCIATIVITY-1 downto 0 loop
+            if way >= first and way <= last and valid(base + way) = '0' and
+               locked(base + way) = '0' then
+                result := way;
+            end if;
+        end loop;
+        return result;
+    end function;
+
     -- Saved request
     signal saved_we_n       : std_logic;
+    signal saved_sync       : std_logic;
     signal saved_addr       : std_logic_vector(ADDR_BITS-1 downto 0);
     signal saved_din        : std_logic_vector(7 downto 0);
     signal saved_tag        : std_logic_vector(TAG_BITS-1 downto 0);
     signal saved_index      : unsigned(INDEX_BITS-1 downto 0);
     signal saved_offset     : unsigned(OFFSET_BITS-1 downto 0);
-    signal saved_cache_addr : integer range 0 to CACHE_SIZE_BYTES-1;
+    signal saved_line       : integer range 0 to NUM_LINES-1;   -- line (set * ways + way) of the access
+    signal saved_cache_word : integer range 0 to CACHE_WORDS-1;
+    signal saved_word       : integer range 0 to LINE_WORDS-1;  -- word in line wanted by the CPU
     
-    -- Line fetch
-    signal byte_counter     : unsigned(OFFSET_BITS-1 downto 0);
-    signal line_base_addr   : std_logic_vector(ADDR_BITS-1 downto 0);
-    signal fetch_cache_addr : integer range 0 to CACHE_SIZE_BYTES-1;
-    signal current_fetch_addr : std_logic_vector(ADDR_BITS-1 downto 0);
+    -- Line fill (critical word first)
+    signal fill_active      : std_logic := '0';
+    signal fill_tag         : std_logic_vector(TAG_BITS-1 downto 0);
+    signal fill_index       : unsigned(INDEX_BITS-1 downto 0);      -- set
+    signal fill_line        : integer range 0 to NUM_LINES-1;       -- line being filled
+    signal fill_line_addr   : std_logic_vector(ADDR_BITS-1 downto OFFSET_BITS);
+    signal burst_base       : integer range 0 to LINE_WORDS-1;     -- first word of current request
+    signal beat_count       : integer range 0 to FILL_BURST-1;     -- word within current burst
+    signal word_counter     : unsigned(OFFSET_BITS-2 downto 0);    -- words stored so far
+    signal word_present     : std_logic_vector(LINE_WORDS-1 downto 0) := (others => '1');
+    signal fill_word        : integer range 0 to LINE_WORDS-1;     -- word landing on this beat
+    signal fill_beat        : std_logic;
+
+    -- Next-line prefetch
+    signal pf_pending       : std_logic := '0';
+    signal pf_sync          : std_logic := '0';
+    signal pf_line_addr     : std_logic_vector(ADDR_BITS-1 downto OFFSET_BITS) := (others => '0');
+    signal pf_tag           : std_logic_vector(TAG_BITS-1 downto 0);
+    signal pf_index         : unsigned(INDEX_BITS-1 downto 0);
+    signal pf_present       : std_logic;                            -- line already cached
+    signal pf_present_line  : integer range 0 to NUM_LINES-1;       -- where (PRELOAD)
+    signal pf_victim_line   : integer range 0 to NUM_LINES-1;
+    signal pf_bits          : std_logic_vector(NUM_LINES-1 downto 0) := (others => '0');  -- prefetched, not used yet
+
+    -- Maintenance (see 14.)
+    constant OP_INVALIDATE_ALL  : std_logic_vector(2 downto 0) := "000";
+    constant OP_INVALIDATE_LINE : std_logic_vector(2 downto 0) := "001";
+    constant OP_LOCK            : std_logic_vector(2 downto 0) := "010";
+    constant OP_UNLOCK_ALL      : std_logic_vector(2 downto 0) := "011";
+    constant OP_PRELOAD         : std_logic_vector(2 downto 0) := "100";
+    signal cache_on         : std_logic := '1';   -- cache_en registered
+    signal cache_on_prev    : std_logic := '1';
+    signal lock_bits        : std_logic_vector(NUM_LINES-1 downto 0) := (others => '0');
+    signal maint_pending    : std_logic := '0';
+    signal maint_active     : std_logic := '0';
+    signal maint_cmd        : std_logic_vector(2 downto 0);
+    signal maint_lo_line    : std_logic_vector(ADDR_BITS-1 downto OFFSET_BITS);
+    signal maint_hi_line    : std_logic_vector(ADDR_BITS-1 downto OFFSET_BITS);
+    signal maint_line       : integer range 0 to NUM_LINES-1;
+    signal maint_last       : integer range 0 to NUM_LINES-1;
+    signal maint_addr       : std_logic_vector(ADDR_BITS-1 downto OFFSET_BITS);  -- address of maint_line
+
+    -- Line write back (dirty eviction / flush)
+    signal evicting         : std_logic;
+    signal evict_tag        : std_logic_vector(TAG_BITS-1 downto 0);
+    signal evict_line       : integer range 0 to NUM_LINES-1;
+    signal evict_word       : integer range 0 to LINE_WORDS-1;
+    signal evict_data       : std_logic_vector(15 downto 0);
+    signal cache_rd_word    : integer range 0 to CACHE_WORDS-1;   -- shared cache read address
+
+    -- Cache write port (fill beat first, then the CPU byte)
+    signal cpu_wr_pending   : std_logic := '0';                   -- CPU byte waiting for the port
+    signal cpu_wr_word      : integer range 0 to CACHE_WORDS-1;
+    signal cpu_wr_data      : std_logic_vector(7 downto 0);
+    signal cpu_wr_odd       : std_logic;                          -- byte lane (address bit 0)
+    signal cache_wr_word    : integer range 0 to CACHE_WORDS-1;   -- shared cache write address
+    signal cache_wr_data    : std_logic_vector(15 downto 0);
+    signal cache_wr_en      : std_logic_vector(1 downto 0);       -- odd, even
+
+    -- Posted write buffer (FIFO, pointers run over 2 x depth to tell full from empty)
+    type wb_addr_type is array (0 to WRITE_BUFFER_DEPTH-1) of std_logic_vector(ADDR_BITS-2 downto 0);
+    type wb_data_type is array (0 to WRITE_BUFFER_DEPTH-1) of std_logic_vector(15 downto 0);
+    type wb_be_type   is array (0 to WRITE_BUFFER_DEPTH-1) of std_logic_vector(1 downto 0);
+    signal wb_addr          : wb_addr_type;
+    signal wb_data          : wb_data_type;
+    signal wb_be            : wb_be_type;
+    signal wb_head          : integer range 0 to 2*WRITE_BUFFER_DEPTH-1 := 0;  -- oldest entry
+    signal wb_tail          : integer range 0 to 2*WRITE_BUFFER_DEPTH-1 := 0;  -- next free entry
+    signal wb_count         : integer range 0 to WRITE_BUFFER_DEPTH;
+    signal wb_fwd_hit       : std_logic;
+    signal wb_fwd_data      : std_logic_vector(7 downto 0);
+
+    -- Flush
+    signal flush_prev       : std_logic := '0';
+    signal flush_pending    : std_logic := '0';
+    signal flush_active     : std_logic := '0';
+    signal flush_line       : integer range 0 to NUM_LINES-1;
     
     -- Cache hit detection
     signal is_hit           : std_logic;
-    signal is_valid         : std_logic;
+    signal is_fill_line     : std_logic;
+    signal hit_way          : integer range 0 to 3;
+    signal hit_line         : integer range 0 to NUM_LINES-1;
+    signal hit_cache_word   : integer range 0 to CACHE_WORDS-1;
+    signal victim_way       : integer range 0 to 3;
+    signal victim_line      : integer range 0 to NUM_LINES-1;
     
     -- Statistics - 256-access sliding window
     signal access_counter   : unsigned(7 downto 0) := (others => '0');
@@ -227,29 +687,211 @@ architecture rtl of sram_sdram_bridge is
 	
 begin
 
+    -- Geometry checks
+    assert 2 ** OFFSET_BITS = LINE_SIZE_BYTES and LINE_SIZE_BYTES >= 4 and LINE_SIZE_BYTES <= 64
+        report "sram_sdram_bridge: LINE_SIZE_BYTES must be a power of two from 4 to 64"
+        severity failure;
+    assert ASSOCIATIVITY = 1 or ASSOCIATIVITY = 2 or ASSOCIATIVITY = 4
+        report "sram_sdram_bridge: ASSOCIATIVITY must be 1, 2 or 4"
+        severity failure;
+    assert 2 ** INDEX_BITS = NUM_SETS and NUM_SETS * ASSOCIATIVITY * LINE_SIZE_BYTES = CACHE_SIZE_BYTES
+        report "sram_sdram_bridge: CACHE_SIZE_BYTES must be a power of two of at least ASSOCIATIVITY lines"
+        severity failure;
+    assert SPLIT_ID = false or ASSOCIATIVITY >= 2
+        report "sram_sdram_bridge: SPLIT_ID needs ASSOCIATIVITY = 2 or 4"
+        severity failure;
+    assert PREFETCH = false or (PREFETCH_BYTES >= 1 and PREFETCH_BYTES <= LINE_SIZE_BYTES)
+        report "sram_sdram_bridge: PREFETCH_BYTES must be from 1 to LINE_SIZE_BYTES"
+        severity failure;
+    assert FAST_BYTES = 0 or (2 ** log2(FAST_BYTES) = FAST_BYTES and FAST_BYTES < 2 ** ADDR_BITS)
+        report "sram_sdram_bridge: FAST_BYTES must be 0 or a power of two below 2**ADDR_BITS"
+        severity failure;
+    assert TAG_BITS >= 1
+        report "sram_sdram_bridge: CACHE_SIZE_BYTES must be smaller than the 2**ADDR_BITS window"
+        severity failure;
+
     -- Output statistics
     cache_hitp <= hit_percent;
     
-    -- Hit detection
-    is_valid <= valid_bits(to_integer(saved_index));
-    is_hit   <= '1' when (is_valid = '1' and 
-                          tag_array(to_integer(saved_index)) = saved_tag)
-                    else '0';
+    -- Hit detection: compare the tags of all ways of the set
+    hit_detect : process(valid_bits, tag_array, saved_index, saved_tag, cache_on)
+    begin
+        is_hit  <= '0';
+        hit_way <= 0;
+        for way in 0 to ASSOCIATIVITY-1 loop
+            if cache_on = '1' and valid_bits(to_integer(saved_index) * ASSOCIATIVITY + way) = '1' and
+               tag_array(to_integer(saved_index) * ASSOCIATIVITY + way) = saved_tag then
+                is_hit  <= '1';
+                hit_way <= way;
+            end if;
+        end loop;
+    end process;
+
+    -- Replacement way of the set of the access
+    victim_way <= pick_victim(valid_bits, lock_bits, to_integer(saved_index) * ASSOCIATIVITY,
+                              plru_bits(to_integer(saved_index)), saved_sync);
+
+    -- Prefetch lookup: is line + 1 cached, else where does it go
+    pf_tag   <= pf_line_addr(ADDR_BITS-1 downto INDEX_BITS+OFFSET_BITS);
+    pf_index <= unsigned(pf_line_addr(INDEX_BITS+OFFSET_BITS-1 downto OFFSET_BITS));
+
+    pf_detect : process(valid_bits, tag_array, pf_index, pf_tag)
+    begin
+        pf_present      <= '0';
+        pf_present_line <= to_integer(pf_index) * ASSOCIATIVITY;
+        for way in 0 to ASSOCIATIVITY-1 loop
+            if valid_bits(to_integer(pf_index) * ASSOCIATIVITY + way) = '1' and
+               tag_array(to_integer(pf_index) * ASSOCIATIVITY + way) = pf_tag then
+                pf_present      <= '1';
+                pf_present_line <= to_integer(pf_index) * ASSOCIATIVITY + way;
+            end if;
+        end loop;
+    end process;
+
+    pf_victim_line <= to_integer(pf_index) * ASSOCIATIVITY +
+                      pick_victim(valid_bits, lock_bits, to_integer(pf_index) * ASSOCIATIVITY,
+                                  plru_bits(to_integer(pf_index)), pf_sync);
+
+    hit_line       <= to_integer(saved_index) * ASSOCIATIVITY + hit_way;
+    victim_line    <= to_integer(saved_index) * ASSOCIATIVITY + victim_way;
+    hit_cache_word <= hit_line * LINE_WORDS + saved_word;
     
-    -- Line base address (zero out offset bits)
-    line_base_addr <= saved_addr(ADDR_BITS-1 downto OFFSET_BITS) & (OFFSET_BITS-1 downto 0 => '0');
+    -- Access falls in the line being filled right now
+    is_fill_line <= '1' when (fill_active = '1' and cache_on = '1' and
+                              fill_index = saved_index and
+                              fill_tag = saved_tag)
+                        else '0';
+
+    saved_word <= to_integer(saved_offset(OFFSET_BITS-1 downto 1));
+    saved_cache_word <= saved_line * LINE_WORDS + saved_word;
+
+    -- The SDRAM wraps a burst inside its BL aligned block, so a burst started
+    -- on the critical word returns e.g. 5,6,7,4 for BL=4 and word 5
+    fill_word <= (burst_base / FILL_BURST) * FILL_BURST +
+                 ((burst_base + beat_count) mod FILL_BURST);
+
+    -- One word of the line is on sdram_dout during this clock
+    fill_beat <= '1' when fill_state = MISS_FETCHING and
+                          ((FILL_BURST > 1 and sdram_dvalid = '1') or
+                           (FILL_BURST = 1 and sdram_ack = '1' and sdram_ack_prev = '0'))
+                     else '0';
 
-    debug <= "000" when state = IDLE            and session_active = '0' else
+    evicting <= '1' when fill_state = EVICT_READ or fill_state = EVICT_START or
+                         fill_state = EVICT_WRITING
+                    else '0';
+
+    -- One read port on the cache banks: the write back owns it while
+    -- evicting (the CPU cannot be in CACHE_HIT then)
+    cache_rd_word <= evict_line * LINE_WORDS + evict_word when evicting = '1' else
+                     saved_cache_word;
+
+    -- One write port: a fill beat owns it, the CPU byte waits for a clock
+    -- without one (a burst holds it for at most FILL_BURST clocks)
+    cache_wr_word <= fill_line * LINE_WORDS + fill_word when fill_beat = '1' else
+                     cpu_wr_word;
+    cache_wr_data <= sdram_dout when fill_beat = '1' else
+                     cpu_wr_data & cpu_wr_data;
+    cache_wr_en   <= "11" when fill_beat = '1' else
+                     "00" when cpu_wr_pending = '0' else
+                     "10" when cpu_wr_odd = '1' else
+                     "01";
+
+    cache_write : process(sdram_clk)
+    begin
+        if rising_edge(sdram_clk) then
+            if cache_wr_en(0) = '1' then
+                cache_even(cache_wr_word) <= cache_wr_data(7 downto 0);
+            end if;
+            if cache_wr_en(1) = '1' then
+                cache_odd(cache_wr_word)  <= cache_wr_data(15 downto 8);
+            end if;
+        end if;
+    end process;
+
+    flush_busy <= flush_pending or flush_active;
+    maint_busy <= maint_pending or maint_active;
+
+    maint_addr <= tag_array(maint_line) & std_logic_vector(to_unsigned(maint_line / ASSOCIATIVITY, INDEX_BITS));
+
+    -- Quiet time for the SDRAM: owed refreshes may run
+    refresh_ok <= '1' when state = IDLE and session_active = '0' and
+                           fill_state = FILL_IDLE and wb_count = 0
+                      else '0';
+
+    quiet_cycles <= (others => '1') when PHASE_PREDICT = false or until_rise + MISS_LATENCY > 255 else
+                    to_unsigned(until_rise + MISS_LATENCY, 8);
+
+    -- Phase prediction (see 11.)
+    phase_predict : process(sdram_clk)
+    begin
+        if rising_edge(sdram_clk) then
+            phase_meta <= cpu_phase;
+            phase_sync <= phase_meta;
+            phase_prev <= phase_sync;
+
+            if PHASE_PREDICT = true then
+                if phase_sync /= phase_prev then
+                    -- 1 clock margin: E and cpu_phase have separate synchronizers
+                    case phase_sync is
+                        when "00"   => until_rise <= 2 * quarter_len - 1;
+                        when "01"   => until_rise <= quarter_len - 1;
+                        when "11"   => until_rise <= 4 * quarter_len - 1;
+                        when others => until_rise <= 3 * quarter_len - 1;
+                    end case;
+                    if phase_prev = "01" then
+                        quarter_len <= quarter_count;
+                    end if;
+                    quarter_count <= 1;
+                else
+                    if until_rise > 0 then
+                        until_rise <= until_rise - 1;
+                    end if;
+                    if quarter_count < 63 then
+                        quarter_count <= quarter_count + 1;
+                    end if;
+                end if;
+            end if;
+        end if;
+    end process;
+
+    -- Look-ahead for the SDRAM controller (bank preparation only)
+    sdram_next_req  <= '1' when wb_count >= 2 or (evicting = '1' and flush_active = '0') else '0';
+    sdram_next_addr <= wb_addr((wb_head + 1) mod WRITE_BUFFER_DEPTH) when wb_count >= 2 else
+                       fill_line_addr & std_logic_vector(to_unsigned(burst_base, OFFSET_BITS-1));
+
+    wb_count <= (wb_tail - wb_head) mod (2*WRITE_BUFFER_DEPTH);
+
+    -- Write buffer forwarding: look for the CPU byte in the pending writes,
+    -- oldest to youngest so the last write to the byte wins
+    wb_lookup : process(wb_addr, wb_data, wb_be, wb_head, wb_count, saved_addr)
+        variable slot : integer range 0 to WRITE_BUFFER_DEPTH-1;
+    begin
+        wb_fwd_hit  <= '0';
+        wb_fwd_data <= (others => '0');
+        for i in 0 to WRITE_BUFFER_DEPTH-1 loop
+            slot := (wb_head + i) mod WRITE_BUFFER_DEPTH;
+            if i < wb_count and wb_addr(slot) = saved_addr(ADDR_BITS-1 downto 1) then
+                if saved_addr(0) = '0' and wb_be(slot)(0) = '1' then
+                    wb_fwd_hit  <= '1';
+                    wb_fwd_data <= wb_data(slot)(7 downto 0);
+                elsif saved_addr(0) = '1' and wb_be(slot)(1) = '1' then
+                    wb_fwd_hit  <= '1';
+                    wb_fwd_data <= wb_data(slot)(15 downto 8);
+                end if;
+            end if;
+        end loop;
+    end process;
+
+    debug <= "000" when state = IDLE            and session_active = '0' and fill_active = '0' else
              "001" when state = CACHE_CHECK     else
              "010" when state = CACHE_HIT       else
-             "011" when state = MISS_FETCH_START else
-             "100" when state = MISS_FETCHING   else
+             "011" when state = FILL_WAIT       else
+             "100" when state = IDLE            and fill_active = '1' else
              "101" when state = WAIT_SDRAM_ACK  and saved_we_n = '1' else
              "110" when state = WAIT_SDRAM_ACK  and saved_we_n = '0' else
              "111";
 
     process(sdram_clk)
-        variable current_fetch_addr : std_logic_vector(ADDR_BITS-1 downto 0);
     begin
         if rising_edge(sdram_clk) then
             -- Two-stage synchronizer
@@ -260,40 +902,95 @@ begin
             
             if reset_n = '0' then
                 state           <= IDLE;
+                fill_state      <= FILL_IDLE;
+                fill_active     <= '0';
+                word_present    <= (others => '1');
+                dirty_bits      <= (others => '0');
+                flush_prev      <= '0';
+                flush_pending   <= '0';
+                flush_active    <= '0';
+                wb_head         <= 0;
+                wb_tail         <= 0;
                 mrdy            <= '1';
                 sdram_req       <= '0';
                 sdram_wr_n      <= '0';
+                sdram_burst     <= '0';
                 session_active  <= '0';
                 valid_bits      <= (others => '0');
+                plru_bits       <= (others => (others => '0'));
                 access_counter  <= (others => '0');
                 hit_counter     <= (others => '0');
                 hit_percent     <= (others => '0');
-                byte_counter    <= (others => '0');
+                ev_hit          <= '0';
+                ev_miss         <= '0';
+                ev_write        <= '0';
+                ev_ihit         <= '0';
+                ev_imiss        <= '0';
+                ev_prefetch     <= '0';
+                ev_pf_hit       <= '0';
+                pf_pending      <= '0';
+                pf_bits         <= (others => '0');
+                lock_bits       <= (others => '0');
+                maint_pending   <= '0';
+                maint_active    <= '0';
+                maint_full      <= '0';
+                cpu_wr_pending  <= '0';
+                cache_on        <= '1';
+                cache_on_prev   <= '1';
+                word_counter    <= (others => '0');
                 if GENERATE_REFRESH = true then
                     refresh_req     <= '0';
                     refresh_counter <= 0;
-                    refresh_pending <= '0';
                 end if;
             else
                 -- Refresh counter logic
                 if GENERATE_REFRESH = true then
+                    -- One pulse per interval, the controller counts the debt
                     if refresh_counter >= REFRESH_INTERVAL then
                         refresh_counter <= 0;
-                        refresh_pending <= '1';
+                        refresh_req     <= '1';
                     else
                         refresh_counter <= refresh_counter + 1;
-                    end if;
-                    
-                    if E_sync = '0' and refresh_pending = '1' and state = IDLE and session_active = '0' then
-                        refresh_req <= '1';
-                        refresh_pending <= '0';
-                    else
-                        refresh_req <= '0';
+                        refresh_req     <= '0';
                     end if;            
                 else 
                     refresh_req <= '0';
                 end if;
                 
+                -- CPU byte written by cache_write on a clock without a fill beat
+                if cpu_wr_pending = '1' and fill_beat = '0' then
+                    cpu_wr_pending <= '0';
+                end if;
+
+                -- Event pulses (set in CACHE_CHECK)
+                ev_hit   <= '0';
+                ev_miss  <= '0';
+                ev_write <= '0';
+                ev_ihit  <= '0';
+                ev_imiss <= '0';
+                ev_prefetch <= '0';
+                ev_pf_hit   <= '0';
+
+                -- Flush request (rising edge)
+                flush_prev <= flush;
+                if USE_CACHE = true and flush = '1' and flush_prev = '0' then
+                    flush_pending <= '1';
+                end if;
+
+                -- Maintenance request, cache enabled again: invalidate all
+                cache_on      <= cache_en;
+                cache_on_prev <= cache_on;
+                if USE_CACHE = true and cache_on = '1' and cache_on_prev = '0' then
+                    maint_pending <= '1';
+                    maint_cmd     <= OP_INVALIDATE_ALL;
+                elsif USE_CACHE = true and maint_req = '1' then
+                    maint_pending <= '1';
+                    maint_cmd     <= maint_op;
+                    maint_lo_line <= maint_lo(ADDR_BITS-1 downto OFFSET_BITS);
+                    maint_hi_line <= maint_hi(ADDR_BITS-1 downto OFFSET_BITS);
+                    maint_full    <= '0';
+                end if;
+
                 case state is
                     -- ==========================================
                     -- IDLE - Wait for CPU request
@@ -303,13 +1000,18 @@ begin
                     --   1. Captures CPU request (address, data, read/write)
                     --   2. Immediately pulls MRDY low to block CPU
                     --   3. Parses address into TAG, INDEX, OFFSET for cache lookup
-                    --   4. Routes to CACHE_CHECK if cache enabled, or direct to SDRAM if bypassed
+                    --   4. Routes to CACHE_CHECK if cache enabled, or direct to SDRAM if bypassed,
+                    --      or to FAST_HIT below FAST_BYTES
                     -- All address calculations done HERE to prevent metastability issues
                     -- if sram_addr changes during multi-cycle operations.                    
+                    -- A line fill, a flush or a write buffer drain may still be running:
+                    -- sdram_req then belongs to the fill engine and is left alone.
                     
                     when IDLE =>
                         mrdy <= '1';
-                        sdram_req <= '0';
+                        if fill_state = FILL_IDLE then
+                            sdram_req <= '0';
+                        end if;
                         
                         if (session_active = '1') or (sram_ce_n = '0' and E_sync = '1' and E_sync_prev = '0') then
                             session_active <= '1';
@@ -317,15 +1019,19 @@ begin
                             
                             -- Save request
                             saved_we_n   <= sram_we_n;
+                            saved_sync   <= sram_sync;
                             saved_addr   <= sram_addr;
                             saved_din    <= sram_din;
                             
-                            if USE_CACHE = true then
+                            if FAST_BYTES > 0 and unsigned(sram_addr) < FAST_BYTES then
+                                -- Zero page / stack: on-chip, always hits
+                                fast_addr <= to_integer(unsigned(sram_addr)) mod FAST_SIZE;
+                                state <= FAST_HIT;
+                            elsif USE_CACHE = true then
                                 -- Parse address
                                 saved_tag    <= sram_addr(ADDR_BITS-1 downto INDEX_BITS+OFFSET_BITS);
                                 saved_index  <= unsigned(sram_addr(INDEX_BITS+OFFSET_BITS-1 downto OFFSET_BITS));
                                 saved_offset <= unsigned(sram_addr(OFFSET_BITS-1 downto 0));
-                                saved_cache_addr <= to_integer(unsigned(sram_addr(INDEX_BITS+OFFSET_BITS-1 downto 0)));
                                 state <= CACHE_CHECK;
                             else
                                 -- Bypass cache
@@ -351,64 +1057,213 @@ begin
                     -- ==========================================
                     -- CACHE_CHECK - Determine cache hit or miss
                     -- ==========================================
-                    -- Compares saved_tag against tag_array[saved_index] to detect hit/miss.
+                    -- Compares saved_tag against the tags of every way of set
+                    -- saved_index to detect hit/miss. Hits and allocations make
+                    -- the way most recently used in the pseudo-LRU tree.
                     -- Increments access counter for statistics.
                     --
                     -- READ path:
                     --   - HIT: Go to CACHE_HIT to return data instantly
-                    --   - MISS: Go to MISS_FETCH_START to load entire 16-byte line
+                    --   - Line being filled: go to FILL_WAIT, the byte is served
+                    --     as soon as its word has landed
+                    --   - MISS: start a line fill at the critical word, go to FILL_WAIT
                     --
                     -- WRITE path (write-through):
                     --   - HIT: Update cache line, then write through to SDRAM
                     --   - MISS: NO-ALLOCATE - just write through to SDRAM
                     --           (avoids creating cache lines with partial garbage data)
                     --   - Both cases go to WAIT_SDRAM_ACK
+                    --   - With USE_WRITE_BUFFER the SDRAM write is posted to the
+                    --     write buffer instead and MRDY released (waits if full)
+                    --
+                    -- WRITE path (write-back):
+                    --   - HIT: Update cache line, set dirty bit, release MRDY
+                    --   - MISS: allocate - same line fill as a read miss, the
+                    --           byte is merged in FILL_WAIT
+                    --
+                    -- Any miss whose victim line is valid and dirty writes the
+                    -- victim back first (EVICT_* states of the fill engine).
+                    --
+                    -- While a background fill owns the SDRAM port, read misses to
+                    -- another line and all writes wait here (not counted yet).
+                    -- Everything waits during a line write back or a flush.
+                    -- A read miss not forwarded by the write buffer waits for
+                    -- it to drain.
                     --
                     -- Statistics: Every 256 accesses, calculates hit percentage                    
                 
                     when CACHE_CHECK =>
-                        -- Count this access
-                        access_counter <= access_counter + 1;
-                        
-                        if saved_we_n = '1' then
-                            -- READ operation
-                            if is_hit = '1' then
-                                -- Cache hit on read!
-                                hit_counter <= hit_counter + 1;
-                                state <= CACHE_HIT;
+                        if fill_active = '1' and (saved_we_n = '0' or (is_hit = '0' and is_fill_line = '0')) then
+                            -- SDRAM port busy with the previous line fill: wait
+                            null;
+                        elsif evicting = '1' or flush_pending = '1' or flush_active = '1' or
+                              maint_pending = '1' or maint_active = '1' or cpu_wr_pending = '1' then
+                            -- Cache read port busy with a line write back,
+                            -- maintenance queued or running, or the last CPU
+                            -- byte not in the cache yet: wait
+                            null;
+                        elsif USE_WRITE_BUFFER = true and WRITE_BACK = false and
+                              ((saved_we_n = '0' and wb_count = WRITE_BUFFER_DEPTH) or
+                               (saved_we_n = '1' and is_hit = '0' and is_fill_line = '0' and
+                                wb_fwd_hit = '0' and wb_count /= 0)) then
+                            -- Write buffer full, or posted writes must reach SDRAM
+                            -- before the line is fetched: wait
+                            null;
+                        else
+                            -- Count this access
+                            access_counter <= access_counter + 1;
+                            ev_write       <= not saved_we_n;
+                            if is_hit = '1' or is_fill_line = '1' or
+                               (saved_we_n = '1' and wb_fwd_hit = '1') then
+                                ev_hit   <= '1';
+                                ev_ihit  <= saved_sync;
                             else
-                                -- Cache miss - fetch entire line from SDRAM
-                                byte_counter <= (others => '0');
-                                state <= MISS_FETCH_START;
+                                ev_miss  <= '1';
+                                ev_imiss <= saved_sync;
                             end if;
-                        else
-                            -- WRITE operation - write-through
-                            if is_hit = '1' then
-                                hit_counter <= hit_counter + 1;
-                                -- Update cache
-                                cache_data(saved_cache_addr) <= saved_din;
+
+                            -- First use of a prefetched line
+                            if PREFETCH = true then
+                                if is_hit = '1' and pf_bits(hit_line) = '1' then
+                                    ev_pf_hit <= '1';
+                                    pf_bits(hit_line) <= '0';
+                                elsif is_hit = '0' and is_fill_line = '1' and pf_bits(fill_line) = '1' then
+                                    ev_pf_hit <= '1';
+                                    pf_bits(fill_line) <= '0';
+                                end if;
                             end if;
-                            -- NO-ALLOCATE on write miss - just write through to SDRAM
-                            
-                            -- Always write through to SDRAM
-                            if sdram_ready = '1' then
-                                sdram_addr <= saved_addr(ADDR_BITS-1 downto 1);
-                                if saved_addr(0) = '0' then
-                                    sdram_byte_en <= "01";
+
+                            -- Near the end of the line: arm the prefetch of the next one
+                            if PREFETCH = true and cache_on = '1' and (saved_we_n = '1' or WRITE_BACK = true) and
+                               to_integer(saved_offset) >= LINE_SIZE_BYTES - PREFETCH_BYTES then
+                                pf_pending   <= '1';
+                                pf_sync      <= saved_sync;
+                                pf_line_addr <= std_logic_vector(unsigned(saved_addr(ADDR_BITS-1 downto OFFSET_BITS)) + 1);
+                            end if;
+                        
+                            if saved_we_n = '1' or WRITE_BACK = true then
+                                -- READ operation (or WRITE with write-back)
+                                if is_hit = '1' then
+                                    hit_counter <= hit_counter + 1;
+                                    saved_line  <= hit_line;
+                                    plru_bits(to_integer(saved_index)) <= plru_touch(plru_bits(to_integer(saved_index)), hit_way);
+                                    if saved_we_n = '1' then
+                                        -- Cache hit on read!
+                                        state <= CACHE_HIT;
+                                    else
+                                        -- Write hit: cache only, SDRAM updated on eviction
+                                        cpu_wr_pending <= '1';
+                                        cpu_wr_word    <= hit_cache_word;
+                                        cpu_wr_data    <= saved_din;
+                                        cpu_wr_odd     <= saved_offset(0);
+                                        dirty_bits(hit_line) <= '1';
+                                        session_active <= '0';
+                                        mrdy <= '1';
+                                        state <= IDLE;
+                                    end if;
+                                elsif is_fill_line = '1' then
+                                    -- Line already on its way from SDRAM
+                                    hit_counter <= hit_counter + 1;
+                                    saved_line  <= fill_line;
+                                    state <= FILL_WAIT;
+                                elsif saved_we_n = '1' and wb_fwd_hit = '1' then
+                                    -- Byte still in the write buffer: forward it
+                                    hit_counter <= hit_counter + 1;
+                                    sram_dout <= wb_fwd_data;
+                                    session_active <= '0';
+                                    mrdy <= '1';
+                                    state <= IDLE;
+                                elsif cache_on = '0' or lock_bits(victim_line) = '1' then
+                                    -- Cache disabled, or every way locked: one byte
+                                    -- straight from / to SDRAM, nothing allocated
+                                    if sdram_ready = '1' then
+                                        sdram_addr <= saved_addr(ADDR_BITS-1 downto 1);
+                                        if saved_addr(0) = '0' then
+                                            sdram_byte_en <= "01";
+                                        else
+                                            sdram_byte_en <= "10";
+                                        end if;
+                                        sdram_wr_n <= saved_we_n;
+                                        sdram_din  <= saved_din & saved_din;
+                                        sdram_req  <= '1';
+                                        state      <= WAIT_SDRAM_ACK;
+                                    end if;
                                 else
-                                    sdram_byte_en <= "10";
+                                    -- Cache miss - fetch entire line, critical word first,
+                                    -- into the victim way of the set
+                                    valid_bits(victim_line) <= '0';
+                                    dirty_bits(victim_line) <= '0';
+                                    pf_bits(victim_line)    <= '0';
+                                    lock_bits(victim_line)  <= '0';
+                                    plru_bits(to_integer(saved_index)) <= plru_touch(plru_bits(to_integer(saved_index)), victim_way);
+                                    saved_line     <= victim_line;
+                                    fill_active    <= '1';
+                                    fill_tag       <= saved_tag;
+                                    fill_index     <= saved_index;
+                                    fill_line      <= victim_line;
+                                    fill_line_addr <= saved_addr(ADDR_BITS-1 downto OFFSET_BITS);
+                                    burst_base     <= saved_word;
+                                    beat_count     <= 0;
+                                    word_counter   <= (others => '0');
+                                    word_present   <= (others => '0');
+                                    if WRITE_BACK = true and valid_bits(victim_line) = '1' and
+                                       dirty_bits(victim_line) = '1' then
+                                        -- Victim line is dirty: write it back first
+                                        evict_tag   <= tag_array(victim_line);
+                                        evict_line  <= victim_line;
+                                        evict_word  <= 0;
+                                        fill_state  <= EVICT_READ;
+                                    else
+                                        fill_state  <= MISS_FETCH_START;
+                                    end if;
+                                    state          <= FILL_WAIT;
+                                end if;
+                            else
+                                -- WRITE operation - write-through
+                                if is_hit = '1' then
+                                    hit_counter <= hit_counter + 1;
+                                    plru_bits(to_integer(saved_index)) <= plru_touch(plru_bits(to_integer(saved_index)), hit_way);
+                                    -- Update cache (cache_write, next clock)
+                                    cpu_wr_pending <= '1';
+                                    cpu_wr_word    <= hit_cache_word;
+                                    cpu_wr_data    <= saved_din;
+                                    cpu_wr_odd     <= saved_offset(0);
+                                end if;
+                                -- NO-ALLOCATE on write miss - just write through to SDRAM
+
+                                if USE_WRITE_BUFFER = true then
+                                    -- Post the write (not full, checked above)
+                                    wb_addr(wb_tail mod WRITE_BUFFER_DEPTH) <= saved_addr(ADDR_BITS-1 downto 1);
+                                    wb_data(wb_tail mod WRITE_BUFFER_DEPTH) <= saved_din & saved_din;
+                                    if saved_addr(0) = '0' then
+                                        wb_be(wb_tail mod WRITE_BUFFER_DEPTH) <= "01";
+                                    else
+                                        wb_be(wb_tail mod WRITE_BUFFER_DEPTH) <= "10";
+                                    end if;
+                                    wb_tail <= (wb_tail + 1) mod (2*WRITE_BUFFER_DEPTH);
+                                    session_active <= '0';
+                                    mrdy <= '1';
+                                    state <= IDLE;
+                                -- Always write through to SDRAM
+                                elsif sdram_ready = '1' then
+                                    sdram_addr <= saved_addr(ADDR_BITS-1 downto 1);
+                                    if saved_addr(0) = '0' then
+                                        sdram_byte_en <= "01";
+                                    else
+                                        sdram_byte_en <= "10";
+                                    end if;
+                                    sdram_din  <= saved_din & saved_din;
+                                    sdram_wr_n <= '0';
+                                    sdram_req  <= '1';
+                                    state      <= WAIT_SDRAM_ACK;
                                 end if;
-                                sdram_din  <= saved_din & saved_din;
-                                sdram_wr_n <= '0';
-                                sdram_req  <= '1';
-                                state      <= WAIT_SDRAM_ACK;
                             end if;
-                        end if;
-                        
-                        -- Every 256 accesses, calculate percentage
-                        if access_counter = 255 then
-                            hit_percent <= resize((hit_counter * 25) srl 6, 7);
-                            hit_counter <= (others => '0');
+                            
+                            -- Every 256 accesses, calculate percentage
+                            if access_counter = 255 then
+                                hit_percent <= resize((hit_counter * 25) srl 6, 7);
+                                hit_counter <= (others => '0');
+                            end if;
                         end if;
                     
                     -- ==========================================
@@ -421,92 +1276,70 @@ begin
                     -- This is the fast path - no SDRAM access needed!   
                     
                     when CACHE_HIT =>
-                        sram_dout <= cache_data(saved_cache_addr);
+                        if saved_offset(0) = '0' then
+                            sram_dout <= cache_even(cache_rd_word);
+                        else
+                            sram_dout <= cache_odd(cache_rd_word);
+                        end if;
                         session_active <= '0';
                         mrdy <= '1';
                         state <= IDLE;
                     
                     -- ==========================================
-                    -- MISS_FETCH_START - Begin fetching one byte
+                    -- FAST_HIT - Fast page access
                     -- ==========================================
-                    -- Read miss detected - must fetch entire 16-byte cache line.
-                    -- This state fetches ONE byte at a time from SDRAM.
-                    -- Called 16 times (byte_counter 0..15) to fetch complete line.
-                    --
-                    -- For each byte:
-                    --   1. Calculate SDRAM address (line_base + byte_counter)
-                    --   2. Calculate where to store in cache (saved_index:byte_counter)
-                    --   3. Issue SDRAM read request
-                    --   4. Set byte enable based on odd/even address
-                    --   5. Go to MISS_FETCHING to wait for data
-                    --
-                    -- Note: SDRAM address calculation divides byte_counter by 2
-                    -- because SDRAM is 16-bit (2 bytes per word)                    
+                    -- The byte is read from or written to fast_ram, MRDY is
+                    -- released right away. Nothing else of the bridge is
+                    -- involved, a fill or a flush keeps running meanwhile.
 
-                    when MISS_FETCH_START =>
-                        if sdram_ready = '1' then
-                            -- Calculate address for current byte in line
-                            current_fetch_addr := std_logic_vector(unsigned(line_base_addr) + byte_counter);
-                            
-                            -- Calculate cache address for this byte
-                            fetch_cache_addr <= to_integer(saved_index & byte_counter);
-                            
-                            sdram_req  <= '1';
-                            sdram_wr_n <= '1';  -- Read
-                            sdram_addr <= std_logic_vector(unsigned(line_base_addr(ADDR_BITS-1 downto 1)) + 
-                                                           resize(byte_counter srl 1, ADDR_BITS-1));
-                            if byte_counter(0) = '0' then
-                                sdram_byte_en <= "01";
-                            else
-                                sdram_byte_en <= "10";
-                            end if;
-                            state <= MISS_FETCHING;
+                    when FAST_HIT =>
+                        if saved_we_n = '0' then
+                            fast_ram(fast_addr) <= saved_din;
+                        else
+                            sram_dout <= fast_ram(fast_addr);
                         end if;
+                        session_active <= '0';
+                        mrdy <= '1';
+                        state <= IDLE;
 
                     -- ==========================================
-                    -- MISS_FETCHING - Store byte and continue/complete
+                    -- FILL_WAIT - Wait for the critical word
                     -- ==========================================
-                    -- Waits for SDRAM to acknowledge the read request.
-                    -- When data arrives:
-                    --   1. Extracts correct byte from 16-bit SDRAM word
-                    --      (lower or upper byte based on current_fetch_addr bit 0)
-                    --   2. Stores byte in cache at calculated position
-                    --   3. Checks if line fetch is complete (byte_counter = 15)
-                    --
-                    -- If NOT complete (bytes 0-14):
-                    --   - Increment byte_counter
-                    --   - Loop back to MISS_FETCH_START for next byte
+                    -- The CPU waits here only for the word it asked for, not for
+                    -- the whole line:
+                    --   - Word on sdram_dout this clock: forward the byte
+                    --     straight to sram_dout and release MRDY
+                    --   - Word already stored by an earlier beat: CACHE_HIT
+                    -- The rest of the line keeps streaming into the cache while
+                    -- the CPU runs (hits on other lines are served meanwhile).
                     --
-                    -- If COMPLETE (byte 15):
-                    --   - Update tag_array with saved_tag
-                    --   - Set valid bit for this cache line
-                    --   - Go to CACHE_HIT to return requested byte to CPU
-                    --
-                    -- Total line fetch time: 16 bytes × ~10 clocks = ~160 clocks                        
-                        
-                    when MISS_FETCHING =>
-                        if sdram_ack = '1' and sdram_ack_prev = '0' then
-                            sdram_req <= '0';
-                            
-                            -- Store byte in cache - use saved current_fetch_addr!
-                            if current_fetch_addr(0) = '0' then
-                                cache_data(fetch_cache_addr) <= sdram_dout(7 downto 0);
-                            else
-                                cache_data(fetch_cache_addr) <= sdram_dout(15 downto 8);
+                    -- Write-allocate (write-back): once the word has landed the
+                    -- byte goes to cpu_wr_pending, cache_write merges it on a
+                    -- clock without a fill beat, and the line is made dirty.
+
+                    when FILL_WAIT =>
+                        if saved_we_n = '0' then
+                            if word_present(saved_word) = '1' then
+                                cpu_wr_pending <= '1';
+                                cpu_wr_word    <= saved_cache_word;
+                                cpu_wr_data    <= saved_din;
+                                cpu_wr_odd     <= saved_offset(0);
+                                dirty_bits(saved_line) <= '1';
+                                session_active <= '0';
+                                mrdy <= '1';
+                                state <= IDLE;
                             end if;
-                            
-                            if byte_counter = LINE_SIZE_BYTES - 1 then
-                                -- Entire line fetched!
-                                tag_array(to_integer(saved_index)) <= saved_tag;
-                                valid_bits(to_integer(saved_index)) <= '1';
-                                
-                                -- Return requested byte to CPU
-                                state <= CACHE_HIT;
+                        elsif fill_beat = '1' and fill_word = saved_word then
+                            if saved_offset(0) = '0' then
+                                sram_dout <= sdram_dout(7 downto 0);
                             else
-                                -- Fetch next byte
-                                byte_counter <= byte_counter + 1;
-                                state <= MISS_FETCH_START;
+                                sram_dout <= sdram_dout(15 downto 8);
                             end if;
+                            session_active <= '0';
+                            mrdy <= '1';
+                            state <= IDLE;
+                        elsif word_present(saved_word) = '1' then
+                            state <= CACHE_HIT;
                         end if;
                         
                     -- ==========================================
@@ -549,8 +1382,300 @@ begin
                         end if;
                         
                 end case;
+
+                case fill_state is
+                    -- ==========================================
+                    -- FILL_IDLE - No line fill, flush scanner
+                    -- ==========================================
+                    -- Posted writes drain from here, oldest first.
+                    -- A flush starts once no SDRAM write-through is in flight
+                    -- and the write buffer is empty (CACHE_CHECK holds new
+                    -- accesses while flush_pending is set) and walks all lines,
+                    -- writing back the valid dirty ones.
+                    -- Maintenance operations run next (see 14.), the scans
+                    -- one line per clock, a PRELOAD one line per pass with
+                    -- a line fill for each missing line (see 15.).
+                    -- With nothing else to do and no CPU session, an armed
+                    -- next-line prefetch starts a line fill (PREFETCH).
+
+                    when FILL_IDLE =>
+                        if maint_active = '1' and maint_cmd = OP_PRELOAD then
+                            if pf_present = '1' or lock_bits(pf_victim_line) = '1' then
+                                -- cached: lock it; no unlocked way: skip it
+                                if pf_present = '1' then
+                                    lock_bits(pf_present_line) <= '1';
+                                else
+                                    maint_full <= '1';
+                                end if;
+                                if pf_line_addr = maint_hi_line then
+                                    maint_active <= '0';
+                                else
+                                    pf_line_addr <= std_logic_vector(unsigned(pf_line_addr) + 1);
+                                end if;
+                            else
+                                -- missing: fill it, locked from now on
+                                valid_bits(pf_victim_line) <= '0';
+                                dirty_bits(pf_victim_line) <= '0';
+                                pf_bits(pf_victim_line)    <= '0';
+                                lock_bits(pf_victim_line)  <= '1';
+                                plru_bits(to_integer(pf_index)) <= plru_touch(plru_bits(to_integer(pf_index)),
+                                                                              pf_victim_line mod ASSOCIATIVITY);
+                                fill_active    <= '1';
+                                fill_tag       <= pf_tag;
+                                fill_index     <= pf_index;
+                                fill_line      <= pf_victim_line;
+                                fill_line_addr <= pf_line_addr;
+                                burst_base     <= 0;
+                                beat_count     <= 0;
+                                word_counter   <= (others => '0');
+                                word_present   <= (others => '0');
+                                if WRITE_BACK = true and valid_bits(pf_victim_line) = '1' and
+                                   dirty_bits(pf_victim_line) = '1' then
+                                    evict_tag   <= tag_array(pf_victim_line);
+                                    evict_line  <= pf_victim_line;
+                                    evict_word  <= 0;
+                                    fill_state  <= EVICT_READ;
+                                else
+                                    fill_state  <= MISS_FETCH_START;
+                                end if;
+                            end if;
+                        elsif maint_active = '1' then
+                            if valid_bits(maint_line) = '1' then
+                                if maint_cmd = OP_INVALIDATE_LINE and maint_addr = maint_lo_line then
+                                    valid_bits(maint_line) <= '0';
+                                    dirty_bits(maint_line) <= '0';
+                                    lock_bits(maint_line)  <= '0';
+                                    pf_bits(maint_line)    <= '0';
+                                elsif maint_cmd = OP_LOCK and unsigned(maint_addr) >= unsigned(maint_lo_line) and
+                                      unsigned(maint_addr) <= unsigned(maint_hi_line) then
+                                    lock_bits(maint_line)  <= '1';
+                                end if;
+                            end if;
+                            if maint_line = maint_last then
+                                maint_active <= '0';
+                            else
+                                maint_line <= maint_line + 1;
+                            end if;
+                        elsif flush_active = '1' then
+                            if valid_bits(flush_line) = '1' and
+                               dirty_bits(flush_line) = '1' then
+                                evict_tag   <= tag_array(flush_line);
+                                evict_line  <= flush_line;
+                                evict_word  <= 0;
+                                fill_state  <= EVICT_READ;
+                            elsif flush_line = NUM_LINES - 1 then
+                                flush_active <= '0';
+                            else
+                                flush_line <= flush_line + 1;
+                            end if;
+                        elsif wb_count /= 0 then
+                            if sdram_ready = '1' then
+                                sdram_req     <= '1';
+                                sdram_wr_n    <= '0';  -- Write
+                                sdram_addr    <= wb_addr(wb_head mod WRITE_BUFFER_DEPTH);
+                                sdram_din     <= wb_data(wb_head mod WRITE_BUFFER_DEPTH);
+                                sdram_byte_en <= wb_be(wb_head mod WRITE_BUFFER_DEPTH);
+                                fill_state    <= WB_DRAIN;
+                            end if;
+                        elsif flush_pending = '1' and state /= WAIT_SDRAM_ACK then
+                            flush_pending <= '0';
+                            flush_active  <= '1';
+                            flush_line    <= 0;
+                        elsif maint_pending = '1' and state /= WAIT_SDRAM_ACK then
+                            maint_pending <= '0';
+                            case maint_cmd is
+                                when OP_INVALIDATE_ALL =>
+                                    valid_bits <= (others => '0');
+                                    dirty_bits <= (others => '0');
+                                    lock_bits  <= (others => '0');
+                                    pf_bits    <= (others => '0');
+                                when OP_UNLOCK_ALL =>
+                                    lock_bits  <= (others => '0');
+                                when OP_INVALIDATE_LINE =>
+                                    -- the ways of its set
+                                    maint_line   <= to_integer(unsigned(maint_lo_line(INDEX_BITS+OFFSET_BITS-1 downto OFFSET_BITS))) * ASSOCIATIVITY;
+                                    maint_last   <= to_integer(unsigned(maint_lo_line(INDEX_BITS+OFFSET_BITS-1 downto OFFSET_BITS))) * ASSOCIATIVITY +
+                                                    ASSOCIATIVITY - 1;
+                                    maint_active <= '1';
+                                when OP_LOCK =>
+                                    maint_line   <= 0;
+                                    maint_last   <= NUM_LINES - 1;
+                                    maint_active <= '1';
+                                when OP_PRELOAD =>
+                                    -- the range, through the prefetch lookup
+                                    pf_pending   <= '0';
+                                    pf_sync      <= '1';
+                                    pf_line_addr <= maint_lo_line;
+                                    if unsigned(maint_lo_line) <= unsigned(maint_hi_line) then
+                                        maint_active <= '1';
+                                    end if;
+                                when others =>
+                                    null;
+                            end case;
+                        elsif PREFETCH = true and pf_pending = '1' and
+                              state = IDLE and session_active = '0' then
+                            -- SDRAM idle: fetch the next line (see 13.)
+                            pf_pending <= '0';
+                            if pf_present = '0' and lock_bits(pf_victim_line) = '0' and
+                               (WRITE_BACK = false or valid_bits(pf_victim_line) = '0' or
+                                dirty_bits(pf_victim_line) = '0') then
+                                valid_bits(pf_victim_line) <= '0';
+                                pf_bits(pf_victim_line)    <= '1';
+                                plru_bits(to_integer(pf_index)) <= plru_touch(plru_bits(to_integer(pf_index)),
+                                                                              pf_victim_line mod ASSOCIATIVITY);
+                                fill_active    <= '1';
+                                fill_tag       <= pf_tag;
+                                fill_index     <= pf_index;
+                                fill_line      <= pf_victim_line;
+                                fill_line_addr <= pf_line_addr;
+                                burst_base     <= 0;
+                                beat_count     <= 0;
+                                word_counter   <= (others => '0');
+                                word_present   <= (others => '0');
+                                ev_prefetch    <= '1';
+                                fill_state     <= MISS_FETCH_START;
+                            end if;
+                        end if;
+
+                    -- ==========================================
+                    -- MISS_FETCH_START - Request one word (or one burst)
+                    -- ==========================================
+                    -- The SDRAM is 16-bit wide, so a 16-byte line is fetched as
+                    -- 8 words (LINE_WORDS in general) and every word fills two
+                    -- cache bytes (even + odd bank).
+                    --
+                    -- For each request:
+                    --   1. SDRAM word address = line base + burst_base
+                    --   2. Both bytes enabled (sdram_byte_en = "11")
+                    --   3. Issue SDRAM read request
+                    --   4. Go to MISS_FETCHING to wait for data
+                    --
+                    -- The first request starts on the word the CPU missed on
+                    -- (critical word first):
+                    -- FILL_BURST = 1: words k, k+1, .. 7, 0, .. k-1
+                    -- FILL_BURST > 1: sdram_burst = '1', the SDRAM wraps inside
+                    --                   the BL aligned block (sequential burst
+                    --                   type), the next request starts on the
+                    --                   following block
+
+                    when MISS_FETCH_START =>
+                        if sdram_ready = '1' then
+                            sdram_req     <= '1';
+                            sdram_wr_n    <= '1';  -- Read
+                            sdram_addr    <= fill_line_addr & std_logic_vector(to_unsigned(burst_base, OFFSET_BITS-1));
+                            sdram_byte_en <= "11";  -- whole word
+                            if FILL_BURST > 1 then
+                                sdram_burst <= '1';
+                            end if;
+                            beat_count <= 0;
+                            fill_state <= MISS_FETCHING;
+                        end if;
+
+                    -- ==========================================
+                    -- MISS_FETCHING - Store word and continue/complete
+                    -- ==========================================
+                    -- When a word arrives (fill_beat):
+                    --   1. Low byte goes to cache_even, high byte to cache_odd
+                    --      (same word index, both banks written in one clock)
+                    --   2. word_present marks it so FILL_WAIT can serve it
+                    --   3. After LINE_WORDS words the tag is written and the line is valid
+                    --
+                    -- FILL_BURST = 1: one word per sdram_ack
+                    --   Total line fetch time: 8 words × ~10 clocks = ~80 clocks
+                    --   but the CPU is released after the first one (~10 clocks)
+                    --
+                    -- FILL_BURST > 1: one word per sdram_dvalid pulse
+                    --   - sdram_req is dropped on the first beat (the controller
+                    --     latched the request in its IDLE state)
+                    --   - After FILL_BURST words, back to MISS_FETCH_START for
+                    --     the next burst, or FILL_IDLE once the line is complete
+
+                    when MISS_FETCHING =>
+                        if fill_beat = '1' then
+                            sdram_req   <= '0';
+                            sdram_burst <= '0';
+
+                            -- Both bytes of the word go to the cache (cache_write)
+                            word_present(fill_word) <= '1';
+
+                            if word_counter = LINE_WORDS - 1 then
+                                -- Entire line fetched!
+                                tag_array(fill_line) <= fill_tag;
+                                valid_bits(fill_line) <= '1';
+                                fill_active <= '0';
+                                fill_state  <= FILL_IDLE;
+                            else
+                                word_counter <= word_counter + 1;
+                                if beat_count = FILL_BURST - 1 then
+                                    -- End of this word/burst, request the next one
+                                    burst_base <= ((burst_base / FILL_BURST) * FILL_BURST + FILL_BURST) mod LINE_WORDS;
+                                    fill_state <= MISS_FETCH_START;
+                                else
+                                    beat_count <= beat_count + 1;
+                                end if;
+                            end if;
+                        end if;
+
+                    -- ==========================================
+                    -- EVICT_READ / EVICT_START / EVICT_WRITING - Line write back
+                    -- ==========================================
+                    -- Write-back only. The LINE_WORDS words of line evict_line are read
+                    -- from the cache (one clock) and written to SDRAM one at a
+                    -- time (the controller bursts reads only), whole word
+                    -- (sdram_byte_en = "11").
+                    -- Then the line is clean and the fill goes on with
+                    -- MISS_FETCH_START, or the flush scanner continues.
+
+                    when EVICT_READ =>
+                        if cpu_wr_pending = '0' then
+                            -- the last CPU byte is in the line
+                            evict_data <= cache_odd(cache_rd_word) & cache_even(cache_rd_word);
+                            fill_state <= EVICT_START;
+                        end if;
+
+                    when EVICT_START =>
+                        if sdram_ready = '1' then
+                            sdram_req     <= '1';
+                            sdram_wr_n    <= '0';  -- Write
+                            sdram_addr    <= evict_tag & std_logic_vector(to_unsigned(evict_line / ASSOCIATIVITY, INDEX_BITS)) &
+                                             std_logic_vector(to_unsigned(evict_word, OFFSET_BITS-1));
+                            sdram_din     <= evict_data;
+                            sdram_byte_en <= "11";
+                            fill_state    <= EVICT_WRITING;
+                        end if;
+
+                    when EVICT_WRITING =>
+                        if sdram_ack = '1' and sdram_ack_prev = '0' then
+                            sdram_req  <= '0';
+                            sdram_wr_n <= '1';
+                            if evict_word = LINE_WORDS - 1 then
+                                dirty_bits(evict_line) <= '0';
+                                if flush_active = '1' then
+                                    fill_state <= FILL_IDLE;
+                                else
+                                    fill_state <= MISS_FETCH_START;
+                                end if;
+                            else
+                                evict_word <= evict_word + 1;
+                                fill_state <= EVICT_READ;
+                            end if;
+                        end if;
+
+                    -- ==========================================
+                    -- WB_DRAIN - Oldest posted write in progress
+                    -- ==========================================
+                    -- The entry leaves the write buffer when SDRAM acknowledges.
+
+                    when WB_DRAIN =>
+                        if sdram_ack = '1' and sdram_ack_prev = '0' then
+                            sdram_req  <= '0';
+                            sdram_wr_n <= '1';
+                            wb_head    <= (wb_head + 1) mod (2*WRITE_BUFFER_DEPTH);
+                            fill_state <= FILL_IDLE;
+                        end if;
+                end case;
             end if;
         end if;
     end process;
 
-end rtl;
\ No newline at end of file
+end rtl;
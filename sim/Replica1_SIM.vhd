@@ -0,0 +1,1222 @@
+--------------------------------------------------------------------------------
+-- Replica 1 Full System Simulation Top
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- Replica1_SIM - Theory of Operation
+--------------------------------------------------------------------------------
+-- The DE10-Lite system without the FPGA: Replica1_CORE + RAM + cached
+-- bridge + sdram_controller + sdram_model + a UART terminal, run by GHDL
+-- (see run_tests.sh). Cache and controller changes can be measured on the
+-- real programs of software/tests before going to Quartus.
+--
+-- 1. Clocks (no PLL)
+--    - main_clk   MAIN_CLK_PERIOD (250 ns = 4 MHz, phi2 = 1 MHz)
+--    - serial_clk SERIAL_CLK_PERIOD (1.8432 MHz)
+--    - sdram_clk  SDRAM_MHZ
+--    - reset_n released after 1 us, cpu_reset_n once the BIST is done
+--
+-- 2. Loading a Program
+--    - MON_FILE is typed into wozmon by uart_stub
+--    - FAST_LOAD: the data of MON_FILE is put in the RAM at time 0 and
+--      only the run line (0300R) is typed, minutes of wozmon parsing saved;
+--      data outside the RAM ($E000 SDRAM window, ROM) is not preloaded,
+--      use FAST_LOAD = false for such programs
+--    - RAM_IN_SDRAM: the RAM is SDRAM too, FAST_LOAD preloads the
+--      sdram_model instead (PRELOAD_FILE), once the trainer and the BIST
+--      have written their regions and before the CPU leaves reset; bytes
+--      in the bridge fast page (below FAST_BYTES) are not preloaded
+--    - INPUT_FILE: keyboard lines typed once the program runs
+--    - TRACE_FILE: every CPU cycle of the run as "R E012 3F" / "W ...",
+--      opcode fetches (SYNC) as "F ...", the input of software/cachesim
+--
+-- 3. Measure
+--    - Starts when the run line has been echoed (uart_stub running)
+--    - Stops when the CPU is back in wozmon: address $FF1F (GETLINE,
+--      programs end with JMP $FF1F), or MAX_CPU_CYCLES after reset
+--      (the slow load is included)
+--    - Counted like the pmu: phi2 cycles, main_clk clocks of stretch,
+--      bridge hits / misses / writes / opcode fetch hits / misses /
+--      prefetches / prefetch hits,
+--      controller activates / row hits / refreshes, plus the sdram_model timing violations (whole run)
+--    - ref_stalls: SDRAM clocks where a REF or PRECHARGE ALL is still
+--      running while the CPU clock is stretched (phi2 held by mrdy);
+--      PHASE_PREDICT (cpu_phase of the core to the bridge) keeps it at 0
+--    - One line on the console, read by run_tests.sh:
+--      RESULT status=DONE|TIMEOUT cycles=... stall_clocks=... hits=...
+--    - status=DONE with violations /= 0 is a failure for run_tests.sh,
+--      so is ref_stalls /= 0 while PHASE_PREDICT is on
+--
+-- 4. Memory Map
+--    - Same as the board: RAM $0000-$BFFF (behavioral, phi2), SDRAM
+--      through the cache on the $E000-$EFFF window
+--    - RAM_IN_SDRAM (phase 2): $0000-$BFFF and $E000-$EFFF both through
+--      the cache (bridge ADDR_BITS = 16, SDRAM address = CPU address),
+--      FAST_BYTES = 512 keeps the zero page and the stack in the
+--      bridge fast page
+--    - pmu at $C220 (HAS_PMU): bridge and controller events on
+--      sdram_clk, software/tests/test-pmu.mon checks that they count
+--    - bus trace at $C230 (HAS_TRACE), ext = bridge state (debug),
+--      mrdy and the CPU clock stretch; software/tests/test-trace.mon
+--      triggers on an address and dumps the buffer
+--    - cache_ctrl registers at $C250 (board peripheral window)
+--    - sdram_bist registers at $C240
+--
+-- 5. SDRAM BIST
+--    - sdram_bist sits between the bridge and sdram_trainer
+--    - Before the CPU leaves reset the testbench runs the four tests on
+--      the first 2**BIST_SIZE words through the register window (March C-
+--      last: the region ends zeroed), every test must report DONE, no
+--      error and its exact number of accesses
+--    - RESULT ... bist=PASS|FAIL|OFF bist_errors bist_accesses bist_cycles,
+--      bist /= PASS is a failure for run_tests.sh (BIST_SIZE = 0: OFF)
+--
+-- 6. Read Capture Training
+--    - sdram_trainer sits between sdram_bist and sdram_controller and
+--      drives its rd_delay, trained after the SDRAM initialization,
+--      before the BIST starts
+--    - BOARD_DELAY is the read data delay of sdram_model (PCB / PLL
+--      phase): 4 ns is read at rd_delay 0, 13 ns needs rd_delay 1 at
+--      100 and 120 MHz
+--    - RESULT ... rd_delay=... train_ok=1|0
+--------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use std.textio.all;
+
+entity Replica1_SIM is
+    generic (
+        MON_FILE          : string  := "../software/tests/hello.mon";
+        INPUT_FILE        : string  := "";
+        TRACE_FILE        : string  := "";         -- bus trace of the run for cachesim
+        FAST_LOAD         : boolean := true;       -- preload the RAM, type only the run line
+        MAX_CPU_CYCLES    : integer := 20_000_000; -- timeout from reset, loading included
+        MAIN_CLK_PERIOD   : time    := 250 ns;
+        SERIAL_CLK_PERIOD : time    := 542.535 ns;
+        SDRAM_MHZ         : integer := 120;
+        BAUD_RATE         : integer := 115200;
+        ROW_BITS          : integer := 13;
+        COL_BITS          : integer := 10;
+        CAS_LATENCY       : integer := 2;
+        AUTO_PRECHARGE    : boolean := false;
+        PHASE_PREDICT     : boolean := true;       -- refreshes placed with the CPU clock phase
+        USE_CACHE         : boolean := true;
+        WRITE_BACK        : boolean := false;
+        USE_WRITE_BUFFER  : boolean := true;       -- posted write-through stores
+        CACHE_SIZE_BYTES  : integer := 1024;
+        LINE_SIZE_BYTES   : integer := 16;
+        ASSOCIATIVITY     : integer := 1;
+        SPLIT_ID          : boolean := false;
+        PREFETCH          : boolean := false;
+        PREFETCH_BYTES    : integer := 4;
+        BURST_LENGTH      : integer := 1;
+        RAM_IN_SDRAM      : boolean := false;      -- phase 2: all RAM through the cache
+        FAST_BYTES        : integer := 0;          -- bridge fast page (512: zero page + stack)
+        BIST_SIZE         : integer := 10;         -- sdram_bist region before the CPU starts (log2 words, 0 = none)
+        TRAIN             : boolean := true;       -- sdram_trainer finds the read capture delay
+        BOARD_DELAY       : time    := 4 ns        -- sdram_model read data delay (PCB / clock phase)
+    );
+end Replica1_SIM;
+
+architecture sim of Replica1_SIM is
+
+component Replica1_CORE is
+  generic (
+		CPU_TYPE        : string  :=  "6502";
+ 	    CPU_CORE        : string  :=  "65XX";
+		ROM             : string  :=  "WOZMON65";
+		RAM_SIZE_KB     : integer :=  8;
+	    BAUD_RATE       : integer :=  115200;
+		HAS_ACI         : boolean :=  false;
+		HAS_MSPI        : boolean :=  false;
+		HAS_TIMER       : boolean :=  false;
+		HAS_PMU         : boolean :=  false;
+		HAS_TRACE       : boolean :=  false;
+		RAM_IN_SDRAM    : boolean :=  false
+  );
+  port (
+		main_clk        : in     std_logic;
+		serial_clk      : in     std_logic;
+		reset_n         : in     std_logic;
+		cpu_reset_n     : in     std_logic;
+		bus_phi2        : out    std_logic;
+		bus_address     : out    std_logic_vector(15 downto 0);
+		bus_data        : out    std_logic_vector(7  downto 0);
+		bus_rw          : out    std_logic;
+		bus_sync        : out    std_logic;
+		bus_mrdy        : in     std_logic;
+		bus_phase       : out    std_logic_vector(1  downto 0);
+		bus_stretch     : out    std_logic;
+		ext_ram_cs_n    : out    std_logic;
+		ext_ram_data    : in     std_logic_vector(7  downto 0);
+		ext_tram_cs_n   : out    std_logic;
+		ext_tram_data   : in     std_logic_vector(7  downto 0);
+		ext_io_cs_n     : out    std_logic;
+		ext_io_data     : in     std_logic_vector(7  downto 0) := (others => '1');
+		pmu_ev_clk      : in     std_logic := '0';
+		pmu_events      : in     std_logic_vector(9  downto 0) := (others => '0');
+		trace_ext       : in     std_logic_vector(7  downto 0) := (others => '0');
+		uart_rx         : in     std_logic;
+		uart_tx         : out    std_logic;
+		spi_cs          : out    std_logic;
+		spi_sck         : out    std_logic;
+		spi_mosi        : out    std_logic;
+		spi_miso        : in     std_logic;
+		tape_out        : out    std_logic;
+		tape_in         : in     std_logic
+  );
+end component;
+
+component sram_sdram_bridge is
+    generic (
+        ADDR_BITS        : integer := 24;
+        SDRAM_MHZ        : integer := 100;
+        GENERATE_REFRESH : boolean := true;
+        PHASE_PREDICT    : boolean := false;
+        USE_CACHE        : boolean := true;
+        WRITE_BACK       : boolean := false;
+        USE_WRITE_BUFFER : boolean := false;
+        CACHE_SIZE_BYTES : integer := 1024;
+        LINE_SIZE_BYTES  : integer := 16;
+        ASSOCIATIVITY    : integer := 1;
+        SPLIT_ID         : boolean := false;
+        PREFETCH         : boolean := false;
+        PREFETCH_BYTES   : integer := 4;
+        BURST_LENGTH     : integer := 1;
+        FAST_BYTES       : integer := 0
+    );
+    port (
+        sdram_clk       : in  std_logic;
+        E               : in  std_logic;
+        reset_n         : in  std_logic;
+        sram_ce_n       : in  std_logic;
+        sram_we_n       : in  std_logic;
+        sram_oe_n       : in  std_logic;
+        sram_sync       : in  std_logic := '0';
+        sram_addr       : in  std_logic_vector(ADDR_BITS-1 downto 0);
+        sram_din        : in  std_logic_vector(7 downto 0);
+        sram_dout       : out std_logic_vector(7 downto 0);
+        mrdy            : out std_logic;
+        cpu_phase       : in  std_logic_vector(1 downto 0) := "00";
+        sdram_req       : out std_logic;
+        sdram_wr_n      : out std_logic;
+        sdram_addr      : out std_logic_vector(ADDR_BITS-2 downto 0);
+        sdram_din       : out std_logic_vector(15 downto 0);
+        sdram_dout      : in  std_logic_vector(15 downto 0);
+        sdram_byte_en   : out std_logic_vector(1 downto 0);
+        sdram_ready     : in  std_logic;
+        sdram_ack       : in  std_logic;
+        sdram_burst     : out std_logic;
+        sdram_dvalid    : in  std_logic := '0';
+        sdram_next_req  : out std_logic;
+        sdram_next_addr : out std_logic_vector(ADDR_BITS-2 downto 0);
+        refresh_req     : out std_logic;
+        refresh_ok      : out std_logic;
+        quiet_cycles    : out unsigned(7 downto 0);
+        flush           : in  std_logic := '0';
+        flush_busy      : out std_logic;
+        cache_en        : in  std_logic := '1';
+        maint_req       : in  std_logic := '0';
+        maint_op        : in  std_logic_vector(2 downto 0) := "000";
+        maint_lo        : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_hi        : in  std_logic_vector(ADDR_BITS-1 downto 0) := (others => '0');
+        maint_busy      : out std_logic;
+        maint_full      : out std_logic;
+        cache_hitp      : out unsigned(6 downto 0);
+        ev_hit          : out std_logic;
+        ev_miss         : out std_logic;
+        ev_write        : out std_logic;
+        ev_ihit         : out std_logic;
+        ev_imiss        : out std_logic;
+        ev_prefetch     : out std_logic;
+        ev_pf_hit       : out std_logic;
+        debug           : out std_logic_vector(2 downto 0)
+    );
+end component;
+
+component sdram_bist is
+    generic (
+        ADDR_WIDTH     : integer := 25
+    );
+    port (
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0'
+    );
+end component;
+
+component sdram_trainer is
+    generic (
+        ADDR_WIDTH     : integer := 25;
+        TRAIN_WORDS    : integer := 4;
+        ENABLE         : boolean := true
+    );
+    port (
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        c_req          : in  std_logic;
+        c_wr_n         : in  std_logic;
+        c_addr         : in  std_logic_vector(ADDR_WIDTH-1 downto 0);
+        c_din          : in  std_logic_vector(15 downto 0);
+        c_byte_en      : in  std_logic_vector(1 downto 0);
+        c_burst        : in  std_logic := '0';
+        c_dout         : out std_logic_vector(15 downto 0);
+        c_ready        : out std_logic;
+        c_ack          : out std_logic;
+        c_dvalid       : out std_logic;
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0';
+        rd_delay       : out unsigned(1 downto 0);
+        train_done     : out std_logic;
+        train_ok       : out std_logic
+    );
+end component;
+
+component cache_ctrl is
+    generic (
+        ADDR_BITS      : integer := 16
+    );
+    port (
+        phi2           : in  std_logic;
+        cpu_reset_n    : in  std_logic;
+        cs_n           : in  std_logic;
+        rw             : in  std_logic;
+        address        : in  std_logic_vector(3 downto 0);
+        data_in        : in  std_logic_vector(7 downto 0);
+        data_out       : out std_logic_vector(7 downto 0);
+        clk            : in  std_logic;
+        cache_en       : out std_logic;
+        flush          : out std_logic;
+        flush_busy     : in  std_logic := '0';
+        maint_req      : out std_logic;
+        maint_op       : out std_logic_vector(2 downto 0);
+        maint_lo       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_hi       : out std_logic_vector(ADDR_BITS-1 downto 0);
+        maint_busy     : in  std_logic := '0';
+        maint_full     : in  std_logic := '0';
+        ev_hit         : in  std_logic := '0';
+        ev_miss        : in  std_logic := '0'
+    );
+end component;
+
+component sdram_controller is
+    generic (
+        FREQ_MHZ           : integer := 100;
+        ROW_BITS           : integer := 13;
+        COL_BITS           : integer := 10;
+        CAS_LATENCY        : integer := 2;
+        USE_AUTO_PRECHARGE : boolean := true;
+        USE_AUTO_REFRESH   : boolean := true;
+        BURST_LENGTH       : integer := 1
+    );
+    port(
+        clk            : in    std_logic;
+        reset_n        : in    std_logic;
+        req            : in    std_logic;
+        wr_n           : in    std_logic;
+        addr           : in    std_logic_vector(ROW_BITS+COL_BITS+1 downto 0);
+        din            : in    std_logic_vector(15 downto 0);
+        dout           : out   std_logic_vector(15 downto 0);
+        byte_en        : in    std_logic_vector(1 downto 0);
+        burst          : in    std_logic := '0';
+        rd_delay       : in    unsigned(1 downto 0) := "00";
+        next_req       : in    std_logic := '0';
+        next_addr      : in    std_logic_vector(ROW_BITS+COL_BITS+1 downto 0) := (others => '0');
+        ready          : out   std_logic;
+        ack            : out   std_logic;
+        dvalid         : out   std_logic;
+        refresh_req    : in    std_logic;
+        refresh_ok     : in    std_logic := '1';
+        quiet_cycles   : in    unsigned(7 downto 0) := (others => '1');
+        refresh_active : out   std_logic;
+        ev_activate    : out   std_logic;
+        ev_row_hit     : out   std_logic;
+        ev_refresh     : out   std_logic;
+        sdram_clk      : out   std_logic;
+        sdram_cke      : out   std_logic;
+        sdram_cs_n     : out   std_logic;
+        sdram_ras_n    : out   std_logic;
+        sdram_cas_n    : out   std_logic;
+        sdram_we_n     : out   std_logic;
+        sdram_ba       : out   std_logic_vector(1 downto 0);
+        sdram_addr     : out   std_logic_vector(ROW_BITS-1 downto 0);
+        sdram_dq       : inout std_logic_vector(15 downto 0);
+        sdram_dqm      : out   std_logic_vector(1 downto 0)
+    );
+end component;
+
+component sdram_model is
+    generic (
+        ROW_BITS    : integer := 13;
+        COL_BITS    : integer := 10;
+        BOARD_DELAY : time    := 4 ns;
+        PRELOAD_FILE: string  := "";
+        PRELOAD_SKIP: integer := 0
+    );
+    port (
+        clk         : in    std_logic;
+        cke         : in    std_logic;
+        cs_n        : in    std_logic;
+        ras_n       : in    std_logic;
+        cas_n       : in    std_logic;
+        we_n        : in    std_logic;
+        ba          : in    std_logic_vector(1 downto 0);
+        addr        : in    std_logic_vector(ROW_BITS-1 downto 0);
+        dq          : inout std_logic_vector(15 downto 0);
+        dqm         : in    std_logic_vector(1 downto 0);
+        preload     : in    std_logic := '0';
+        violations  : out   natural
+    );
+end component;
+
+component uart_stub is
+    generic (
+        MON_FILE     : string  := "";
+        INPUT_FILE   : string  := "";
+        RUN_ONLY     : boolean := false;
+        BIT_TIME     : time    := 8.68 us
+    );
+    port (
+        tx           : out std_logic;
+        rx           : in  std_logic;
+        running      : out std_logic
+    );
+end component;
+
+--------------------------------------------------------------------------
+-- System Configuration (DE10-Lite)
+--------------------------------------------------------------------------
+-- Bridge window: $E000-$EFFF, or the whole CPU space in phase 2
+function window_bits(ram_in_sdram : boolean) return integer is
+begin
+	if ram_in_sdram then
+		return 16;
+	end if;
+	return 12;
+end function;
+
+constant RAM_SIZE_KB      : integer := 48;
+constant ADDR_BITS        : integer := window_bits(RAM_IN_SDRAM);
+constant PRELOAD_RAM      : boolean := FAST_LOAD and not RAM_IN_SDRAM;
+constant PRELOAD_SDRAM    : boolean := FAST_LOAD and RAM_IN_SDRAM;
+constant SDRAM_ADDR_WIDTH : integer := ROW_BITS + COL_BITS + 2;
+constant SDRAM_PERIOD     : time    := 1000 ns / SDRAM_MHZ;
+constant BIT_TIME         : time    := SERIAL_CLK_PERIOD * (1_843_200 / BAUD_RATE);
+constant DONE_ADDRESS     : std_logic_vector(15 downto 0) := x"FF1F";  -- wozmon GETLINE
+
+type ram_type is array (0 to RAM_SIZE_KB * 1024 - 1) of std_logic_vector(7 downto 0);
+
+signal main_clk        : std_logic := '0';
+signal serial_clk      : std_logic := '0';
+signal sdram_clk       : std_logic := '0';
+signal reset_n         : std_logic := '0';
+signal cpu_reset_n     : std_logic := '0';
+
+signal phi2            : std_logic;
+signal address_bus     : std_logic_vector(15 downto 0);
+signal data_bus        : std_logic_vector(7 downto 0);
+signal rw              : std_logic;
+signal sync            : std_logic;
+signal mrdy            : std_logic;
+signal cpu_phase       : std_logic_vector(1 downto 0);
+signal cpu_stretch     : std_logic;
+signal ram_cs_n        : std_logic;
+signal ram_data        : std_logic_vector(7 downto 0) := (others => '0');
+signal tram_cs_n       : std_logic;
+signal tram_data       : std_logic_vector(7 downto 0);
+signal io_cs_n         : std_logic;
+signal io_data         : std_logic_vector(7 downto 0);
+signal cc_cs_n         : std_logic;
+signal cc_data         : std_logic_vector(7 downto 0);
+signal bist_cs_n       : std_logic;
+signal bist_rw         : std_logic;
+signal bist_address    : std_logic_vector(3 downto 0);
+signal bist_din        : std_logic_vector(7 downto 0);
+signal bist_data       : std_logic_vector(7 downto 0);
+signal tb_cs_n         : std_logic := '1';               -- BIST window before the CPU starts
+signal tb_rw           : std_logic := '1';
+signal tb_address      : std_logic_vector(3 downto 0) := (others => '0');
+signal tb_din          : std_logic_vector(7 downto 0) := (others => '0');
+signal uart_rx         : std_logic;
+signal uart_tx         : std_logic;
+
+-- bridge <-> controller
+signal sdram_req       : std_logic;
+signal sdram_wr_n      : std_logic;
+signal sdram_addr      : std_logic_vector(ADDR_BITS-2 downto 0);
+signal sdram_next_req  : std_logic;
+signal sdram_next_addr : std_logic_vector(ADDR_BITS-2 downto 0);
+signal sdram_din       : std_logic_vector(15 downto 0);
+signal sdram_dout      : std_logic_vector(15 downto 0);
+signal sdram_byte_en   : std_logic_vector(1 downto 0);
+signal sdram_ready     : std_logic;
+signal sdram_ack       : std_logic;
+signal sdram_burst     : std_logic;
+signal sdram_dvalid    : std_logic;
+signal refresh_req     : std_logic;
+signal refresh_ok      : std_logic;
+signal quiet_cycles    : unsigned(7 downto 0);
+signal ev_hit          : std_logic;
+signal ev_miss         : std_logic;
+signal ev_write        : std_logic;
+signal cache_en        : std_logic;
+signal flush           : std_logic;
+signal flush_busy      : std_logic;
+signal maint_req       : std_logic;
+signal maint_op        : std_logic_vector(2 downto 0);
+signal maint_lo        : std_logic_vector(ADDR_BITS-1 downto 0);
+signal maint_hi        : std_logic_vector(ADDR_BITS-1 downto 0);
+signal maint_busy      : std_logic;
+signal maint_full      : std_logic;
+signal ev_ihit         : std_logic;
+signal ev_imiss        : std_logic;
+signal ev_prefetch     : std_logic;
+signal ev_pf_hit       : std_logic;
+signal ev_activate     : std_logic;
+signal ev_row_hit      : std_logic;
+signal ev_refresh      : std_logic;
+signal pmu_events      : std_logic_vector(9 downto 0);
+signal bridge_state    : std_logic_vector(2 downto 0);
+signal trace_ext       : std_logic_vector(7 downto 0);
+
+-- bist <-> trainer
+signal bt_req          : std_logic;
+signal bt_wr_n         : std_logic;
+signal bt_addr         : std_logic_vector(SDRAM_ADDR_WIDTH-1 downto 0);
+signal bt_din          : std_logic_vector(15 downto 0);
+signal bt_dout         : std_logic_vector(15 downto 0);
+signal bt_byte_en      : std_logic_vector(1 downto 0);
+signal bt_burst        : std_logic;
+signal bt_ready        : std_logic;
+signal bt_ack          : std_logic;
+signal bt_dvalid       : std_logic;
+
+-- trainer <-> controller
+signal rd_delay        : unsigned(1 downto 0);
+signal train_done      : std_logic;
+signal train_ok        : std_logic;
+signal sdram_preload   : std_logic := '0';               -- phase 2 FAST_LOAD
+signal ctl_req         : std_logic;
+signal ctl_wr_n        : std_logic;
+signal ctl_addr        : std_logic_vector(SDRAM_ADDR_WIDTH-1 downto 0);
+signal ctl_din         : std_logic_vector(15 downto 0);
+signal ctl_dout        : std_logic_vector(15 downto 0);
+signal ctl_byte_en     : std_logic_vector(1 downto 0);
+signal ctl_burst       : std_logic;
+signal ctl_ready       : std_logic;
+signal ctl_ack         : std_logic;
+signal ctl_dvalid      : std_logic;
+
+-- SDRAM pins
+signal dram_clk        : std_logic;
+signal dram_cke        : std_logic;
+signal dram_cs_n       : std_logic;
+signal dram_ras_n      : std_logic;
+signal dram_cas_n      : std_logic;
+signal dram_we_n       : std_logic;
+signal dram_ba         : std_logic_vector(1 downto 0);
+signal dram_addr       : std_logic_vector(ROW_BITS-1 downto 0);
+signal dram_dq         : std_logic_vector(15 downto 0);
+signal dram_dqm        : std_logic_vector(1 downto 0);
+
+-- Measure
+signal running         : std_logic;
+signal done            : boolean := false;
+signal timeout         : boolean := false;
+signal total_cycles    : natural := 0;
+signal cpu_cycles      : natural := 0;
+signal stretched       : natural := 0;
+signal phi2_high       : integer range 0 to 2 := 0;
+signal hits            : natural := 0;
+signal misses          : natural := 0;
+signal writes          : natural := 0;
+signal ihits           : natural := 0;
+signal imisses         : natural := 0;
+signal prefetches      : natural := 0;
+signal pf_hits         : natural := 0;
+signal activates       : natural := 0;
+signal row_hits        : natural := 0;
+signal refreshes       : natural := 0;
+signal ref_stalls      : natural := 0;
+signal violations      : natural := 0;
+signal bist_status     : integer range 0 to 2 := 0;      -- none, pass, fail
+signal bist_errors     : natural := 0;
+signal bist_accesses   : natural := 0;
+signal bist_cycles     : natural := 0;
+
+begin
+
+	--========================================
+	-- Clocks and reset
+	--========================================
+	main_clk    <= not main_clk   after MAIN_CLK_PERIOD / 2;
+	serial_clk  <= not serial_clk after SERIAL_CLK_PERIOD / 2;
+	sdram_clk   <= not sdram_clk  after SDRAM_PERIOD / 2;
+	reset_n     <= '1' after 1 us;
+
+	ap1: Replica1_CORE               generic map(CPU_TYPE       =>  "6502",
+												 CPU_CORE       =>  "MX65",
+												 ROM            =>  "WOZMON65",
+												 RAM_SIZE_KB    =>  RAM_SIZE_KB,
+												 BAUD_RATE      =>  BAUD_RATE,
+												 HAS_MSPI       =>  true,
+												 HAS_TIMER      =>  true,
+												 HAS_PMU        =>  true,
+												 HAS_TRACE      =>  true,
+												 RAM_IN_SDRAM   =>  RAM_IN_SDRAM)
+								        port map(main_clk       =>  main_clk,
+											     serial_clk     =>  serial_clk,
+												 reset_n        =>  reset_n,
+												 cpu_reset_n    =>  cpu_reset_n,
+												 bus_phi2       =>  phi2,
+												 bus_address    =>  address_bus,
+												 bus_data       =>  data_bus,
+												 bus_rw         =>  rw,
+												 bus_sync       =>  sync,
+												 bus_mrdy       =>  mrdy,
+												 bus_phase      =>  cpu_phase,
+												 bus_stretch    =>  cpu_stretch,
+												 ext_ram_cs_n   =>  ram_cs_n,
+												 ext_ram_data   =>  ram_data,
+												 ext_tram_cs_n  =>  tram_cs_n,
+												 ext_tram_data  =>  tram_data,
+												 ext_io_cs_n    =>  io_cs_n,
+												 ext_io_data    =>  io_data,
+												 uart_rx        =>  uart_rx,
+												 uart_tx        =>  uart_tx,
+												 spi_cs         =>  open,
+												 spi_sck        =>  open,
+												 spi_mosi       =>  open,
+												 spi_miso       =>  '1',       -- no card
+												 tape_out       =>  open,
+												 tape_in        =>  '0',
+												 pmu_ev_clk     =>  sdram_clk,
+												 pmu_events     =>  pmu_events,
+												 trace_ext      =>  trace_ext);
+
+	-- pmu event order of Replica1_CORE
+	pmu_events <= ev_pf_hit & ev_prefetch & ev_imiss & ev_ihit & ev_refresh &
+	              ev_row_hit & ev_activate & ev_write & ev_miss & ev_hit;
+
+	-- bus trace ext byte: stretch, mrdy, bridge state
+	trace_ext  <= "000" & cpu_stretch & mrdy & bridge_state;
+
+	--========================================
+	-- RAM (EBR_RAM on phi2) with the fast load
+	--========================================
+	RAM_PROCESS: process
+		variable ram : ram_type := (others => (others => '0'));
+
+		function hex_digit(c : character) return integer is
+		begin
+			case c is
+				when '0' to '9' => return character'pos(c) - character'pos('0');
+				when 'A' to 'F' => return character'pos(c) - character'pos('A') + 10;
+				when 'a' to 'f' => return character'pos(c) - character'pos('a') + 10;
+				when others     => return -1;
+			end case;
+		end function;
+
+		-- "0300: D8 A9", ": 01 20", "0300R": an address ends with ':' or
+		-- 'R', a 1 or 2 digit value is a data byte
+		procedure load_mon(name : string) is
+			file     f      : text;
+			variable status : file_open_status;
+			variable l      : line;
+			variable addr   : integer := 0;
+			variable value  : integer;
+			variable digits : integer;
+			variable c      : character;
+			variable skipped: integer := 0;
+		begin
+			file_open(status, f, name, read_mode);
+			if status /= open_ok then
+				report "Replica1_SIM: cannot open " & name severity failure;
+			end if;
+			while not endfile(f) loop
+				readline(f, l);
+				value  := 0;
+				digits := 0;
+				for i in 1 to l'length + 1 loop
+					if i <= l'length then
+						c := l(i);
+					else
+						c := ' ';
+					end if;
+					if hex_digit(c) >= 0 then
+						value  := value * 16 + hex_digit(c);
+						digits := digits + 1;
+					else
+						if digits > 0 then
+							if c = ':' or c = 'R' or c = 'r' or c = '.' or digits > 2 then
+								addr := value;
+							elsif addr < RAM_SIZE_KB * 1024 then
+								ram(addr) := std_logic_vector(to_unsigned(value, 8));
+								addr := addr + 1;
+							else
+								skipped := skipped + 1;
+								addr := addr + 1;
+							end if;
+						end if;
+						value  := 0;
+						digits := 0;
+					end if;
+				end loop;
+				deallocate(l);
+			end loop;
+			file_close(f);
+			if skipped > 0 then
+				report "Replica1_SIM: " & integer'image(skipped) &
+				       " bytes outside the RAM not preloaded, use FAST_LOAD = false"
+				       severity warning;
+			end if;
+		end procedure;
+
+	begin
+		if PRELOAD_RAM and MON_FILE /= "" then
+			load_mon(MON_FILE);
+		end if;
+		loop
+			wait until rising_edge(phi2);
+			if ram_cs_n = '0' then
+				if rw = '0' then
+					ram(to_integer(unsigned(address_bus))) := data_bus;
+				else
+					ram_data <= ram(to_integer(unsigned(address_bus)));
+				end if;
+			end if;
+		end loop;
+	end process RAM_PROCESS;
+
+	--========================================
+	-- SDRAM window $E000-$EFFF (and the RAM with RAM_IN_SDRAM)
+	--========================================
+    bridge_inst : sram_sdram_bridge  generic map(ADDR_BITS        => ADDR_BITS,
+	                                             SDRAM_MHZ        => SDRAM_MHZ,
+                                                 GENERATE_REFRESH => true,
+                                                 PHASE_PREDICT    => PHASE_PREDICT,
+                                                 USE_CACHE        => USE_CACHE,
+                                                 WRITE_BACK       => WRITE_BACK,
+                                                 USE_WRITE_BUFFER => USE_WRITE_BUFFER,
+                                                 CACHE_SIZE_BYTES => CACHE_SIZE_BYTES,
+                                                 LINE_SIZE_BYTES  => LINE_SIZE_BYTES,
+                                                 ASSOCIATIVITY    => ASSOCIATIVITY,
+                                                 SPLIT_ID         => SPLIT_ID,
+                                                 PREFETCH         => PREFETCH,
+                                                 PREFETCH_BYTES   => PREFETCH_BYTES,
+                                                 BURST_LENGTH     => BURST_LENGTH,
+                                                 FAST_BYTES       => FAST_BYTES)
+									    port map(sdram_clk        => sdram_clk,
+										      	 E                => phi2,
+												 reset_n          => reset_n,
+												 sram_ce_n        => tram_cs_n,
+												 sram_we_n        => rw,
+												 sram_oe_n        => not rw,
+												 sram_sync        => sync,
+												 sram_addr        => address_bus(ADDR_BITS - 1 downto 0),
+												 sram_din         => data_bus,
+												 sram_dout        => tram_data,
+												 mrdy             => mrdy,
+												 cpu_phase        => cpu_phase,
+												 sdram_req        => sdram_req,
+												 sdram_wr_n       => sdram_wr_n,
+												 sdram_addr       => sdram_addr,
+												 sdram_din        => sdram_din,
+												 sdram_dout       => sdram_dout,
+												 sdram_byte_en    => sdram_byte_en,
+												 sdram_ready      => sdram_ready,
+												 sdram_ack        => sdram_ack,
+												 sdram_burst      => sdram_burst,
+												 sdram_dvalid     => sdram_dvalid,
+												 sdram_next_req   => sdram_next_req,
+												 sdram_next_addr  => sdram_next_addr,
+												 refresh_req      => refresh_req,
+												 refresh_ok       => refresh_ok,
+												 quiet_cycles     => quiet_cycles,
+												 flush            => flush,
+												 flush_busy       => flush_busy,
+												 cache_en         => cache_en,
+												 maint_req        => maint_req,
+												 maint_op         => maint_op,
+												 maint_lo         => maint_lo,
+												 maint_hi         => maint_hi,
+												 maint_busy       => maint_busy,
+												 maint_full       => maint_full,
+												 cache_hitp       => open,
+												 ev_hit           => ev_hit,
+												 ev_miss          => ev_miss,
+												 ev_write         => ev_write,
+												 ev_ihit          => ev_ihit,
+												 ev_imiss         => ev_imiss,
+												 ev_prefetch      => ev_prefetch,
+												 ev_pf_hit        => ev_pf_hit,
+												 debug            => bridge_state);
+
+	--========================================
+	-- Cache control registers $C250-$C25F
+	--========================================
+	cc_cs_n <= '0' when io_cs_n = '0' and address_bus(7 downto 4) = x"5" else '1';
+	io_data <= cc_data   when cc_cs_n = '0' else
+	           bist_data when io_cs_n = '0' and address_bus(7 downto 4) = x"4" else
+	           (others => '1');
+
+    cc_inst : cache_ctrl            generic map (ADDR_BITS          => ADDR_BITS)
+									   port map (phi2               => phi2,
+												 cpu_reset_n        => cpu_reset_n,
+												 cs_n               => cc_cs_n,
+												 rw                 => rw,
+												 address            => address_bus(3 downto 0),
+												 data_in            => data_bus,
+												 data_out           => cc_data,
+												 clk                => sdram_clk,
+												 cache_en           => cache_en,
+												 flush              => flush,
+												 flush_busy         => flush_busy,
+												 maint_req          => maint_req,
+												 maint_op           => maint_op,
+												 maint_lo           => maint_lo,
+												 maint_hi           => maint_hi,
+												 maint_busy         => maint_busy,
+												 maint_full         => maint_full,
+												 ev_hit             => ev_hit,
+												 ev_miss            => ev_miss);
+
+	--========================================
+	-- SDRAM BIST between the bridge and the controller
+	--========================================
+	-- The testbench owns the register window while the CPU is in reset
+	-- (BIST_PROCESS), the CPU gets it at $C240-$C24F afterwards
+	bist_cs_n    <= tb_cs_n    when cpu_reset_n = '0' else
+	                '0'        when io_cs_n = '0' and address_bus(7 downto 4) = x"4" else
+	                '1';
+	bist_rw      <= tb_rw      when cpu_reset_n = '0' else rw;
+	bist_address <= tb_address when cpu_reset_n = '0' else address_bus(3 downto 0);
+	bist_din     <= tb_din     when cpu_reset_n = '0' else data_bus;
+
+    bist_inst : sdram_bist          generic map (ADDR_WIDTH         => SDRAM_ADDR_WIDTH)
+									   port map (phi2               => phi2,
+												 cpu_reset_n        => reset_n,
+												 cs_n               => bist_cs_n,
+												 rw                 => bist_rw,
+												 address            => bist_address,
+												 data_in            => bist_din,
+												 data_out           => bist_data,
+												 clk                => sdram_clk,
+												 reset_n            => reset_n,
+												 c_req              => sdram_req,
+												 c_wr_n             => sdram_wr_n,
+												 c_addr             => std_logic_vector(resize(unsigned(sdram_addr), SDRAM_ADDR_WIDTH)),
+												 c_din              => sdram_din,
+												 c_byte_en          => sdram_byte_en,
+												 c_burst            => sdram_burst,
+												 c_dout             => sdram_dout,
+												 c_ready            => sdram_ready,
+												 c_ack              => sdram_ack,
+												 c_dvalid           => sdram_dvalid,
+												 req                => bt_req,
+												 wr_n               => bt_wr_n,
+												 addr               => bt_addr,
+												 din                => bt_din,
+												 dout               => bt_dout,
+												 byte_en            => bt_byte_en,
+												 burst              => bt_burst,
+												 ready              => bt_ready,
+												 ack                => bt_ack,
+												 dvalid             => bt_dvalid);
+
+	--========================================
+	-- Read capture trainer in front of the controller
+	--========================================
+    train_inst : sdram_trainer      generic map (ADDR_WIDTH         => SDRAM_ADDR_WIDTH,
+												 ENABLE             => TRAIN)
+									   port map (clk                => sdram_clk,
+												 reset_n            => reset_n,
+												 c_req              => bt_req,
+												 c_wr_n             => bt_wr_n,
+												 c_addr             => bt_addr,
+												 c_din              => bt_din,
+												 c_byte_en          => bt_byte_en,
+												 c_burst            => bt_burst,
+												 c_dout             => bt_dout,
+												 c_ready            => bt_ready,
+												 c_ack              => bt_ack,
+												 c_dvalid           => bt_dvalid,
+												 req                => ctl_req,
+												 wr_n               => ctl_wr_n,
+												 addr               => ctl_addr,
+												 din                => ctl_din,
+												 dout               => ctl_dout,
+												 byte_en            => ctl_byte_en,
+												 burst              => ctl_burst,
+												 ready              => ctl_ready,
+												 ack                => ctl_ack,
+												 dvalid             => ctl_dvalid,
+												 rd_delay           => rd_delay,
+												 train_done         => train_done,
+												 train_ok           => train_ok);
+
+    sdram_inst : sdram_controller   generic map (FREQ_MHZ           => SDRAM_MHZ,
+									 			 ROW_BITS           => ROW_BITS,
+												 COL_BITS           => COL_BITS,
+                                                 CAS_LATENCY        => CAS_LATENCY,
+                                                 USE_AUTO_PRECHARGE => AUTO_PRECHARGE,
+                                                 USE_AUTO_REFRESH   => false,
+                                                 BURST_LENGTH       => BURST_LENGTH)
+									   port map (clk                => sdram_clk,
+												 reset_n            => reset_n,
+												 req                => ctl_req,
+												 wr_n               => ctl_wr_n,
+												 addr               => ctl_addr,
+												 din                => ctl_din,
+												 dout               => ctl_dout,
+												 byte_en            => ctl_byte_en,
+												 burst              => ctl_burst,
+												 rd_delay           => rd_delay,
+												 next_req           => sdram_next_req,
+												 next_addr          => std_logic_vector(resize(unsigned(sdram_next_addr), SDRAM_ADDR_WIDTH)),
+												 ready              => ctl_ready,
+												 ack                => ctl_ack,
+												 dvalid             => ctl_dvalid,
+												 refresh_req        => refresh_req,
+												 refresh_ok         => refresh_ok,
+												 quiet_cycles       => quiet_cycles,
+												 refresh_active     => open,
+												 ev_activate        => ev_activate,
+												 ev_row_hit         => ev_row_hit,
+												 ev_refresh         => ev_refresh,
+												 sdram_clk          => dram_clk,
+												 sdram_cke          => dram_cke,
+												 sdram_cs_n         => dram_cs_n,
+												 sdram_ras_n        => dram_ras_n,
+												 sdram_cas_n        => dram_cas_n,
+												 sdram_we_n         => dram_we_n,
+												 sdram_ba           => dram_ba,
+												 sdram_addr         => dram_addr,
+												 sdram_dq           => dram_dq,
+												 sdram_dqm          => dram_dqm);
+
+	chip: sdram_model                 generic map(ROW_BITS       => ROW_BITS,
+												  COL_BITS       => COL_BITS,
+												  BOARD_DELAY    => BOARD_DELAY,
+												  PRELOAD_FILE   => MON_FILE,
+												  PRELOAD_SKIP   => FAST_BYTES)
+									     port map(clk            => dram_clk,
+											      cke            => dram_cke,
+												  cs_n           => dram_cs_n,
+												  ras_n          => dram_ras_n,
+												  cas_n          => dram_cas_n,
+												  we_n           => dram_we_n,
+												  ba             => dram_ba,
+												  addr           => dram_addr,
+												  dq             => dram_dq,
+												  dqm            => dram_dqm,
+												  preload        => sdram_preload,
+												  violations     => violations);
+
+	--========================================
+	-- BIST before the CPU starts
+	--========================================
+	-- The four tests on the first 2**BIST_SIZE words through the register
+	-- window, like a CPU would, March C- last so the region ends zeroed;
+	-- then the CPU leaves reset. Each test must report DONE, no error
+	-- and its exact number of accesses. Phase 2 FAST_LOAD preloads the
+	-- SDRAM after the BIST, which overwrites its region
+	BIST_PROCESS: process
+		type test_list_type is array (0 to 3) of integer;
+		constant TESTS  : test_list_type := (1, 2, 3, 0);         -- walking, address, random, march
+		constant PASSES : test_list_type := (10, 32, 4, 2);      -- accesses per word, by test number
+		variable v      : std_logic_vector(7 downto 0);
+		variable count  : unsigned(31 downto 0);
+		variable ok     : boolean := true;
+
+		-- one CPU cycle on the window, v = data read
+		procedure bist_access(a : integer; wr : boolean; d : std_logic_vector(7 downto 0)) is
+		begin
+			wait until falling_edge(phi2);
+			tb_cs_n    <= '0';
+			tb_rw      <= '1';
+			if wr then
+				tb_rw  <= '0';
+			end if;
+			tb_address <= std_logic_vector(to_unsigned(a, 4));
+			tb_din     <= d;
+			wait until falling_edge(phi2);
+			v       := bist_data;
+			tb_cs_n <= '1';
+		end procedure;
+
+		procedure bist_read32(a : integer) is
+		begin
+			for i in 0 to 3 loop
+				bist_access(a + i, false, x"00");
+				count(i*8+7 downto i*8) := unsigned(v);
+			end loop;
+		end procedure;
+	begin
+		cpu_reset_n <= '0';
+		wait for 2 us;
+		if BIST_SIZE > 0 then
+			bist_access(1, true, std_logic_vector(to_unsigned(BIST_SIZE, 8)));
+			for t in TESTS'range loop
+				bist_access(0, true, std_logic_vector(to_unsigned(TESTS(t) * 2 + 1, 8)));
+				loop                                              -- started (after the SDRAM init)
+					bist_access(0, false, x"00");
+					exit when v(0) = '1';
+				end loop;
+				loop                                              -- finished
+					bist_access(0, false, x"00");
+					exit when v(0) = '0' and v(1) = '1';
+				end loop;
+				if v(2) = '1' then
+					ok := false;
+				end if;
+				bist_read32(4);
+				bist_errors <= bist_errors + to_integer(count);
+				if count /= 0 then
+					ok := false;
+				end if;
+				bist_read32(8);
+				bist_accesses <= bist_accesses + to_integer(count);
+				if to_integer(count) /= PASSES(TESTS(t)) * 2**BIST_SIZE then
+					report "Replica1_SIM: BIST test " & integer'image(TESTS(t)) & " made " &
+					       integer'image(to_integer(count)) & " accesses" severity error;
+					ok := false;
+				end if;
+				bist_read32(12);
+				bist_cycles <= bist_cycles + to_integer(count);
+				wait for 0 ns;
+			end loop;
+			if ok then
+				bist_status <= 1;
+			else
+				bist_status <= 2;
+			end if;
+		end if;
+		if PRELOAD_SDRAM and MON_FILE /= "" then
+			if train_done /= '1' then
+				wait until train_done = '1';
+			end if;
+			sdram_preload <= '1';
+			wait until rising_edge(sdram_clk);
+			wait until rising_edge(sdram_clk);
+		end if;
+		cpu_reset_n <= '1';
+		wait;
+	end process BIST_PROCESS;
+
+	--========================================
+	-- Terminal
+	--========================================
+	term: uart_stub                   generic map(MON_FILE       => MON_FILE,
+												  INPUT_FILE     => INPUT_FILE,
+												  RUN_ONLY       => FAST_LOAD,
+												  BIT_TIME       => BIT_TIME)
+									     port map(tx             => uart_rx,
+												  rx             => uart_tx,
+												  running        => running);
+
+	--========================================
+	-- Measure
+	--========================================
+	-- CPU cycles, end of the program (phi2)
+	CYCLE_PROCESS: process(phi2)
+	begin
+		if rising_edge(phi2) then
+			if not done and not timeout then
+				total_cycles <= total_cycles + 1;
+				if total_cycles >= MAX_CPU_CYCLES then
+					timeout <= true;
+				end if;
+				if running = '1' then
+					cpu_cycles <= cpu_cycles + 1;
+					if address_bus = DONE_ADDRESS then
+						done <= true;
+					end if;
+				end if;
+			end if;
+		end if;
+	end process CYCLE_PROCESS;
+
+	-- Stretched clocks (main_clk), same as the pmu
+	STRETCH_PROCESS: process(main_clk)
+	begin
+		if rising_edge(main_clk) then
+			if phi2 = '0' then
+				phi2_high <= 0;
+			elsif phi2_high < 2 then
+				phi2_high <= phi2_high + 1;
+			end if;
+			if running = '1' and not done and not timeout and phi2 = '1' and phi2_high = 2 then
+				stretched <= stretched + 1;
+			end if;
+		end if;
+	end process STRETCH_PROCESS;
+
+	-- Cache and SDRAM events (sdram_clk)
+	EVENT_PROCESS: process(sdram_clk)
+	begin
+		if rising_edge(sdram_clk) then
+			if running = '1' and not done and not timeout then
+				if ev_hit = '1'      then hits      <= hits + 1;      end if;
+				if ev_miss = '1'     then misses    <= misses + 1;    end if;
+				if ev_write = '1'    then writes    <= writes + 1;    end if;
+				if ev_ihit = '1'     then ihits     <= ihits + 1;     end if;
+				if ev_imiss = '1'    then imisses   <= imisses + 1;   end if;
+				if ev_prefetch = '1' then prefetches <= prefetches + 1; end if;
+				if ev_pf_hit = '1'   then pf_hits   <= pf_hits + 1;   end if;
+				if ev_activate = '1' then activates <= activates + 1; end if;
+				if ev_row_hit = '1'  then row_hits  <= row_hits + 1;  end if;
+				if ev_refresh = '1'  then refreshes <= refreshes + 1; end if;
+			end if;
+		end if;
+	end process EVENT_PROCESS;
+
+	-- REF / PRECHARGE ALL in progress while the CPU clock is stretched
+	-- (sdram_controller default tRFC / tRP), none with PHASE_PREDICT.
+	-- Bank precharges of a row miss are part of the access, not counted
+	OVERLAP_PROCESS: process(dram_clk)
+		variable busy_until : time := 0 ns;
+	begin
+		if rising_edge(dram_clk) then
+			if dram_cs_n = '0' and dram_ras_n = '0' and dram_cas_n = '0' and dram_we_n = '1' then
+				busy_until := now + 70 ns;                             -- REF, tRFC
+			elsif dram_cs_n = '0' and dram_ras_n = '0' and dram_cas_n = '1' and dram_we_n = '0' and
+			      dram_addr(10) = '1' then
+				busy_until := now + 20 ns;                             -- PRECHARGE ALL, tRP
+			end if;
+			if running = '1' and not done and not timeout and
+			   cpu_stretch = '1' and now < busy_until then
+				ref_stalls <= ref_stalls + 1;
+			end if;
+		end if;
+	end process OVERLAP_PROCESS;
+
+	-- Bus trace for software/cachesim (end of phi2: address and data valid)
+	TRACE_PROCESS: process
+		file     f      : text;
+		variable status : file_open_status;
+		variable l      : line;
+	begin
+		if TRACE_FILE = "" then
+			wait;
+		end if;
+		file_open(status, f, TRACE_FILE, write_mode);
+		if status /= open_ok then
+			report "Replica1_SIM: cannot create " & TRACE_FILE severity failure;
+		end if;
+		loop
+			wait until falling_edge(phi2);
+			if running = '1' and not done and not timeout then
+				if rw = '0' then
+					write(l, string'("W "));
+				elsif sync = '1' then
+					write(l, string'("F "));
+				else
+					write(l, string'("R "));
+				end if;
+				write(l, to_hstring(address_bus) & " " & to_hstring(data_bus));
+				writeline(f, l);
+			end if;
+		end loop;
+	end process TRACE_PROCESS;
+
+	REPORT_PROCESS: process
+		variable l        : line;
+		variable hit_rate : integer;
+	begin
+		wait until done or timeout;
+		wait for 200 * BIT_TIME;                  -- let the last line come out
+
+		hit_rate := 0;
+		if hits + misses > 0 then
+			hit_rate := hits * 100 / (hits + misses);
+		end if;
+
+		write(l, string'("RESULT status="));
+		if done then
+			write(l, string'("DONE"));
+		else
+			write(l, string'("TIMEOUT"));
+		end if;
+		write(l, " cycles="       & integer'image(cpu_cycles));
+		write(l, " stall_clocks=" & integer'image(stretched));
+		write(l, " hits="         & integer'image(hits));
+		write(l, " misses="       & integer'image(misses));
+		write(l, " writes="       & integer'image(writes));
+		write(l, " hit_rate="     & integer'image(hit_rate));
+		write(l, " ihits="        & integer'image(ihits));
+		write(l, " imisses="      & integer'image(imisses));
+		write(l, " prefetches="   & integer'image(prefetches));
+		write(l, " pf_hits="      & integer'image(pf_hits));
+		write(l, " activates="    & integer'image(activates));
+		write(l, " row_hits="     & integer'image(row_hits));
+		write(l, " refreshes="    & integer'image(refreshes));
+		write(l, " ref_stalls="   & integer'image(ref_stalls));
+		write(l, " violations="   & integer'image(violations));
+		write(l, " rd_delay="     & integer'image(to_integer(rd_delay)));
+		write(l, " train_ok="     & std_logic'image(train_ok)(2));
+		case bist_status is
+			when 0      => write(l, string'(" bist=OFF"));
+			when 1      => write(l, string'(" bist=PASS"));
+			when others => write(l, string'(" bist=FAIL"));
+		end case;
+		write(l, " bist_errors="  & integer'image(bist_errors));
+		write(l, " bist_accesses=" & integer'image(bist_accesses));
+		write(l, " bist_cycles="  & integer'image(bist_cycles));
+		writeline(output, l);
+
+		std.env.finish;
+		wait;
+	end process REPORT_PROCESS;
+
+end sim;
@@ -0,0 +1,170 @@
+#!/bin/sh
+# Replica 1 full system simulation (GHDL)
+#
+#   ./run_tests.sh                          all software/tests/*.mon, test-pmu first
+#   ./run_tests.sh ../software/tests/hello.mon
+#   GENERICS="-gLINE_SIZE_BYTES=32 -gSDRAM_MHZ=100" ./run_tests.sh
+#   FAST_LOAD=false ./run_tests.sh prog.mon   type the whole .mon into wozmon
+#   BOARD=DE1 ./run_tests.sh                   SDRAM geometry / clock / cache of a board
+#   BOARD=DE10-Lite-P2 ./run_tests.sh          DE10-Lite with RAM_IN_SDRAM (phase 2)
+#
+# A program that reads the keyboard gets the lines of <name>.in next to
+# its .mon (INPUT_FILE), e.g. software/tests/medieval.in quits the game
+#
+# A program fails on TIMEOUT or on any SDRAM timing violation, and with
+# PHASE_PREDICT (default) on a refresh running while the CPU is stretched.
+# The sdram_bist run before the CPU starts must pass (BIST_SIZE=0: off)
+# and sdram_trainer must find a read delay (train_ok=1)
+# test-pmu must print "PMU OK" (pmu counters fed by the bridge and the
+# controller all moved), test-trace "TRACE ... OK" (bus trace trigger and
+# dump), test-preload "PRELOAD ... OK" (cache_ctrl PRELOAD, then no miss)
+#
+# sdram_arbiter_tb runs first, fixed priority then round-robin
+#
+# The first program runs again with BOARD_DELAY=13ns (late read data):
+# the trainer must pick rd_delay=1 and the program must still pass,
+# then with AUTO_PRECHARGE=true and BURST_LENGTH=1 (READA path)
+#
+# One RESULT line per program is collected in results.txt
+
+cd "$(dirname "$0")" || exit 1
+
+GHDL=${GHDL:-ghdl}
+FLAGS="--std=08 -fsynopsys -frelaxed --workdir=work"
+FAST_LOAD=${FAST_LOAD:-true}
+
+# SDRAM geometry and clock of the boards (board/*/*_Replica1.vhd), and
+# the cache setup of the boards on the cached bridge
+# DE10-Lite-P2: the DE10-Lite top with RAM_IN_SDRAM = true (phase 2)
+case ${BOARD:-DE10-Lite} in
+    DE10-Lite)                 BOARD_GENERICS="-gROW_BITS=13 -gCOL_BITS=10 -gSDRAM_MHZ=120 -gBURST_LENGTH=8" ;;
+    DE10-Lite-P2)              BOARD_GENERICS="-gROW_BITS=13 -gCOL_BITS=10 -gSDRAM_MHZ=120 -gBURST_LENGTH=8 -gRAM_IN_SDRAM=true -gFAST_BYTES=512 -gCACHE_SIZE_BYTES=8192" ;;
+    DE1-SOC)                   BOARD_GENERICS="-gROW_BITS=13 -gCOL_BITS=10 -gSDRAM_MHZ=120 -gBURST_LENGTH=8 -gCACHE_SIZE_BYTES=2048" ;;
+    QMTECH)                    BOARD_GENERICS="-gROW_BITS=13 -gCOL_BITS=9 -gSDRAM_MHZ=120 -gBURST_LENGTH=8 -gCACHE_SIZE_BYTES=2048" ;;
+    AX4010|MAX1000-10M16)      BOARD_GENERICS="-gROW_BITS=13 -gCOL_BITS=9 -gSDRAM_MHZ=120" ;;
+    MAX1000-10M08)             BOARD_GENERICS="-gROW_BITS=12 -gCOL_BITS=8 -gSDRAM_MHZ=120" ;;
+    DE1)                       BOARD_GENERICS="-gROW_BITS=12 -gCOL_BITS=8 -gSDRAM_MHZ=100" ;;
+    *) echo "unknown BOARD $BOARD"; exit 1 ;;
+esac
+
+FILES="
+../rtl/cpu/cpu_clock_gen.vhd
+../rtl/cpu/mx65.vhd
+../rtl/cpu/CPU_MX65.vhd
+../rtl/rom/WOZMON65.vhd
+../rtl/peripherals/pia/uart_send.vhd
+../rtl/peripherals/pia/uart_receive.vhd
+../rtl/peripherals/pia/pia_uart.vhd
+../rtl/utils/prog_clock_divider.vhd
+../rtl/utils/spi-master.vhd
+../rtl/peripherals/mspi/mspi-iface.vhd
+../rtl/peripherals/timer/simple_timer.vhd
+../rtl/peripherals/pmu/pmu.vhd
+../rtl/peripherals/trace/bus_trace.vhd
+../rtl/core/Replica1_CORE.vhd
+../rtl/sdram/sdram_controller.vhd
+../rtl/sdram/sram_sdram_cached_bridge.vhd
+../rtl/sdram/cache_ctrl.vhd
+../rtl/sdram/sdram_bist.vhd
+../rtl/sdram/sdram_trainer.vhd
+sdram_model.vhd
+uart_stub.vhd
+Replica1_SIM.vhd
+../rtl/sdram/sdram_arbiter.vhd
+sdram_arbiter_tb.vhd
+"
+
+mkdir -p work
+$GHDL -a $FLAGS $FILES || exit 1
+$GHDL -e $FLAGS Replica1_SIM || exit 1
+$GHDL -e $FLAGS sdram_arbiter_tb || exit 1
+
+# test-pmu first: the first program is run again below, it must use the
+# SDRAM window
+if [ $# -eq 0 ]; then
+    set -- ../software/tests/test-pmu.mon $(ls ../software/tests/*.mon | grep -v '/test-pmu\.mon$')
+fi
+
+# run_program <mon> <log name> [generics]: sets result, clears status on failure
+run_program() {
+    input=""
+    if [ -f "${1%.mon}.in" ]; then
+        input="-gINPUT_FILE=${1%.mon}.in"
+    fi
+    $GHDL -r $FLAGS Replica1_SIM -gMON_FILE="$1" -gFAST_LOAD=$FAST_LOAD $BOARD_GENERICS $GENERICS $input $3 \
+          --ieee-asserts=disable-at-0 > "$2.log" 2>&1
+    grep "^UART> " "$2.log" | tail -5
+    grep "sdram_model:" "$2.log" | head -20
+    result=$(grep "RESULT" "$2.log" | sed 's/.*RESULT //')
+    if [ -z "$result" ]; then
+        result="status=ERROR (see $2.log)"
+    fi
+    case "$result" in
+        *" violations=0 "*) ;;
+        *) status=1 ;;
+    esac
+    case "$result" in
+        *" train_ok=1 "*) ;;
+        *) status=1 ;;
+    esac
+    case "$result" in
+        *" bist=PASS "*|*" bist=OFF "*) ;;
+        *) status=1 ;;
+    esac
+    case "$result" in
+        status=DONE*) ;;
+        *) status=1 ;;
+    esac
+    case "$2" in
+        test-pmu)   grep -q "^UART> .*PMU OK" "$2.log" || status=1 ;;
+        test-trace) grep -q "^UART> .*TRACE .* OK" "$2.log" || status=1 ;;
+        test-preload) grep -q "^UART> .*PRELOAD .* OK" "$2.log" || status=1 ;;
+    esac
+    case "$GENERICS" in
+        *PHASE_PREDICT=false*) ;;
+        *) case "$result" in
+               *" ref_stalls=0 "*) ;;
+               *) status=1 ;;
+           esac ;;
+    esac
+}
+
+: > results.txt
+status=0
+
+for rr in false true; do
+    echo "=== sdram_arbiter round_robin=$rr"
+    $GHDL -r $FLAGS sdram_arbiter_tb -gROUND_ROBIN=$rr > "arbiter-$rr.log" 2>&1
+    result=$(grep "ARBITER" "arbiter-$rr.log" | sed 's/.*ARBITER //')
+    case "$result" in
+        *status=PASS) ;;
+        *) status=1; result="${result:-status=ERROR (see arbiter-$rr.log)}" ;;
+    esac
+    echo "arbiter $result" | tee -a results.txt
+done
+
+for mon in "$@"; do
+    name=$(basename "$mon" .mon)
+    echo "=== $name"
+    run_program "$mon" "$name"
+    echo "$name $result" | tee -a results.txt
+done
+
+# read capture training: data 13 ns late needs one extra capture clock
+name=$(basename "$1" .mon)-delay
+echo "=== $name"
+run_program "$1" "$name" -gBOARD_DELAY=13ns
+case "$result" in
+    *" rd_delay=1 "*) ;;
+    *) status=1 ;;
+esac
+echo "$name $result" | tee -a results.txt
+
+# auto-precharge (entity default, no board uses it): READA / WRITEA with
+# single reads, the next access must ACTIVATE after tRP (violations=0)
+name=$(basename "$1" .mon)-ap
+echo "=== $name"
+run_program "$1" "$name" "-gAUTO_PRECHARGE=true -gBURST_LENGTH=1"
+echo "$name $result" | tee -a results.txt
+
+exit $status
@@ -0,0 +1,450 @@
+--------------------------------------------------------------------------------
+-- SDRAM Arbiter Testbench
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- sdram_arbiter_tb - Theory of Operation
+--------------------------------------------------------------------------------
+-- Two clients share a behavioral controller through sdram_arbiter, run by
+-- run_tests.sh once per arbitration mode (-gROUND_ROBIN=false / true).
+--
+-- 1. Controller Model
+--    - ready in idle, takes req, answers LATENCY clocks later
+--    - Writes honor byte_en, reads return one word with ack, burst
+--      reads return BURST_LENGTH words with dvalid, ack on the last one
+--    - Back in idle (ready) in the ack cycle, like sdram_controller
+--    - Logs the granted port of every request it takes
+--
+-- 2. Clients
+--    - Same protocol as the bridge: wait for p_ready, assert req with
+--      the address / data, hold until ack, drop it on ack
+--    - Read data (and every burst beat) is checked
+--
+-- 3. Rounds
+--    - Each round gives port 0 and/or port 1 one access, started in the
+--      same clock: both raise req together when both are used
+--    - Writes fill both areas, a byte_en write, single and burst reads
+--      read them back
+--    - The expected grant order follows the policy:
+--      * fixed priority: port 0 first on every tie
+--      * round-robin: the port after the last one served first
+--    - A round with a single port moves the round-robin pointer, so the
+--      two modes give different orders
+--
+-- 4. Checks
+--    - At most one p_ready while a port requests
+--    - p_ack / p_dvalid only to the port holding req
+--    - Read data, grant order and number of requests taken (no
+--      request taken twice)
+--    - One line on the console, read by run_tests.sh:
+--      ARBITER round_robin=... order=... status=PASS|FAIL
+--------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use std.textio.all;
+
+entity sdram_arbiter_tb is
+    generic (
+        ROUND_ROBIN    : boolean := false;
+        LATENCY        : integer := 3;      -- clocks from req to ack
+        BURST_LENGTH   : integer := 4
+    );
+end sdram_arbiter_tb;
+
+architecture sim of sdram_arbiter_tb is
+
+component sdram_arbiter is
+    generic (
+        NUM_PORTS      : integer := 2;
+        ADDR_WIDTH     : integer := 25;
+        ROUND_ROBIN    : boolean := false
+    );
+    port (
+        clk            : in  std_logic;
+        reset_n        : in  std_logic;
+        p_req          : in  std_logic_vector(NUM_PORTS-1 downto 0);
+        p_wr_n         : in  std_logic_vector(NUM_PORTS-1 downto 0);
+        p_addr         : in  std_logic_vector(NUM_PORTS*ADDR_WIDTH-1 downto 0);
+        p_din          : in  std_logic_vector(NUM_PORTS*16-1 downto 0);
+        p_byte_en      : in  std_logic_vector(NUM_PORTS*2-1 downto 0);
+        p_burst        : in  std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+        p_next_req     : in  std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+        p_next_addr    : in  std_logic_vector(NUM_PORTS*ADDR_WIDTH-1 downto 0) := (others => '0');
+        p_dout         : out std_logic_vector(15 downto 0);
+        p_ready        : out std_logic_vector(NUM_PORTS-1 downto 0);
+        p_ack          : out std_logic_vector(NUM_PORTS-1 downto 0);
+        p_dvalid       : out std_logic_vector(NUM_PORTS-1 downto 0);
+        req            : out std_logic;
+        wr_n           : out std_logic;
+        addr           : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        din            : out std_logic_vector(15 downto 0);
+        dout           : in  std_logic_vector(15 downto 0);
+        byte_en        : out std_logic_vector(1 downto 0);
+        burst          : out std_logic;
+        ready          : in  std_logic;
+        ack            : in  std_logic;
+        dvalid         : in  std_logic := '0';
+        next_req       : out std_logic;
+        next_addr      : out std_logic_vector(ADDR_WIDTH-1 downto 0);
+        grant_port     : out integer range 0 to NUM_PORTS-1
+    );
+end component;
+
+constant NUM_PORTS  : integer := 2;
+constant ADDR_WIDTH : integer := 8;
+constant CLK_PERIOD : time    := 10 ns;
+
+-- One access of a round
+type op_type is record
+    used      : boolean;
+    wr_n      : std_logic;
+    addr      : integer;
+    data      : std_logic_vector(15 downto 0);
+    byte_en   : std_logic_vector(1 downto 0);
+    burst     : std_logic;
+    expect    : std_logic_vector(15 downto 0);  -- single read
+end record;
+type op_pair_type is array (0 to NUM_PORTS-1) of op_type;
+type round_list_type is array (natural range <>) of op_pair_type;
+
+-- Word written at addr by the fill rounds
+function data_of(a : integer) return std_logic_vector is
+begin
+    return std_logic_vector(to_unsigned(16#5A00# + a, 16));
+end function;
+
+constant NONE : op_type := (false, '1', 0, x"0000", "11", '0', x"0000");
+
+function wr(a : integer) return op_type is
+begin
+    return (true, '0', a, data_of(a), "11", '0', x"0000");
+end function;
+
+function rd(a : integer) return op_type is
+begin
+    return (true, '1', a, x"0000", "11", '0', data_of(a));
+end function;
+
+-- port 0 area: 0-63, port 1 area: 64-127
+constant ROUNDS : round_list_type := (
+    (wr(0),  wr(64)),
+    (wr(1),  NONE),
+    (wr(2),  wr(65)),
+    (NONE,   wr(66)),
+    (wr(3),  wr(67)),
+    ((true, '0', 3, x"FFEE", "01", '0', x"0000"), rd(64)),          -- low byte only
+    (rd(0),  (true, '1', 64, x"0000", "11", '1', x"0000")),         -- burst 64-67
+    ((true, '1', 3, x"0000", "11", '0', x"5AEE"), rd(67)),
+    (rd(1),  NONE),
+    (rd(2),  rd(66))
+);
+
+type log_type is array (0 to 63) of integer range 0 to NUM_PORTS-1;
+
+signal clk          : std_logic := '0';
+signal reset_n      : std_logic := '0';
+signal finished     : boolean   := false;
+
+-- clients <-> arbiter
+signal p_req        : std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+signal p_wr_n       : std_logic_vector(NUM_PORTS-1 downto 0) := (others => '1');
+signal p_addr       : std_logic_vector(NUM_PORTS*ADDR_WIDTH-1 downto 0) := (others => '0');
+signal p_din        : std_logic_vector(NUM_PORTS*16-1 downto 0) := (others => '0');
+signal p_byte_en    : std_logic_vector(NUM_PORTS*2-1 downto 0) := (others => '1');
+signal p_burst      : std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+signal p_dout       : std_logic_vector(15 downto 0);
+signal p_ready      : std_logic_vector(NUM_PORTS-1 downto 0);
+signal p_ack        : std_logic_vector(NUM_PORTS-1 downto 0);
+signal p_dvalid     : std_logic_vector(NUM_PORTS-1 downto 0);
+
+-- arbiter <-> controller model
+signal req          : std_logic;
+signal wr_n         : std_logic;
+signal addr         : std_logic_vector(ADDR_WIDTH-1 downto 0);
+signal din          : std_logic_vector(15 downto 0);
+signal dout         : std_logic_vector(15 downto 0) := (others => '0');
+signal byte_en      : std_logic_vector(1 downto 0);
+signal burst        : std_logic;
+signal ready        : std_logic := '0';
+signal ack          : std_logic := '0';
+signal dvalid       : std_logic := '0';
+signal grant_port   : integer range 0 to NUM_PORTS-1;
+
+-- director <-> clients
+signal cmd          : op_pair_type := (others => NONE);
+signal cmd_tgl      : std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+signal done_tgl     : std_logic_vector(NUM_PORTS-1 downto 0) := (others => '0');
+
+-- Checks
+signal order_log    : log_type := (others => 0);
+signal order_len    : integer := 0;
+signal fail         : std_logic_vector(0 to NUM_PORTS+1) := (others => '0');  -- clients, monitor, director
+
+begin
+
+    clk     <= not clk after CLK_PERIOD / 2 when not finished;
+    reset_n <= '1' after 5 * CLK_PERIOD;
+
+    dut : sdram_arbiter           generic map(NUM_PORTS      => NUM_PORTS,
+                                              ADDR_WIDTH     => ADDR_WIDTH,
+                                              ROUND_ROBIN    => ROUND_ROBIN)
+                                     port map(clk            => clk,
+                                              reset_n        => reset_n,
+                                              p_req          => p_req,
+                                              p_wr_n         => p_wr_n,
+                                              p_addr         => p_addr,
+                                              p_din          => p_din,
+                                              p_byte_en      => p_byte_en,
+                                              p_burst        => p_burst,
+                                              p_dout         => p_dout,
+                                              p_ready        => p_ready,
+                                              p_ack          => p_ack,
+                                              p_dvalid       => p_dvalid,
+                                              req            => req,
+                                              wr_n           => wr_n,
+                                              addr           => addr,
+                                              din            => din,
+                                              dout           => dout,
+                                              byte_en        => byte_en,
+                                              burst          => burst,
+                                              ready          => ready,
+                                              ack            => ack,
+                                              dvalid         => dvalid,
+                                              next_req       => open,
+                                              next_addr      => open,
+                                              grant_port     => grant_port);
+
+    --========================================
+    -- Controller model
+    --========================================
+    CONTROLLER_PROCESS: process(clk)
+        type mem_type is array (0 to 2**ADDR_WIDTH-1) of std_logic_vector(15 downto 0);
+        variable mem     : mem_type := (others => (others => '0'));
+        variable busy    : boolean := false;
+        variable count   : integer := 0;
+        variable beat    : integer := 0;
+        variable l_addr  : integer := 0;
+        variable l_wr_n  : std_logic := '1';
+        variable l_be    : std_logic_vector(1 downto 0) := "11";
+        variable l_din   : std_logic_vector(15 downto 0) := (others => '0');
+        variable l_burst : std_logic := '0';
+    begin
+        if rising_edge(clk) then
+            ack    <= '0';
+            dvalid <= '0';
+            if reset_n = '0' then
+                busy  := false;
+                ready <= '0';
+            elsif not busy then
+                ready <= '1';
+                if req = '1' then
+                    l_addr  := to_integer(unsigned(addr));
+                    l_wr_n  := wr_n;
+                    l_be    := byte_en;
+                    l_din   := din;
+                    l_burst := burst and wr_n;
+                    count   := LATENCY;
+                    beat    := 0;
+                    busy    := true;
+                    ready   <= '0';
+                    order_log(order_len) <= grant_port;
+                    order_len <= order_len + 1;
+                end if;
+            elsif count > 1 then
+                count := count - 1;
+            elsif l_wr_n = '0' then
+                if l_be(0) = '1' then mem(l_addr)(7 downto 0)  := l_din(7 downto 0);  end if;
+                if l_be(1) = '1' then mem(l_addr)(15 downto 8) := l_din(15 downto 8); end if;
+                ack   <= '1';
+                ready <= '1';
+                busy  := false;
+            elsif l_burst = '0' then
+                dout  <= mem(l_addr);
+                ack   <= '1';
+                ready <= '1';
+                busy  := false;
+            else
+                dout   <= mem((l_addr + beat) mod 2**ADDR_WIDTH);
+                dvalid <= '1';
+                beat   := beat + 1;
+                if beat = BURST_LENGTH then
+                    ack   <= '1';
+                    ready <= '1';
+                    busy  := false;
+                end if;
+            end if;
+        end if;
+    end process CONTROLLER_PROCESS;
+
+    --========================================
+    -- Clients
+    --========================================
+    clients : for i in 0 to NUM_PORTS-1 generate
+        CLIENT_PROCESS: process
+            variable o    : op_type;
+            variable beat : integer;
+        begin
+            wait until cmd_tgl(i) /= done_tgl(i);
+            o := cmd(i);
+            loop
+                wait until rising_edge(clk);
+                exit when p_ready(i) = '1';
+            end loop;
+            p_req(i)   <= '1';
+            p_wr_n(i)  <= o.wr_n;
+            p_burst(i) <= o.burst;
+            p_addr((i+1)*ADDR_WIDTH-1 downto i*ADDR_WIDTH) <= std_logic_vector(to_unsigned(o.addr, ADDR_WIDTH));
+            p_din((i+1)*16-1 downto i*16)                  <= o.data;
+            p_byte_en((i+1)*2-1 downto i*2)                <= o.byte_en;
+            beat := 0;
+            loop
+                wait until rising_edge(clk);
+                if p_dvalid(i) = '1' then
+                    if p_dout /= data_of(o.addr + beat) then
+                        report "sdram_arbiter_tb: port " & integer'image(i) & " burst beat " &
+                               integer'image(beat) & " read " & to_hstring(p_dout) severity error;
+                        fail(i) <= '1';
+                    end if;
+                    beat := beat + 1;
+                end if;
+                exit when p_ack(i) = '1';
+            end loop;
+            if o.wr_n = '1' and o.burst = '0' and p_dout /= o.expect then
+                report "sdram_arbiter_tb: port " & integer'image(i) & " read " & to_hstring(p_dout) &
+                       " at " & integer'image(o.addr) & ", expected " & to_hstring(o.expect) severity error;
+                fail(i) <= '1';
+            end if;
+            if o.burst = '1' and beat /= BURST_LENGTH then
+                report "sdram_arbiter_tb: port " & integer'image(i) & " got " &
+                       integer'image(beat) & " burst beats" severity error;
+                fail(i) <= '1';
+            end if;
+            p_req(i)    <= '0';
+            done_tgl(i) <= not done_tgl(i);
+        end process CLIENT_PROCESS;
+    end generate;
+
+    --========================================
+    -- Protocol monitor
+    --========================================
+    MONITOR_PROCESS: process(clk)
+        variable readies : integer;
+    begin
+        if rising_edge(clk) and reset_n = '1' then
+            readies := 0;
+            for i in 0 to NUM_PORTS-1 loop
+                if p_ready(i) = '1' then
+                    readies := readies + 1;
+                end if;
+                if (p_ack(i) = '1' or p_dvalid(i) = '1') and p_req(i) = '0' then
+                    report "sdram_arbiter_tb: ack / dvalid to idle port " & integer'image(i) severity error;
+                    fail(NUM_PORTS) <= '1';
+                end if;
+            end loop;
+            if readies > 1 and p_req /= (p_req'range => '0') then
+                report "sdram_arbiter_tb: p_ready to more than one port" severity error;
+                fail(NUM_PORTS) <= '1';
+            end if;
+        end if;
+    end process MONITOR_PROCESS;
+
+    --========================================
+    -- Rounds and expected grant order
+    --========================================
+    DIRECTOR_PROCESS: process
+        variable expected : log_type := (others => 0);
+        variable n        : integer  := 0;
+        variable last     : integer  := NUM_PORTS-1;   -- round-robin pointer
+        variable l        : line;
+        variable ok       : boolean;
+    begin
+        wait until reset_n = '1';
+        for k in 1 to 3 loop
+            wait until rising_edge(clk);
+        end loop;
+
+        for r in ROUNDS'range loop
+            -- expected order of this round
+            if ROUNDS(r)(0).used and ROUNDS(r)(1).used then
+                if ROUND_ROBIN and last = 0 then
+                    expected(n) := 1;  expected(n+1) := 0;  last := 0;
+                else
+                    expected(n) := 0;  expected(n+1) := 1;  last := 1;
+                end if;
+                n := n + 2;
+            else
+                for i in 0 to NUM_PORTS-1 loop
+                    if ROUNDS(r)(i).used then
+                        expected(n) := i;
+                        n    := n + 1;
+                        last := i;
+                    end if;
+                end loop;
+            end if;
+
+            -- start the accesses together, wait for both
+            for i in 0 to NUM_PORTS-1 loop
+                if ROUNDS(r)(i).used then
+                    cmd(i)     <= ROUNDS(r)(i);
+                    cmd_tgl(i) <= not cmd_tgl(i);
+                end if;
+            end loop;
+            wait for 0 ns;
+            wait until rising_edge(clk) and cmd_tgl = done_tgl for 1000 * CLK_PERIOD;
+            if cmd_tgl /= done_tgl then
+                report "sdram_arbiter_tb: round " & integer'image(r) & " never completed" severity error;
+                fail(NUM_PORTS+1) <= '1';
+                exit;
+            end if;
+        end loop;
+        wait until rising_edge(clk);
+
+        ok := order_len = n;
+        for i in 0 to n-1 loop
+            if order_log(i) /= expected(i) then
+                ok := false;
+            end if;
+        end loop;
+        if not ok then
+            report "sdram_arbiter_tb: grant order differs from the policy" severity error;
+            fail(NUM_PORTS+1) <= '1';
+        end if;
+        wait until rising_edge(clk);
+
+        write(l, string'("ARBITER round_robin=") & boolean'image(ROUND_ROBIN) & " order=");
+        for i in 0 to order_len-1 loop
+            write(l, integer'image(order_log(i)));
+        end loop;
+        write(l, string'(" expected="));
+        for i in 0 to n-1 loop
+            write(l, integer'image(expected(i)));
+        end loop;
+        if fail = (fail'range => '0') then
+            write(l, string'(" status=PASS"));
+        else
+            write(l, string'(" status=FAIL"));
+        end if;
+        writeline(output, l);
+
+        finished <= true;
+        std.env.finish;
+        wait;
+    end process DIRECTOR_PROCESS;
+
+end sim;
@@ -0,0 +1,549 @@
+--------------------------------------------------------------------------------
+-- Behavioral SDR SDRAM Model (simulation only)
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- SDRAM Model - Theory of Operation
+--------------------------------------------------------------------------------
+-- x16 SDR SDRAM, 4 banks, 2**ROW_BITS rows, 2**COL_BITS columns, as seen
+-- on the sdram_controller pins (IS42S16320F, IS42S16400F, H57V2562GTR,
+-- W9825G6KB: set ROW_BITS / COL_BITS like the board).
+--
+-- 1. Commands (sampled on the rising edge of clk = sdram_clk pin)
+--    - MRS: CAS latency (A6:A4), burst length (A2:A0), single write (A9)
+--    - ACT / PRE / PALL: open / close rows
+--    - READ / WRITE (A10 = auto-precharge), bursts wrap inside the BL
+--      block, a new READ / WRITE or BST cuts the running burst
+--    - REF: no data effect
+--
+-- 2. Read Data
+--    - The beat of edge n is driven after edge n+CL-1 + TAC and held
+--      until edge n+CL + TOH ('X' in between), then BOARD_DELAY is added
+--      for the PCB / PLL phase the controller sees on a real board
+--    - DQM masks read data with a 2 clock latency (byte lane 'Z')
+--    - Write data is masked by DQM of the same edge
+--
+-- 3. Storage
+--    - Rows are allocated on first write (a 32 MB chip costs nothing
+--      until used), unwritten words read as x"0000"
+--    - Preload: on the first edge with preload = '1' the data of the
+--      wozmon file PRELOAD_FILE is written behind the controller, byte
+--      address a at word a / 2 (even byte low), BANK_ROW_COL mapping;
+--      bytes below PRELOAD_SKIP are not SDRAM and are left out. The
+--      testbench raises preload once the trainer and the BIST are done
+--
+-- 4. Timing Checker (JEDEC SDR)
+--    Every command is checked against the generics (defaults: IS42S16320F
+--    -7, good for all the boards), a violation is reported with the
+--    last HISTORY commands and counted on the violations port:
+--    - tINIT  power-up: no command before TINIT_US
+--    - tRCD   ACT -> READ / WRITE, same bank
+--    - tRAS   ACT -> PRE, same bank (READA / WRITEA delay their
+--             internal precharge to tRAS like the chip)
+--    - tRC    ACT -> ACT, same bank
+--    - tRRD   ACT -> ACT, other bank
+--    - tRP    PRE -> ACT / REF / MRS (auto-precharge included)
+--    - tWR    last write beat -> PRE (WRITEA: internal precharge at
+--             last beat + tWR)
+--    - tRFC   REF -> any command
+--    - tMRD   MRS -> any command, in clocks
+--    - CL     MRS CAS latency must be 2 or 3 and the clock period at
+--             least TCK_CL2_NS / TCK_CL3_NS
+--    - tREFI  2**ROW_BITS refreshes every REFRESH_MS, counted from the
+--             first REF, at most MAX_REFRESH_DEBT may be owed
+--    - State: ACT to an open bank, READ / WRITE / PRE timing on a closed
+--             bank, REF / MRS with a bank open
+--
+-- 5. Boards (ROW_BITS / COL_BITS)
+--    DE10-Lite, DE1-SOC         13 / 10
+--    AX4010, QMTECH, MAX1000-16 13 / 9
+--    DE1, MAX1000-08            12 / 8
+--------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use std.textio.all;
+
+entity sdram_model is
+    generic (
+        ROW_BITS    : integer := 13;
+        COL_BITS    : integer := 10;
+        TAC         : time    := 5.4 ns;   -- access time from clock
+        TOH         : time    := 2.7 ns;   -- data hold from clock
+        BOARD_DELAY : time    := 4 ns;     -- added to the read data (PCB / clock phase)
+
+        -- Timing checker
+        TINIT_US         : integer := 100;    -- power-up wait
+        TRCD_NS          : integer := 15;
+        TRP_NS           : integer := 15;
+        TRAS_NS          : integer := 42;
+        TRC_NS           : integer := 60;
+        TRRD_NS          : integer := 14;
+        TWR_NS           : integer := 14;
+        TRFC_NS          : integer := 60;
+        TMRD_CLK         : integer := 2;
+        TCK_CL2_NS       : real    := 7.5;    -- shortest clock period at CAS latency 2
+        TCK_CL3_NS       : real    := 7.0;    -- shortest clock period at CAS latency 3
+        REFRESH_MS       : integer := 64;     -- all rows refreshed every REFRESH_MS
+        MAX_REFRESH_DEBT : integer := 8;
+        HISTORY          : integer := 16;     -- commands shown with a violation
+        LOG_COMMANDS     : boolean := false;  -- print every command
+
+        -- Preload (see 3.)
+        PRELOAD_FILE     : string  := "";     -- wozmon file ("0300: D8 A9 ...")
+        PRELOAD_SKIP     : integer := 0       -- bytes below this address left out
+    );
+    port (
+        clk         : in    std_logic;
+        cke         : in    std_logic;
+        cs_n        : in    std_logic;
+        ras_n       : in    std_logic;
+        cas_n       : in    std_logic;
+        we_n        : in    std_logic;
+        ba          : in    std_logic_vector(1 downto 0);
+        addr        : in    std_logic_vector(ROW_BITS-1 downto 0);
+        dq          : inout std_logic_vector(15 downto 0);
+        dqm         : in    std_logic_vector(1 downto 0);
+        preload     : in    std_logic := '0'; -- load PRELOAD_FILE (once)
+        violations  : out   natural := 0      -- timing checker errors
+    );
+end sdram_model;
+
+architecture behavioral of sdram_model is
+
+    constant CMD_BST   : std_logic_vector(3 downto 0) := "0110";
+    constant CMD_READ  : std_logic_vector(3 downto 0) := "0101";
+    constant CMD_WRITE : std_logic_vector(3 downto 0) := "0100";
+    constant CMD_ACT   : std_logic_vector(3 downto 0) := "0011";
+    constant CMD_PRE   : std_logic_vector(3 downto 0) := "0010";
+    constant CMD_REF   : std_logic_vector(3 downto 0) := "0001";
+    constant CMD_MRS   : std_logic_vector(3 downto 0) := "0000";
+
+    constant MAX_CL    : integer := 3;
+
+    type row_type  is array (0 to 2**COL_BITS-1) of std_logic_vector(15 downto 0);
+    type row_ptr   is access row_type;
+    type mem_type  is array (0 to 4 * 2**ROW_BITS - 1) of row_ptr;
+
+    type int4_type  is array (0 to 3) of integer;
+    type bool4_type is array (0 to 3) of boolean;
+
+    type beat_type is record
+        valid : boolean;
+        data  : std_logic_vector(15 downto 0);
+    end record;
+    type beat_line_type is array (0 to MAX_CL) of beat_type;
+
+    type time4_type is array (0 to 3) of time;
+    type history_type is array (0 to HISTORY-1) of line;
+
+    constant NEVER   : time := -1 sec;
+    constant TREFI   : time := REFRESH_MS * 1 ms / 2**ROW_BITS;
+
+    function cmd_name(cmd : std_logic_vector(3 downto 0); a10 : std_logic) return string is
+    begin
+        case cmd is
+            when CMD_MRS   => return "MRS";
+            when CMD_REF   => return "REF";
+            when CMD_ACT   => return "ACT";
+            when CMD_BST   => return "BST";
+            when CMD_PRE   =>
+                if a10 = '1' then return "PALL"; else return "PRE"; end if;
+            when CMD_READ  =>
+                if a10 = '1' then return "READA"; else return "READ"; end if;
+            when CMD_WRITE =>
+                if a10 = '1' then return "WRITEA"; else return "WRITE"; end if;
+            when others    => return "NOP";
+        end case;
+    end function;
+
+begin
+
+    process(clk)
+        variable mem        : mem_type;                          -- rows, allocated on write
+        variable open_row   : int4_type  := (others => 0);
+        variable is_open    : bool4_type := (others => false);
+        variable cl         : integer := 2;                      -- from MRS
+        variable bl         : integer := 1;
+        variable single_wr  : boolean := false;
+
+        -- running burst
+        variable rd_active  : boolean := false;
+        variable wr_active  : boolean := false;
+        variable b_bank     : integer := 0;
+        variable b_row      : integer := 0;
+        variable b_col      : integer := 0;                      -- column of the next beat
+        variable b_start    : integer := 0;                      -- first column of the BL block
+        variable b_left     : integer := 0;                      -- beats to go
+        variable b_ap       : boolean := false;                  -- auto-precharge at the end
+
+        variable pipe       : beat_line_type := (others => (false, (others => '0')));
+        variable dqm_prev   : std_logic_vector(1 downto 0) := "11";
+        variable cmd        : std_logic_vector(3 downto 0);
+        variable bank       : integer;
+        variable word       : std_logic_vector(15 downto 0);
+        variable beat       : beat_type;
+
+        -- timing checker
+        variable t_act      : time4_type := (others => NEVER);   -- last ACT
+        variable t_pre      : time4_type := (others => NEVER);   -- precharge start (PRE or auto)
+        variable t_wr       : time4_type := (others => NEVER);   -- last write beat
+        variable t_act_any  : time := NEVER;
+        variable t_ref      : time := NEVER;
+        variable t_edge     : time := NEVER;                     -- previous clock edge
+        variable mrd_left   : integer := 0;                      -- clocks to go after MRS
+        variable ref_on     : boolean := false;                  -- first REF seen
+        variable preloaded  : boolean := false;
+        variable ref_due    : time := 0 ns;
+        variable ref_debt   : integer := 0;
+        variable ref_late   : boolean := false;
+        variable errors     : natural := 0;
+        variable hist       : history_type;
+        variable hist_n     : natural := 0;                      -- commands recorded
+        variable entry      : line;
+
+        impure function rd(bk, rw, cl_n : integer) return std_logic_vector is
+        begin
+            if mem(bk * 2**ROW_BITS + rw) = null then
+                return x"0000";
+            end if;
+            return mem(bk * 2**ROW_BITS + rw)(cl_n);
+        end function;
+
+        procedure wr(bk, rw, cl_n : integer; d : std_logic_vector(15 downto 0); m : std_logic_vector(1 downto 0)) is
+            variable idx : integer;
+        begin
+            idx := bk * 2**ROW_BITS + rw;
+            if mem(idx) = null then
+                mem(idx) := new row_type'(others => x"0000");
+            end if;
+            if m(0) = '0' then
+                mem(idx)(cl_n)(7 downto 0)  := d(7 downto 0);
+            end if;
+            if m(1) = '0' then
+                mem(idx)(cl_n)(15 downto 8) := d(15 downto 8);
+            end if;
+        end procedure;
+
+        function hex_digit(c : character) return integer is
+        begin
+            case c is
+                when '0' to '9' => return character'pos(c) - character'pos('0');
+                when 'A' to 'F' => return character'pos(c) - character'pos('A') + 10;
+                when 'a' to 'f' => return character'pos(c) - character'pos('a') + 10;
+                when others     => return -1;
+            end case;
+        end function;
+
+        -- "0300: D8 A9", ": 01 20", "0300R": an address ends with ':' or
+        -- 'R', a 1 or 2 digit value is a data byte (same parser as the
+        -- RAM preload of Replica1_SIM)
+        procedure load_mon(name : string) is
+            file     f       : text;
+            variable status  : file_open_status;
+            variable l       : line;
+            variable a       : integer := 0;
+            variable w       : integer;
+            variable value   : integer;
+            variable digits  : integer;
+            variable c       : character;
+            variable skipped : integer := 0;
+        begin
+            file_open(status, f, name, read_mode);
+            if status /= open_ok then
+                report "sdram_model: cannot open " & name severity failure;
+            end if;
+            while not endfile(f) loop
+                readline(f, l);
+                value  := 0;
+                digits := 0;
+                for i in 1 to l'length + 1 loop
+                    if i <= l'length then
+                        c := l(i);
+                    else
+                        c := ' ';
+                    end if;
+                    if hex_digit(c) >= 0 then
+                        value  := value * 16 + hex_digit(c);
+                        digits := digits + 1;
+                    else
+                        if digits > 0 then
+                            if c = ':' or c = 'R' or c = 'r' or c = '.' or digits > 2 then
+                                a := value;
+                            elsif a < PRELOAD_SKIP then
+                                skipped := skipped + 1;
+                                a := a + 1;
+                            else
+                                w := a / 2;
+                                if a mod 2 = 0 then
+                                    wr(w / 2**(ROW_BITS + COL_BITS), (w / 2**COL_BITS) mod 2**ROW_BITS,
+                                       w mod 2**COL_BITS, x"00" & std_logic_vector(to_unsigned(value, 8)), "10");
+                                else
+                                    wr(w / 2**(ROW_BITS + COL_BITS), (w / 2**COL_BITS) mod 2**ROW_BITS,
+                                       w mod 2**COL_BITS, std_logic_vector(to_unsigned(value, 8)) & x"00", "01");
+                                end if;
+                                a := a + 1;
+                            end if;
+                        end if;
+                        value  := 0;
+                        digits := 0;
+                    end if;
+                end loop;
+                deallocate(l);
+            end loop;
+            file_close(f);
+            if skipped > 0 then
+                report "sdram_model: " & integer'image(skipped) & " bytes below " &
+                       integer'image(PRELOAD_SKIP) & " not preloaded" severity warning;
+            end if;
+        end procedure;
+
+        -- next column of the burst, wrapping inside the BL block
+        procedure advance is
+        begin
+            b_left := b_left - 1;
+            b_col  := b_start + ((b_col - b_start + 1) mod bl);
+            if b_left = 0 then
+                if b_ap then
+                    is_open(b_bank) := false;
+                    if wr_active then
+                        t_pre(b_bank) := now + TWR_NS * 1 ns;
+                    else
+                        t_pre(b_bank) := now;
+                    end if;
+                    if t_pre(b_bank) < t_act(b_bank) + TRAS_NS * 1 ns then
+                        t_pre(b_bank) := t_act(b_bank) + TRAS_NS * 1 ns;
+                    end if;
+                end if;
+                rd_active := false;
+                wr_active := false;
+            end if;
+        end procedure;
+
+        procedure violation(msg : string) is
+            variable l : line;
+        begin
+            errors     := errors + 1;
+            violations <= errors;
+            report "sdram_model: " & msg severity error;
+            write(l, string'("sdram_model: last commands"));
+            writeline(output, l);
+            for i in 0 to HISTORY-1 loop
+                if hist_n > HISTORY-1-i then
+                    write(l, string'("    ") & hist((hist_n + i) mod HISTORY).all);
+                    writeline(output, l);
+                end if;
+            end loop;
+        end procedure;
+
+        -- since must have elapsed between the event at t and now
+        procedure check(t : time; min : time; name : string) is
+        begin
+            if now - t < min then
+                violation(name & " violated: " & time'image(now - t) & " < " & time'image(min));
+            end if;
+        end procedure;
+
+    begin
+        if rising_edge(clk) then
+            if preload = '1' and not preloaded and PRELOAD_FILE /= "" then
+                load_mon(PRELOAD_FILE);
+                preloaded := true;
+            end if;
+
+            cmd  := cs_n & ras_n & cas_n & we_n;
+            bank := to_integer(unsigned(ba));
+            if cke = '0' or cs_n = '1' then
+                cmd := "0111";
+            end if;
+
+            -- Command stream
+            if cmd /= "0111" then
+                write(entry, time'image(now) & " " & cmd_name(cmd, addr(10)) &
+                             " ba=" & integer'image(bank) & " a=" & to_hstring(addr));
+                deallocate(hist(hist_n mod HISTORY));
+                hist(hist_n mod HISTORY) := new string'(entry.all);
+                hist_n := hist_n + 1;
+                if LOG_COMMANDS then
+                    writeline(output, entry);
+                end if;
+                deallocate(entry);
+            end if;
+
+            -- Timing checker
+            if ref_on then
+                while now >= ref_due loop
+                    ref_debt := ref_debt + 1;
+                    ref_due  := ref_due + TREFI;
+                end loop;
+                if ref_debt > MAX_REFRESH_DEBT and not ref_late then
+                    ref_late := true;
+                    violation("tREFI violated: " & integer'image(ref_debt) & " refreshes owed");
+                end if;
+            end if;
+
+            if cmd /= "0111" then
+                if now < TINIT_US * 1 us then
+                    violation("tINIT violated: command before " & integer'image(TINIT_US) & " us");
+                end if;
+                if mrd_left > 0 then
+                    violation("tMRD violated: command " & integer'image(TMRD_CLK - mrd_left) & " clocks after MRS");
+                end if;
+                check(t_ref, TRFC_NS * 1 ns, "tRFC");
+            end if;
+
+            case cmd is
+                when CMD_ACT =>
+                    if is_open(bank) then
+                        violation("ACT to bank " & integer'image(bank) & " with an open row");
+                    end if;
+                    check(t_pre(bank), TRP_NS * 1 ns, "tRP");
+                    check(t_act(bank), TRC_NS * 1 ns, "tRC");
+                    check(t_act_any,   TRRD_NS * 1 ns, "tRRD");
+                    t_act(bank) := now;
+                    t_act_any   := now;
+
+                when CMD_READ | CMD_WRITE =>
+                    if not is_open(bank) then
+                        violation(cmd_name(cmd, '0') & " to closed bank " & integer'image(bank));
+                    end if;
+                    check(t_act(bank), TRCD_NS * 1 ns, "tRCD");
+
+                when CMD_PRE =>
+                    for b in 0 to 3 loop
+                        if (addr(10) = '1' or b = bank) and is_open(b) then
+                            check(t_act(b), TRAS_NS * 1 ns, "tRAS");
+                            check(t_wr(b),  TWR_NS * 1 ns,  "tWR");
+                            t_pre(b) := now;
+                        end if;
+                    end loop;
+
+                when CMD_REF | CMD_MRS =>
+                    for b in 0 to 3 loop
+                        if is_open(b) then
+                            violation(cmd_name(cmd, '0') & " with bank " & integer'image(b) & " open");
+                        end if;
+                        check(t_pre(b), TRP_NS * 1 ns, "tRP");
+                    end loop;
+                    if cmd = CMD_REF then
+                        t_ref := now;
+                        if not ref_on then
+                            ref_on  := true;
+                            ref_due := now + TREFI;
+                        elsif ref_debt > -MAX_REFRESH_DEBT then
+                            ref_debt := ref_debt - 1;
+                        end if;
+                        if ref_debt <= MAX_REFRESH_DEBT then
+                            ref_late := false;
+                        end if;
+                    else
+                        case to_integer(unsigned(addr(6 downto 4))) is
+                            when 2 =>
+                                check(t_edge, TCK_CL2_NS * 1 ns, "tCK at CL2");
+                            when 3 =>
+                                check(t_edge, TCK_CL3_NS * 1 ns, "tCK at CL3");
+                            when others =>
+                                violation("CAS latency " & integer'image(to_integer(unsigned(addr(6 downto 4)))) & " not supported");
+                        end case;
+                    end if;
+
+                when others =>
+                    null;
+            end case;
+
+            if cmd = CMD_MRS then
+                mrd_left := TMRD_CLK - 1;
+            elsif mrd_left > 0 then
+                mrd_left := mrd_left - 1;
+            end if;
+            t_edge := now;
+
+            -- Commands
+            case cmd is
+                when CMD_MRS =>
+                    cl        := to_integer(unsigned(addr(6 downto 4)));
+                    bl        := 2 ** to_integer(unsigned(addr(2 downto 0)));
+                    single_wr := addr(9) = '1';
+
+                when CMD_ACT =>
+                    is_open(bank)  := true;
+                    open_row(bank) := to_integer(unsigned(addr));
+
+                when CMD_PRE =>
+                    if addr(10) = '1' then
+                        is_open := (others => false);
+                    else
+                        is_open(bank) := false;
+                    end if;
+
+                when CMD_READ | CMD_WRITE =>
+                    rd_active := cmd = CMD_READ;
+                    wr_active := cmd = CMD_WRITE;
+                    b_bank    := bank;
+                    b_row     := open_row(bank);
+                    b_col     := to_integer(unsigned(addr(COL_BITS-1 downto 0)));
+                    b_start   := (b_col / bl) * bl;
+                    b_ap      := addr(10) = '1';
+                    b_left    := bl;
+                    if cmd = CMD_WRITE and single_wr then
+                        b_left := 1;
+                    end if;
+
+                when CMD_BST =>
+                    rd_active := false;
+                    wr_active := false;
+
+                when others =>
+                    null;
+            end case;
+
+            -- Burst beats
+            beat := (false, (others => '0'));
+            if rd_active then
+                beat := (true, rd(b_bank, b_row, b_col));
+                advance;
+            elsif wr_active then
+                wr(b_bank, b_row, b_col, dq, dqm);
+                t_wr(b_bank) := now;
+                advance;
+            end if;
+
+            -- Read pipeline: the beat of this edge is valid at edge + cl
+            for i in MAX_CL downto 1 loop
+                pipe(i) := pipe(i-1);
+            end loop;
+            pipe(0) := beat;
+
+            -- Drive the beat valid at the next edge
+            dq <= transport (others => 'Z') after TOH + BOARD_DELAY;
+            if cl >= 1 and pipe(cl-1).valid then
+                word := pipe(cl-1).data;
+                if dqm_prev(0) = '1' then
+                    word(7 downto 0)  := (others => 'Z');
+                end if;
+                if dqm_prev(1) = '1' then
+                    word(15 downto 8) := (others => 'Z');
+                end if;
+                dq <= transport (others => 'X') after TOH + BOARD_DELAY;
+                dq <= transport word after TAC + BOARD_DELAY;
+            end if;
+            dqm_prev := dqm;
+        end if;
+    end process;
+
+end behavioral;
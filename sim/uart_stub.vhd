@@ -0,0 +1,202 @@
+--------------------------------------------------------------------------------
+-- UART Terminal Stub (simulation only)
+-- Copyright (c) 2026 Didier Derny
+--
+-- This work is licensed under the Creative Commons
+-- Attribution-NonCommercial-ShareAlike 4.0 International License.
+--
+-- You are free to:
+--   - Share: copy and redistribute the material
+--   - Adapt: remix, transform, and build upon the material
+--
+-- Under the following terms:
+--   - Attribution: You must give appropriate credit
+--   - NonCommercial: You may not use for commercial purposes
+--   - ShareAlike: Distribute derivatives under the same license
+--
+--
+-- Full license: https://creativecommons.org/licenses/by-nc-sa/4.0/
+--------------------------------------------------------------------------------
+-- UART Stub - Theory of Operation
+--------------------------------------------------------------------------------
+-- Plays the terminal on the pia_uart pins: types a .mon file into wozmon
+-- like a paste with a line delay, prints what the Replica 1 sends.
+--
+-- 1. Receive (core uart_tx)
+--    - 8N1 at BIT_TIME, sampled mid bit
+--    - Every byte increments rx_count and updates rx_last (echo and idle
+--      detection for the sender)
+--    - Printed line by line on the simulator console, prefixed "UART> "
+--
+-- 2. Send (core uart_rx)
+--    - Waits for the first CR of wozmon (the "\" prompt after reset)
+--    - MON_FILE line by line: every character waits for its echo (or
+--      ECHO_TIMEOUT), the CR is followed by an idle line (IDLE_CHARS
+--      character times without output) so wozmon has printed the
+--      address / data line before the next one
+--    - RUN_ONLY: only the lines with an 'R' (run command) are typed, the
+--      data is preloaded in the RAM by the testbench (fast load)
+--    - running goes to '1' when the echo of the CR of the last run line
+--      is back: the program starts
+--    - Then INPUT_FILE (if any) is typed the same way, for programs that
+--      read the keyboard, once their output has been idle (IDLE_CHARS):
+--      the program waits for a key, a character typed while it prints
+--      would be overwritten by the next one in the pia_uart
+--
+-- 3. Character Set
+--    - Lower case is sent as is (wozmon sets bit 7 itself), LF are not
+--      sent, the line end is CR like the Apple 1 keyboard
+--------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use std.textio.all;
+
+entity uart_stub is
+    generic (
+        MON_FILE     : string  := "";
+        INPUT_FILE   : string  := "";
+        RUN_ONLY     : boolean := false;    -- type only the run lines (data preloaded)
+        BIT_TIME     : time    := 8.68 us;  -- 115200 bauds
+        IDLE_CHARS   : integer := 4;        -- silent character times after a CR
+        ECHO_TIMEOUT : integer := 50        -- character times to wait for an echo
+    );
+    port (
+        tx           : out std_logic;       -- to core uart_rx
+        rx           : in  std_logic;       -- from core uart_tx
+        running      : out std_logic        -- '1' once the program is started
+    );
+end uart_stub;
+
+architecture behavioral of uart_stub is
+
+    constant CHAR_TIME : time := 10 * BIT_TIME;
+
+    signal rx_count    : natural := 0;      -- bytes received
+    signal rx_last     : time    := 0 ns;   -- time of the last byte
+    signal prompt      : boolean := false;  -- wozmon is up
+
+begin
+
+    --========================================
+    -- Receive and print
+    --========================================
+    RECEIVE: process
+        variable byte : std_logic_vector(7 downto 0);
+        variable l    : line := new string'("");
+        variable c    : character;
+    begin
+        wait until rx = '0';
+        wait for BIT_TIME + BIT_TIME / 2;
+        for i in 0 to 7 loop
+            byte(i) := rx;
+            wait for BIT_TIME;
+        end loop;
+        -- now in the middle of the stop bit
+
+        rx_count <= rx_count + 1;
+        rx_last  <= now;
+
+        c := character'val(to_integer(unsigned(byte and x"7F")));
+        if c = CR then
+            prompt <= true;
+            write(output, "UART> " & l.all & LF);
+            deallocate(l);
+            l := new string'("");
+        elsif c >= ' ' then
+            write(l, c);
+        end if;
+    end process RECEIVE;
+
+    --========================================
+    -- Type the files
+    --========================================
+    SEND: process
+        file     f      : text;
+        variable status : file_open_status;
+        variable l      : line;
+        variable count  : natural;
+        variable is_run : boolean;
+
+        procedure send_byte(b : std_logic_vector(7 downto 0)) is
+        begin
+            tx <= '0';
+            wait for BIT_TIME;
+            for i in 0 to 7 loop
+                tx <= b(i);
+                wait for BIT_TIME;
+            end loop;
+            tx <= '1';
+            wait for BIT_TIME;
+        end procedure;
+
+        procedure send_char(c : character) is
+        begin
+            count := rx_count;
+            send_byte(std_logic_vector(to_unsigned(character'pos(c), 8)));
+            if rx_count = count then
+                wait on rx_count for ECHO_TIMEOUT * CHAR_TIME;
+            end if;
+        end procedure;
+
+        procedure wait_idle is
+        begin
+            loop
+                wait for CHAR_TIME;
+                exit when now - rx_last >= IDLE_CHARS * CHAR_TIME;
+            end loop;
+        end procedure;
+
+        -- type the file, flag the start of the program after the last run line
+        procedure type_file(name : string; start : boolean) is
+        begin
+            file_open(status, f, name, read_mode);
+            if status /= open_ok then
+                report "uart_stub: cannot open " & name severity failure;
+            end if;
+            while not endfile(f) loop
+                readline(f, l);
+                is_run := false;
+                for i in 1 to l'length loop
+                    if l(i) = 'R' or l(i) = 'r' then
+                        is_run := true;
+                    end if;
+                end loop;
+                if l'length > 0 and (is_run or not RUN_ONLY or not start) then
+                    for i in 1 to l'length loop
+                        if l(i) /= CR and l(i) /= LF then
+                            send_char(l(i));
+                        end if;
+                    end loop;
+                    send_char(CR);
+                    if start and is_run then
+                        running <= '1';
+                    end if;
+                    wait_idle;
+                end if;
+                deallocate(l);
+            end loop;
+            file_close(f);
+        end procedure;
+
+    begin
+        tx      <= '1';
+        running <= '0';
+
+        wait until prompt;
+        wait_idle;
+
+        if MON_FILE /= "" then
+            type_file(MON_FILE, true);
+        end if;
+        running <= '1';
+
+        if INPUT_FILE /= "" then
+            wait_idle;
+            type_file(INPUT_FILE, false);
+        end if;
+        wait;
+    end process SEND;
+
+end behavioral;
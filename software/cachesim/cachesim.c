@@ -0,0 +1,699 @@
+// cachesim - trace driven model of sram_sdram_bridge + sdram_controller
+//
+// Replays a 6502 bus trace (one line per CPU cycle) through the cache of
+// the bridge and a clock model of the SDRAM controller, for every cache
+// geometry and write policy asked, and prints the hit rate and the
+// estimated CPU cycles (stretched clocks included) of each one.
+//
+// Trace formats (mixed freely, one access per line, '#' = comment):
+//   R E012 [data]       read
+//   F E012 [data]       opcode fetch (SYNC, also I), a read for the cache
+//   W E012 [data]       write
+//   E012 R [data]       same, address first ($ or 0x prefix accepted)
+//   12 E0 3F 01 00      bus_trace dump: the 5 entry bytes (+11 .. +15),
+//                       address low, high, data, flags (bit 0 = R/W), ext
+//
+// Every line is one CPU cycle; only the accesses inside --window go to the
+// bridge, the others (EBR RAM, ROM, I/O) cost one cycle.
+//
+// Cache model (sram_sdram_bridge):
+//   - CACHE_SIZE_BYTES / LINE_SIZE_BYTES / ASSOCIATIVITY, tree pseudo-LRU,
+//     an invalid way first
+//   - --split: SPLIT_ID, opcode fetches allocate in the low half of the
+//     ways, data in the high half (2 and 4 ways, shown as 2s / 4s)
+//   - --prefetch=N: PREFETCH_BYTES, an access in the last N bytes of a
+//     line fetches the next line once the SDRAM is idle (0 = PREFETCH off)
+//   - wt:  write-through / no-allocate, CPU waits for the SDRAM write
+//   - wtb: write-through with the posted write buffer (--wbuf entries),
+//          read misses wait for the buffer to drain
+//   - wb:  write-back / write-allocate, dirty lines written back before
+//          the fill that replaces them
+//   - line fill critical word first, the CPU is released on its word,
+//     hits to the line being filled wait for their word
+//   - off: USE_CACHE = false, every access goes to the SDRAM
+//
+// Controller model (sdram_controller, clocks of sdram_clk):
+//   - request handshake           REQ_CLOCKS
+//   - open row (default, DE10-Lite): same row: READ / WRITE only
+//                                 idle bank: ACT + tRCD
+//                                 other row: PRE + tRP + ACT + tRCD
+//   - --auto-precharge:           ACT + tRCD every time, + tRP after
+//   - read: READ + CAS_LATENCY + 1, a burst adds one clock per word
+//   - write: WRITE + 1 (+ tWR + tRP with auto-precharge)
+//   - refreshes are not counted: the controller runs them in the CPU idle
+//     time (refresh_ok)
+//
+// CPU model (cpu_clock_gen): phi1 then phi2, the bridge sees E rise
+// SYNC_CLOCKS sdram clocks after the middle of the cycle and the data must
+// be there at the end of phi2, else the cycle is stretched by whole
+// main_clk (4 x phi2) clocks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#define MAX_LINE_LENGTH 256
+#define MAX_LIST        16
+#define MAX_WORDS       32       // 64-byte lines
+#define MAX_WBUF        8
+
+#define REQ_CLOCKS      2        // bridge req -> controller command
+#define SYNC_CLOCKS     3        // E synchronized into sdram_clk
+
+enum { POLICY_OFF, POLICY_WT, POLICY_WTB, POLICY_WB };
+static const char *policy_name[] = { "off", "wt", "wtb", "wb" };
+
+typedef struct {
+    unsigned short addr;
+    unsigned char  write;
+    unsigned char  fetch;
+} access_t;
+
+typedef struct {
+    int size, line, ways, split, prefetch, policy, burst;
+} config_t;
+
+typedef struct {
+    config_t cfg;
+    long   reads, read_hits, read_misses;
+    long   fetches, fetch_hits;
+    long   prefetches, prefetch_hits;
+    long   writes, write_hits;
+    long   sdram_reads, sdram_writes, activates, row_hits;
+    long   stall_clocks;         // main_clk clocks
+    double cycles;               // CPU cycles
+} result_t;
+
+// Options
+static unsigned window_lo = 0xE000, window_hi = 0xEFFF;
+static int    sdram_mhz    = 120;
+static double cpu_mhz      = 10.0;
+static int    cas_latency  = 2;
+static int    trcd_ns = 20, trp_ns = 20, twr_clk = 2;
+static int    open_row_mode = 1;
+static int    row_bits = 13, col_bits = 10;
+static int    wbuf_depth = 4;
+
+static access_t *trace;
+static long      trace_len, trace_cap;
+
+//========================================
+// Trace
+//========================================
+
+static int hex_value(const char *s, unsigned *value) {
+    unsigned v = 0;
+    int digits = 0;
+
+    if (*s == '$')
+        s++;
+    else if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        s += 2;
+    while (isxdigit((unsigned char)*s)) {
+        v = (v << 4) | (unsigned)(isdigit((unsigned char)*s) ? *s - '0' : toupper((unsigned char)*s) - 'A' + 10);
+        s++;
+        digits++;
+    }
+    if (digits == 0 || *s != 0)
+        return -1;
+    *value = v;
+    return digits;
+}
+
+static void add_access(unsigned addr, int write, int fetch) {
+    if (trace_len == trace_cap) {
+        trace_cap = trace_cap ? trace_cap * 2 : 65536;
+        trace = realloc(trace, trace_cap * sizeof(access_t));
+        if (trace == NULL) {
+            fprintf(stderr, "cachesim: out of memory\n");
+            exit(1);
+        }
+    }
+    trace[trace_len].addr  = (unsigned short)addr;
+    trace[trace_len].write = (unsigned char)write;
+    trace[trace_len].fetch = (unsigned char)fetch;
+    trace_len++;
+}
+
+static void read_trace(FILE *f, const char *name) {
+    char line[MAX_LINE_LENGTH];
+    char *tok[8];
+    unsigned value[8];
+    int digits[8];
+    long number = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        int n = 0, i, op = -1, fetch = 0, addr = -1;
+        char *p = strchr(line, '#');
+
+        number++;
+        if (p)
+            *p = 0;
+        for (p = strtok(line, " \t\r\n:,"); p && n < 8; p = strtok(NULL, " \t\r\n:,"))
+            tok[n++] = p;
+        if (n == 0)
+            continue;
+        for (i = 0; i < n; i++)
+            digits[i] = hex_value(tok[i], &value[i]);
+
+        // bus_trace dump: 5 bytes
+        if (n == 5) {
+            for (i = 0; i < 5 && digits[i] > 0 && digits[i] <= 2; i++)
+                ;
+            if (i == 5) {
+                add_access(value[0] | (value[1] << 8), (value[3] & 1) == 0, 0);
+                continue;
+            }
+        }
+
+        // R / W / F and an address
+        for (i = 0; i < n; i++) {
+            if (strlen(tok[i]) == 1 && strchr("RrWwFfIi", tok[i][0]) && op < 0) {
+                op    = (toupper((unsigned char)tok[i][0]) == 'W');
+                fetch = strchr("FfIi", tok[i][0]) != NULL;
+            }
+            else if (digits[i] >= 3 && digits[i] <= 4 && addr < 0)
+                addr = (int)value[i];
+        }
+        if (op < 0 || addr < 0) {
+            fprintf(stderr, "cachesim: %s:%ld: not an access, skipped\n", name, number);
+            continue;
+        }
+        add_access((unsigned)addr, op, fetch);
+    }
+}
+
+//========================================
+// SDRAM controller
+//========================================
+
+static int open_row[4];
+
+static int ns_clocks(int ns) {
+    return (ns * sdram_mhz + 999) / 1000;
+}
+
+// Clocks to open the row of a word address, updates the open rows
+static int row_clocks(unsigned waddr, result_t *r) {
+    int row  = (int)((waddr >> col_bits) & ((1u << row_bits) - 1));
+    int bank = (int)((waddr >> (col_bits + row_bits)) & 3);
+    int clocks = 0;
+
+    if (open_row_mode && open_row[bank] == row) {
+        r->row_hits++;
+        return 0;
+    }
+    if (open_row_mode && open_row[bank] >= 0)
+        clocks += 1 + ns_clocks(trp_ns);       // PRE + tRP
+    open_row[bank] = row;
+    r->activates++;
+    return clocks + 1 + ns_clocks(trcd_ns);    // ACT + tRCD
+}
+
+// One request: clocks until the first word / the ack, clocks until the
+// controller is idle again
+static void sdram_request(unsigned waddr, int write, int words, result_t *r,
+                          double *first, double *total) {
+    double t = REQ_CLOCKS + row_clocks(waddr, r);
+
+    if (write) {
+        r->sdram_writes++;
+        t += 2;                                // WRITE + ack
+        *first = t;
+        if (!open_row_mode)
+            t += twr_clk + ns_clocks(trp_ns);
+    } else {
+        r->sdram_reads++;
+        t += 1 + cas_latency + 1;              // READ + CL + sample
+        *first = t;
+        t += words - 1;                        // burst beats
+        if (!open_row_mode)
+            t += ns_clocks(trp_ns);
+    }
+    *total = t;
+}
+
+//========================================
+// Bridge
+//========================================
+
+typedef struct {
+    int valid, dirty;
+    int prefetched;              // not used since the prefetch
+    unsigned tag;
+} line_t;
+
+static line_t        *lines;
+static unsigned char *plru;
+
+// split: only the half of the ways of the access (fetch low, data high)
+static int victim(int set, int ways, int split, int fetch) {
+    int w, first = 0, last = ways - 1;
+    unsigned char b = plru[set];
+
+    if (split) {
+        if (fetch)
+            last = ways / 2 - 1;
+        else
+            first = ways / 2;
+    }
+    for (w = first; w <= last; w++)
+        if (!lines[set * ways + w].valid)
+            return w;
+    if (ways == 2)
+        return split ? first : b & 1;
+    if (ways == 4) {
+        int high = split ? !fetch : (b & 1);
+        return high ? ((b & 4) ? 3 : 2) : ((b & 2) ? 1 : 0);
+    }
+    return 0;
+}
+
+static void touch(int set, int ways, int way) {
+    unsigned char *b = &plru[set];
+
+    if (ways == 2)
+        *b = (way == 0);
+    else if (ways == 4) {
+        *b = (unsigned char)((*b & ~1) | (way < 2));
+        if (way < 2)
+            *b = (unsigned char)((*b & ~2) | ((way == 0) << 1));
+        else
+            *b = (unsigned char)((*b & ~4) | ((way == 2) << 2));
+    }
+}
+
+static int log2i(int n) {
+    int bits = 0;
+    while ((1 << bits) < n)
+        bits++;
+    return bits;
+}
+
+static void run(const config_t *cfg, result_t *r) {
+    double cycle   = sdram_mhz / cpu_mhz;      // sdram clocks per CPU cycle
+    double quarter = cycle / 4;                // one main_clk clock
+    int line_words = cfg->line / 2;
+    int fill_burst = cfg->burst > line_words ? 1 : cfg->burst;
+    int sets       = cfg->policy == POLICY_OFF ? 1 : cfg->size / cfg->line / cfg->ways;
+    int offset_bits = log2i(cfg->line), index_bits = log2i(sets);
+    unsigned mask  = window_hi - window_lo;
+    double now = 0, busy = 0;                  // CPU cycle start, controller busy until
+    double wbuf[MAX_WBUF];                     // completion of the posted writes
+    int wbuf_n = 0;
+    int fill_line[2] = { -1, -1 };             // last demand fill, last prefetch
+    double fill_time[2][MAX_WORDS];            // word ready times of both
+    long i;
+    int b, f;
+
+    memset(r, 0, sizeof(*r));
+    r->cfg = *cfg;
+    for (b = 0; b < 4; b++)
+        open_row[b] = -1;
+    lines = calloc((size_t)sets * cfg->ways, sizeof(line_t));
+    plru  = calloc((size_t)sets, 1);
+
+    for (i = 0; i < trace_len; i++) {
+        unsigned a = trace[i].addr;
+        int write = trace[i].write;
+        int fetch = trace[i].fetch;
+        double start = now + cycle / 2 + SYNC_CLOCKS;   // bridge sees the access
+        double deadline = now + cycle;                  // end of phi2
+        double ready = start;                           // data / write done
+        double first, total;
+
+        now += cycle;
+        if (a < window_lo || a > window_hi)
+            continue;
+        a &= mask;
+
+        // drop the posted writes done by now
+        while (wbuf_n > 0 && wbuf[0] <= start) {
+            memmove(wbuf, wbuf + 1, (size_t)(wbuf_n - 1) * sizeof(double));
+            wbuf_n--;
+        }
+
+        if (cfg->policy == POLICY_OFF) {
+            if (write)
+                r->writes++;
+            else
+                r->reads++, r->read_misses++;
+            start = start > busy ? start : busy;
+            sdram_request(a >> 1, write, 1, r, &first, &total);
+            ready = start + first;
+            busy  = start + total;
+        } else {
+            unsigned blk = a >> offset_bits;
+            int set = (int)(blk & (unsigned)(sets - 1));
+            unsigned tag = blk >> index_bits;
+            line_t *set_lines = &lines[set * cfg->ways];
+            int way, hit = -1;
+
+            for (way = 0; way < cfg->ways; way++)
+                if (set_lines[way].valid && set_lines[way].tag == tag)
+                    hit = way;
+
+            if (write)
+                r->writes++;
+            else
+                r->reads++;
+            if (fetch)
+                r->fetches++;
+
+            if (hit >= 0 && (!write || cfg->policy == POLICY_WB)) {
+                // read hit, write-back write hit
+                int line_no = set * cfg->ways + hit;
+                if (write)
+                    r->write_hits++, set_lines[hit].dirty = 1;
+                else
+                    r->read_hits++;
+                if (fetch)
+                    r->fetch_hits++;
+                if (set_lines[hit].prefetched)
+                    r->prefetch_hits++, set_lines[hit].prefetched = 0;
+                touch(set, cfg->ways, hit);
+                for (f = 0; f < 2; f++)
+                    if (line_no == fill_line[f]) {
+                        double w = fill_time[f][(a >> 1) & (unsigned)(line_words - 1)];
+                        if (w > ready)
+                            ready = w;
+                    }
+            } else if (write && cfg->policy != POLICY_WB) {
+                // write-through, hit updates the line too (no allocate)
+                if (hit >= 0) {
+                    r->write_hits++;
+                    touch(set, cfg->ways, hit);
+                }
+                if (cfg->policy == POLICY_WTB) {
+                    double s;
+                    if (wbuf_n == wbuf_depth) {         // full: wait for the oldest
+                        ready = wbuf[0];
+                        memmove(wbuf, wbuf + 1, (size_t)(wbuf_n - 1) * sizeof(double));
+                        wbuf_n--;
+                    }
+                    s = busy > ready ? busy : ready;
+                    sdram_request(a >> 1, 1, 1, r, &first, &total);
+                    busy = s + total;
+                    wbuf[wbuf_n++] = busy;
+                } else {
+                    start = start > busy ? start : busy;
+                    sdram_request(a >> 1, 1, 1, r, &first, &total);
+                    ready = start + first;
+                    busy  = start + total;
+                }
+            } else {
+                // read miss, write-back write miss: line fill
+                int v = victim(set, cfg->ways, cfg->split, fetch);
+                unsigned word = (a >> 1) & (unsigned)(line_words - 1);
+                unsigned base = (a >> 1) & ~(unsigned)(line_words - 1);
+                double t;
+                int k;
+
+                if (!write)
+                    r->read_misses++;
+                start = start > busy ? start : busy;
+                if (wbuf_n > 0 && wbuf[wbuf_n - 1] > start)
+                    start = wbuf[wbuf_n - 1];           // drain the posted writes
+                wbuf_n = 0;
+                t = start;
+
+                if (set_lines[v].valid && set_lines[v].dirty) {
+                    unsigned old = ((set_lines[v].tag << index_bits) | (unsigned)set) << (offset_bits - 1);
+                    for (k = 0; k < line_words; k++) {
+                        sdram_request(old + (unsigned)k, 1, 1, r, &first, &total);
+                        t += total;
+                    }
+                }
+
+                // critical word first, wrapping inside the burst block
+                for (k = 0; k < line_words; k += fill_burst) {
+                    unsigned w = (word + (unsigned)k) & (unsigned)(line_words - 1);
+                    int j;
+                    sdram_request(base + w, 0, fill_burst, r, &first, &total);
+                    for (j = 0; j < fill_burst; j++) {
+                        unsigned wj = (w & ~(unsigned)(fill_burst - 1)) | ((w + (unsigned)j) & (unsigned)(fill_burst - 1));
+                        fill_time[0][wj] = t + first + j;
+                    }
+                    t += total;
+                }
+                ready = fill_time[0][word] + (write ? 1 : 0);
+                busy  = t;
+
+                set_lines[v].valid = 1;
+                set_lines[v].dirty = write;
+                set_lines[v].tag   = tag;
+                set_lines[v].prefetched = 0;
+                touch(set, cfg->ways, v);
+                fill_line[0] = set * cfg->ways + v;
+                if (fill_line[1] == fill_line[0])
+                    fill_line[1] = -1;
+            }
+
+            // next-line prefetch, started when the SDRAM is idle again
+            if (cfg->prefetch && (!write || cfg->policy == POLICY_WB) &&
+                (a & (unsigned)(cfg->line - 1)) >= (unsigned)(cfg->line - cfg->prefetch)) {
+                unsigned nblk = (blk + 1) & (mask >> offset_bits);
+                int nset = (int)(nblk & (unsigned)(sets - 1));
+                unsigned ntag = nblk >> index_bits;
+                line_t *next = &lines[nset * cfg->ways];
+                int present = 0, v;
+
+                for (way = 0; way < cfg->ways; way++)
+                    if (next[way].valid && next[way].tag == ntag)
+                        present = 1;
+                v = victim(nset, cfg->ways, cfg->split, fetch);
+                if (!present && !(next[v].valid && next[v].dirty)) {
+                    unsigned base = nblk << (offset_bits - 1);
+                    double t = busy > ready ? busy : ready;
+                    int k;
+
+                    if (wbuf_n > 0 && wbuf[wbuf_n - 1] > t)
+                        t = wbuf[wbuf_n - 1];
+                    for (k = 0; k < line_words; k += fill_burst) {
+                        int j;
+                        sdram_request(base + (unsigned)k, 0, fill_burst, r, &first, &total);
+                        for (j = 0; j < fill_burst; j++)
+                            fill_time[1][k + j] = t + first + j;
+                        t += total;
+                    }
+                    busy = t;
+                    next[v].valid = 1;
+                    next[v].dirty = 0;
+                    next[v].tag   = ntag;
+                    next[v].prefetched = 1;
+                    touch(nset, cfg->ways, v);
+                    fill_line[1] = nset * cfg->ways + v;
+                    if (fill_line[0] == fill_line[1])
+                        fill_line[0] = -1;
+                    r->prefetches++;
+                }
+            }
+        }
+
+        if (ready > deadline) {
+            long stall = (long)ceil((ready - deadline) / quarter);
+            r->stall_clocks += stall;
+            now += stall * quarter;
+        }
+    }
+    r->cycles = (double)trace_len + r->stall_clocks / 4.0;
+    free(lines);
+    free(plru);
+}
+
+//========================================
+// Options
+//========================================
+
+static int parse_list(const char *s, int *list) {
+    int n = 0;
+    while (*s && n < MAX_LIST) {
+        list[n++] = atoi(s);
+        while (*s && *s != ',')
+            s++;
+        if (*s == ',')
+            s++;
+    }
+    return n;
+}
+
+static int parse_policies(const char *s, int *list) {
+    int n = 0, p;
+    char buf[MAX_LINE_LENGTH], *tok;
+
+    strncpy(buf, s, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    for (tok = strtok(buf, ","); tok && n < MAX_LIST; tok = strtok(NULL, ",")) {
+        for (p = POLICY_WT; p <= POLICY_WB; p++)
+            if (strcmp(tok, policy_name[p]) == 0)
+                list[n++] = p;
+    }
+    return n;
+}
+
+// fastest first, then fewest misses, then smallest cache
+static int by_cycles(const void *a, const void *b) {
+    const result_t *ra = a, *rb = b;
+
+    if (ra->cycles != rb->cycles)
+        return ra->cycles < rb->cycles ? -1 : 1;
+    if (ra->read_misses != rb->read_misses)
+        return ra->read_misses < rb->read_misses ? -1 : 1;
+    return ra->cfg.size - rb->cfg.size;
+}
+
+void print_usage(const char *program_name) {
+    printf("Usage: %s [options] trace...   (- = stdin)\n", program_name);
+    printf("Sweep:\n");
+    printf("  --size=512,1024,...   CACHE_SIZE_BYTES  (512,1024,2048,4096,8192)\n");
+    printf("  --line=8,16,32        LINE_SIZE_BYTES   (8,16,32)\n");
+    printf("  --ways=1,2,4          ASSOCIATIVITY     (1,2,4)\n");
+    printf("  --policy=wt,wtb,wb    write policy      (wt,wtb,wb)\n");
+    printf("  --split               also SPLIT_ID (fetch / data ways) for 2 and 4 ways\n");
+    printf("  --prefetch=0,4,...    PREFETCH_BYTES, 0 = no prefetch (0)\n");
+    printf("  --burst=N             BURST_LENGTH 1, 4 or 8 (1)\n");
+    printf("  --max-bytes=N         skip caches larger than N bytes\n");
+    printf("System:\n");
+    printf("  --window=E000-EFFF    addresses behind the bridge\n");
+    printf("  --sdram-mhz=120       --cpu-mhz=10    --cas=2\n");
+    printf("  --trcd=20 --trp=20    ns              --wbuf=4 (posted writes)\n");
+    printf("  --auto-precharge      USE_AUTO_PRECHARGE = true (default open row)\n");
+    printf("  --rows=13 --cols=10   ROW_BITS / COL_BITS\n");
+    printf("Output:\n");
+    printf("  --top=N               best N configurations (20, 0 = all)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int sizes[MAX_LIST] = { 512, 1024, 2048, 4096, 8192 }, n_sizes = 5;
+    int line_sizes[MAX_LIST] = { 8, 16, 32 }, n_lines = 3;
+    int ways[MAX_LIST] = { 1, 2, 4 }, n_ways = 3;
+    int policies[MAX_LIST] = { POLICY_WT, POLICY_WTB, POLICY_WB }, n_policies = 3;
+    int prefetch[MAX_LIST] = { 0 }, n_prefetch = 1;
+    int burst = 1, max_bytes = 0, top = 20, files = 0, split = 0;
+    int s, l, w, p, d, f, i;
+    unsigned lo, hi;
+    long n_results = 0, window_accesses = 0;
+    result_t *results, base;
+    config_t cfg;
+
+    for (i = 1; i < argc; i++) {
+        char *a = argv[i];
+        if      (strncmp(a, "--size=", 7) == 0)      n_sizes = parse_list(a + 7, sizes);
+        else if (strncmp(a, "--line=", 7) == 0)      n_lines = parse_list(a + 7, line_sizes);
+        else if (strncmp(a, "--ways=", 7) == 0)      n_ways = parse_list(a + 7, ways);
+        else if (strncmp(a, "--policy=", 9) == 0)    n_policies = parse_policies(a + 9, policies);
+        else if (strncmp(a, "--prefetch=", 11) == 0) n_prefetch = parse_list(a + 11, prefetch);
+        else if (strncmp(a, "--burst=", 8) == 0)     burst = atoi(a + 8);
+        else if (strncmp(a, "--max-bytes=", 12) == 0) max_bytes = atoi(a + 12);
+        else if (strncmp(a, "--sdram-mhz=", 12) == 0) sdram_mhz = atoi(a + 12);
+        else if (strncmp(a, "--cpu-mhz=", 10) == 0)  cpu_mhz = atof(a + 10);
+        else if (strncmp(a, "--cas=", 6) == 0)       cas_latency = atoi(a + 6);
+        else if (strncmp(a, "--trcd=", 7) == 0)      trcd_ns = atoi(a + 7);
+        else if (strncmp(a, "--trp=", 6) == 0)       trp_ns = atoi(a + 6);
+        else if (strncmp(a, "--wbuf=", 7) == 0)      wbuf_depth = atoi(a + 7);
+        else if (strncmp(a, "--rows=", 7) == 0)      row_bits = atoi(a + 7);
+        else if (strncmp(a, "--cols=", 7) == 0)      col_bits = atoi(a + 7);
+        else if (strncmp(a, "--top=", 6) == 0)       top = atoi(a + 6);
+        else if (strcmp(a, "--auto-precharge") == 0) open_row_mode = 0;
+        else if (strcmp(a, "--split") == 0)          split = 1;
+        else if (strncmp(a, "--window=", 9) == 0) {
+            if (sscanf(a + 9, "%x-%x", &lo, &hi) != 2 || lo > hi || hi > 0xFFFF) {
+                fprintf(stderr, "cachesim: bad window %s\n", a + 9);
+                return 1;
+            }
+            window_lo = lo;
+            window_hi = hi;
+        } else if (strcmp(a, "-") == 0) {
+            read_trace(stdin, "stdin");
+            files++;
+        } else if (a[0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            FILE *f = fopen(a, "r");
+            if (f == NULL) {
+                perror(a);
+                return 1;
+            }
+            read_trace(f, a);
+            fclose(f);
+            files++;
+        }
+    }
+    if (files == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (wbuf_depth < 1 || wbuf_depth > MAX_WBUF || (burst != 1 && burst != 4 && burst != 8)) {
+        fprintf(stderr, "cachesim: --wbuf 1 to %d, --burst 1, 4 or 8\n", MAX_WBUF);
+        return 1;
+    }
+    if (((window_hi - window_lo + 1) & (window_hi - window_lo)) != 0 || (window_lo & (window_hi - window_lo)) != 0) {
+        fprintf(stderr, "cachesim: the window must be a power of two, aligned (like sram_addr)\n");
+        return 1;
+    }
+
+    for (i = 0; i < trace_len; i++)
+        if (trace[i].addr >= window_lo && trace[i].addr <= window_hi)
+            window_accesses++;
+
+    printf("trace: %ld cycles, %ld in $%04X-$%04X\n", trace_len, window_accesses, window_lo, window_hi);
+    printf("sdram: %d MHz CL%d tRCD %d ns tRP %d ns %s, burst %d, cpu %.2f MHz\n\n",
+           sdram_mhz, cas_latency, trcd_ns, trp_ns,
+           open_row_mode ? "open row" : "auto-precharge", burst, cpu_mhz);
+
+    // no cache reference
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.policy = POLICY_OFF;
+    cfg.burst  = 1;
+    run(&cfg, &base);
+
+    results = calloc((size_t)(n_sizes * n_lines * n_ways * n_policies * 2 * n_prefetch), sizeof(result_t));
+    for (s = 0; s < n_sizes; s++)
+        for (l = 0; l < n_lines; l++)
+            for (w = 0; w < n_ways; w++)
+                for (p = 0; p < n_policies; p++)
+                    for (d = 0; d <= split; d++)
+                        for (f = 0; f < n_prefetch; f++) {
+                            cfg.size     = sizes[s];
+                            cfg.line     = line_sizes[l];
+                            cfg.ways     = ways[w];
+                            cfg.split    = d;
+                            cfg.prefetch = prefetch[f];
+                            cfg.policy   = policies[p];
+                            cfg.burst    = burst;
+                            // bridge geometry limits
+                            if ((cfg.size & (cfg.size - 1)) || (cfg.line & (cfg.line - 1)) ||
+                                cfg.line < 4 || cfg.line > 2 * MAX_WORDS ||
+                                (cfg.ways != 1 && cfg.ways != 2 && cfg.ways != 4) ||
+                                (cfg.split && cfg.ways == 1) ||
+                                cfg.prefetch < 0 || cfg.prefetch > cfg.line ||
+                                cfg.line * cfg.ways > cfg.size ||
+                                (unsigned)cfg.size > window_hi - window_lo ||
+                                (max_bytes && cfg.size > max_bytes))
+                                continue;
+                            run(&cfg, &results[n_results++]);
+                        }
+    qsort(results, (size_t)n_results, sizeof(result_t), by_cycles);
+
+    printf(" size line ways pf policy  rd hit%%  if hit%%  rd miss   writes  pf used%%  activates  stall clk       cycles  speedup\n");
+    for (i = -1; i < n_results && (top == 0 || i < top); i++) {
+        result_t *r = i < 0 ? &base : &results[i];
+        double hit  = r->reads ? 100.0 * r->read_hits / r->reads : 0;
+        double ihit = r->fetches ? 100.0 * r->fetch_hits / r->fetches : 0;
+        double used = r->prefetches ? 100.0 * r->prefetch_hits / r->prefetches : 0;
+        if (r->cfg.policy == POLICY_OFF)
+            printf("    -    -    -  - %-6s", policy_name[r->cfg.policy]);
+        else
+            printf("%5d %4d %3d%c %2d %-6s", r->cfg.size, r->cfg.line, r->cfg.ways,
+                   r->cfg.split ? 's' : ' ', r->cfg.prefetch, policy_name[r->cfg.policy]);
+        printf(" %7.1f %7.1f %8ld %8ld %8.1f %10ld %10ld %12.0f %8.3f\n",
+               hit, ihit, r->read_misses, r->writes, used, r->activates, r->stall_clocks,
+               r->cycles, base.cycles / r->cycles);
+    }
+    free(results);
+    free(trace);
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * File: include/cache.h
+ * SDRAM Cache Control Registers (rtl/sdram/cache_ctrl.vhd)
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+/* Cache control register addresses */
+#define CACHE_CONTROL     ((volatile unsigned char*)0xC250)  /* Enable / busy     */
+#define CACHE_COMMAND     ((volatile unsigned char*)0xC251)  /* Command           */
+#define CACHE_ADDR        ((volatile unsigned int*)0xC252)   /* Line / range start */
+#define CACHE_HITS        ((volatile unsigned char*)0xC254)  /* 32-bit, +0 first  */
+#define CACHE_MISSES      ((volatile unsigned char*)0xC258)  /* 32-bit, +0 first  */
+#define CACHE_END         ((volatile unsigned int*)0xC25C)   /* Range end         */
+
+/* Control register bits */
+#define CACHE_ENABLE      0x01
+#define CACHE_FULL        0x40  /* last PRELOAD did not fit */
+#define CACHE_BUSY        0x80
+
+/* Commands */
+#define CACHE_INVALIDATE_ALL   1
+#define CACHE_INVALIDATE_LINE  2
+#define CACHE_FLUSH            3
+#define CACHE_LOCK             4
+#define CACHE_UNLOCK_ALL       5
+#define CACHE_CLEAR            6
+#define CACHE_PRELOAD          7
+
+/* Wait for the previous command, then start cmd */
+#define cache_command(cmd) \
+    do { while (*CACHE_CONTROL & CACHE_BUSY) ; *CACHE_COMMAND = (cmd); } while (0)
+
+/* Fetch and lock start..end (a routine that must never miss) */
+#define cache_preload(start, end) \
+    do { while (*CACHE_CONTROL & CACHE_BUSY) ; \
+         *CACHE_ADDR = (start); *CACHE_END = (end); \
+         *CACHE_COMMAND = CACHE_PRELOAD; } while (0)
+
+#endif /* CACHE_H */
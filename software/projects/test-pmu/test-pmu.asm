@@ -0,0 +1,81 @@
+; test-pmu: the performance counters ($C220) must move
+;
+; Clears and starts the counters, writes and reads 4 times the first 256
+; bytes of the SDRAM window ($E000, sram_sdram_cached_bridge), freezes
+; the counters and checks that the CPU cycles, cache hits / misses /
+; writes, SDRAM activates and refreshes are not 0.
+; Prints "PMU OK" or "PMU FAIL n" (n = first counter still at 0).
+;
+; ca65 / ld65 (cl65 -t none), loaded and run at $0300
+
+PMU_CTRL  = $C220               ; bit 0 FREEZE, bit 1 CLEAR
+PMU_SEL   = $C221               ; counter number
+PMU_COUNT = $C224               ; 32 bits, reading +0 latches +1 .. +3
+WINDOW    = $E000               ; SDRAM through the cached bridge
+ECHO      = $FFEF               ; wozmon character output
+GETLINE   = $FF1F               ; back to wozmon
+
+        .org $0300
+
+start:  cld
+        lda #$02                ; CLEAR
+        sta PMU_CTRL
+        lda #$00                ; FREEZE = 0: count
+        sta PMU_CTRL
+
+        ldy #4                  ; 4 passes, refreshes in between
+again:  ldx #0
+loop:   txa
+        sta WINDOW,x            ; cache write
+        lda WINDOW,x            ; miss on the first byte of a line, then hits
+        inx
+        bne loop
+        dey
+        bne again
+
+        lda #$01                ; FREEZE
+        sta PMU_CTRL
+
+        ldy #0
+check:  lda counters,y
+        bmi pass_ok             ; $FF: end of the list
+        sta PMU_SEL
+        lda PMU_COUNT           ; latches the counter
+        ora PMU_COUNT+1
+        ora PMU_COUNT+2
+        ora PMU_COUNT+3
+        beq fail
+        iny
+        bne check
+
+pass_ok:
+        ldx #0
+put_ok: lda msg_ok,x
+        beq done
+        jsr ECHO
+        inx
+        bne put_ok
+
+fail:   ldx #0
+put_fail:
+        lda msg_fail,x
+        beq put_num
+        jsr ECHO
+        inx
+        bne put_fail
+put_num:
+        lda counters,y          ; counter number, 0 .. 9
+        ora #'0'
+        jsr ECHO
+
+done:   lda #$0D
+        jsr ECHO
+        jmp GETLINE
+
+; CPU cycles, hits, misses, writes, activates, refreshes
+counters:
+        .byte 0, 2, 3, 4, 5, 7, $FF
+msg_ok:
+        .byte "PMU OK", 0
+msg_fail:
+        .byte "PMU FAIL ", 0
@@ -0,0 +1,162 @@
+; test-preload: a preloaded range never misses ($C250 cache_ctrl)
+;
+; Copies a check routine and a 192 byte table into the first 256 bytes
+; of the SDRAM window ($E000, sram_sdram_cached_bridge), PRELOADs and
+; locks $E000-$E0FF, then calls the routine where it was copied: it
+; CLEARs HITS / MISSES, reads the table 4 times and latches both
+; counters. Its code and data are all in the locked range (the zero
+; page and the stack are not cache accesses), so MISSES must be 0 and
+; HITS not 0. The range must fit (CONTROL bit 6 FULL = 0).
+; Prints "PRELOAD mmmmmmmm hhhhhhhh OK" (MISSES, HITS) or "... FAIL".
+;
+; ca65 / ld65 (cl65 -t none), loaded and run at $0300
+
+CC_CONTROL = $C250              ; R: bit 6 FULL, bit 7 BUSY
+CC_COMMAND = $C251
+CC_ADDR    = $C252              ; range start (16 bits)
+CC_HITS    = $C254              ; 32 bits, reading +0 latches +1 .. +3
+CC_MISSES  = $C258              ; 32 bits, reading +0 latches +1 .. +3
+CC_END     = $C25C              ; range end (16 bits)
+CMD_UNLOCK = 5                  ; UNLOCK ALL
+CMD_CLEAR  = 6
+CMD_PRELOAD = 7
+CC_FULL    = $40
+
+WINDOW    = $E000               ; SDRAM through the cached bridge
+TABLE     = WINDOW + $40        ; read by the check routine
+TABLE_LEN = $C0
+RANGE_END = WINDOW + $FF        ; preloaded and locked: routine + table
+PRBYTE    = $FFDC               ; wozmon hex byte output
+ECHO      = $FFEF               ; wozmon character output
+GETLINE   = $FF1F               ; back to wozmon
+
+HITS      = $F0                 ; latched HITS, 4 bytes
+MISSES    = $F4                 ; latched MISSES, 4 bytes
+
+        .org $0300
+
+start:  cld
+        ldx #0                  ; routine to $E000
+copy:   lda check_src,x
+        sta WINDOW,x
+        inx
+        cpx #CHECK_LEN
+        bne copy
+        ldx #0                  ; table to $E040
+fill:   txa
+        sta TABLE,x
+        inx
+        cpx #TABLE_LEN
+        bne fill
+
+wait1:  lda CC_CONTROL
+        bmi wait1
+        lda #<WINDOW
+        sta CC_ADDR
+        lda #>WINDOW
+        sta CC_ADDR+1
+        lda #<RANGE_END
+        sta CC_END
+        lda #>RANGE_END
+        sta CC_END+1
+        lda #CMD_PRELOAD
+        sta CC_COMMAND
+wait2:  lda CC_CONTROL
+        bmi wait2
+        ldy #1                  ; Y = 1: FAIL
+        and #CC_FULL
+        bne report              ; the range did not fit
+
+        jsr WINDOW              ; check, from the locked lines
+
+        lda MISSES
+        ora MISSES+1
+        ora MISSES+2
+        ora MISSES+3
+        bne report
+        lda HITS
+        ora HITS+1
+        ora HITS+2
+        ora HITS+3
+        beq report
+        ldy #0                  ; Y = 0: OK
+
+report: lda CC_CONTROL          ; give the locked ways back
+        bmi report
+        lda #CMD_UNLOCK
+        sta CC_COMMAND
+
+        ldx #0
+put_hd: lda msg_preload,x
+        beq put_counts
+        jsr ECHO
+        inx
+        bne put_hd
+put_counts:
+        ldx #3
+put_miss:
+        lda MISSES,x
+        jsr PRBYTE
+        dex
+        bpl put_miss
+        lda #' '
+        jsr ECHO
+        ldx #3
+put_hits:
+        lda HITS,x
+        jsr PRBYTE
+        dex
+        bpl put_hits
+        ldx #0
+        cpy #0
+        beq put_ok
+put_fail:
+        lda msg_fail,x
+        beq done
+        jsr ECHO
+        inx
+        bne put_fail
+put_ok: lda msg_ok,x
+        beq done
+        jsr ECHO
+        inx
+        bne put_ok
+
+done:   lda #$0D
+        jsr ECHO
+        jmp GETLINE
+
+; check routine, assembled for WINDOW and copied there (at most $40 bytes)
+check_src:
+        .org WINDOW
+check:  lda #CMD_CLEAR
+        sta CC_COMMAND
+clear:  lda CC_CONTROL
+        bmi clear
+        ldy #4                  ; 4 passes over the table
+again:  ldx #0
+read:   lda TABLE,x
+        inx
+        cpx #TABLE_LEN
+        bne read
+        dey
+        bne again
+        ldx #0                  ; +0 first: latches the counter
+latch:  lda CC_HITS,x
+        sta HITS,x
+        lda CC_MISSES,x
+        sta MISSES,x
+        inx
+        cpx #4
+        bne latch
+        rts
+check_end:
+        .reloc
+CHECK_LEN = check_end - check
+
+msg_preload:
+        .byte "PRELOAD ", 0
+msg_ok:
+        .byte " OK", 0
+msg_fail:
+        .byte " FAIL", 0
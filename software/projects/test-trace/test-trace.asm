@@ -0,0 +1,174 @@
+; test-trace: bus trace ($C230) trigger and dump
+;
+; Arms the trace with an address trigger on $E080 and POST = 8, reads
+; the first 256 bytes of the SDRAM window ($E000, one read of $E080),
+; waits for the trace to stop, then dumps every recorded entry.
+; Checks: TRIGGERED, a single trigger entry, a read of $E080, and POST
+; entries after it.
+; Prints "TRACE aaaa dd ff ee OK" (trigger entry: address, data, flags,
+; ext = bridge state / MRDY / stretch) or "... FAIL".
+;
+; ca65 / ld65 (cl65 -t none), loaded and run at $0300
+
+T_CTRL    = $C230               ; W: bit 0 ARM, bit 1 STOP, bits 3:2 mode
+T_CMPL    = $C231               ; R: bit 0 RUNNING, bit 1 TRIGGERED
+T_CMPH    = $C232
+T_MSKL    = $C233
+T_MSKH    = $C234
+T_POSTL   = $C235
+T_POSTH   = $C236
+T_IDXL    = $C237
+T_IDXH    = $C238
+T_CNTL    = $C239
+T_CNTH    = $C23A
+T_ENTRY   = $C23B               ; address low, high, data, flags, ext (next entry)
+WINDOW    = $E000               ; SDRAM through the cached bridge
+PRBYTE    = $FFDC               ; wozmon hex byte output
+ECHO      = $FFEF               ; wozmon character output
+GETLINE   = $FF1F               ; back to wozmon
+
+POST      = 8                   ; entries recorded after the trigger
+
+LEFT      = $F0                 ; entries left to dump (16 bits)
+TRIGS     = $F2                 ; trigger entries found
+AFTER     = $F3                 ; entries after the last trigger entry
+ENTRY     = $F4                 ; current entry, 5 bytes
+TRIG      = $F9                 ; trigger entry, 5 bytes
+
+        .org $0300
+
+start:  cld
+        lda #$80                ; trigger on address $E080
+        sta T_CMPL
+        lda #$E0
+        sta T_CMPH
+        lda #$FF
+        sta T_MSKL
+        sta T_MSKH
+        lda #POST
+        sta T_POSTL
+        lda #0
+        sta T_POSTH
+        ldx #4
+clear:  sta TRIG,x
+        dex
+        bpl clear
+        lda #$05                ; address trigger, ARM
+        sta T_CTRL
+
+        ldx #0
+loop:   lda WINDOW,x
+        inx
+        bne loop
+
+wait:   lda T_CTRL              ; stopped POST entries after the trigger
+        and #$01
+        bne wait
+        ldy #1                  ; Y = 1: FAIL
+        lda T_CTRL
+        and #$02                ; TRIGGERED
+        beq report
+
+        lda #0                  ; dump from the oldest entry
+        sta T_IDXL
+        sta T_IDXH
+        sta TRIGS
+        sta AFTER
+        lda T_CNTL
+        sta LEFT
+        lda T_CNTH
+        sta LEFT+1
+
+dump:   lda LEFT
+        ora LEFT+1
+        beq dumped
+        ldx #0
+read:   lda T_ENTRY,x           ; the last byte moves INDEX to the next entry
+        sta ENTRY,x
+        inx
+        cpx #5
+        bne read
+        lda ENTRY+3
+        and #$08                ; trigger entry
+        beq other
+        inc TRIGS
+        ldx #4
+copy:   lda ENTRY,x
+        sta TRIG,x
+        dex
+        bpl copy
+        lda #0
+        sta AFTER
+        beq next
+other:  inc AFTER
+next:   lda LEFT
+        bne dec_lo
+        dec LEFT+1
+dec_lo: dec LEFT
+        jmp dump
+
+dumped: lda TRIGS
+        cmp #1
+        bne report
+        lda AFTER
+        cmp #POST
+        bne report
+        lda TRIG
+        cmp #$80
+        bne report
+        lda TRIG+1
+        cmp #$E0
+        bne report
+        lda TRIG+3
+        and #$01                ; read cycle
+        beq report
+        ldy #0                  ; Y = 0: OK
+
+report: ldx #0
+put_hd: lda msg_trace,x
+        beq put_entry
+        jsr ECHO
+        inx
+        bne put_hd
+put_entry:
+        lda TRIG+1              ; address
+        jsr PRBYTE
+        lda TRIG
+        jsr PRBYTE
+        lda #' '
+        jsr ECHO
+        lda TRIG+2              ; data
+        jsr PRBYTE
+        lda #' '
+        jsr ECHO
+        lda TRIG+3              ; flags
+        jsr PRBYTE
+        lda #' '
+        jsr ECHO
+        lda TRIG+4              ; ext
+        jsr PRBYTE
+        ldx #0
+        cpy #0
+        beq put_ok
+put_fail:
+        lda msg_fail,x
+        beq done
+        jsr ECHO
+        inx
+        bne put_fail
+put_ok: lda msg_ok,x
+        beq done
+        jsr ECHO
+        inx
+        bne put_ok
+
+done:   lda #$0D
+        jsr ECHO
+        jmp GETLINE
+
+msg_trace:
+        .byte "TRACE ", 0
+msg_ok:
+        .byte " OK", 0
+msg_fail:
+        .byte " FAIL", 0